@@ -3,6 +3,7 @@
 #include <QFileDialog>
 #include <QDebug>
 #include <QImage>
+#include <QLineEdit>
 
 static QString sDefaultFile     = "C:/WorkSpace/fisheye_distortion/process4.jpg";
 static QString sDefaultBinFile  = "C:/WorkSpace/fisheye_distortion/LDC.bin";
@@ -13,6 +14,8 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
     mCorrection = FisheyeDistortionCorrection::getInstance();
+    mPreview = new CorrectionPreview();
+    mPreview->SetListener(this);
     ui->edit_file_location->setText(sDefaultFile);
     mCorrection->SetFileLocation(sDefaultFile);
     mOriginalImage = mCorrection->GetDefaultImage();
@@ -32,13 +35,27 @@ MainWindow::MainWindow(QWidget *parent) :
         ui->edit_crop_h->setText(QString::number(800));
         ui->edit_h_base->setText(QString::number(200));
         ui->edit_v_base->setText(QString::number(200));
+        mPreview->SetSource(mOriginalImage);
     }
+
+    // every edit of the tuning parameters shows the preview at once.
+    QList<QLineEdit *> edits;
+    edits << ui->edit_opt_center_x << ui->edit_opt_center_y << ui->edit_rotation
+          << ui->edit_crop_x << ui->edit_crop_y << ui->edit_crop_w << ui->edit_crop_h
+          << ui->edit_h_base << ui->edit_v_base;
+    foreach (QLineEdit *edit, edits)
+    {
+        connect(edit, SIGNAL(editingFinished()), this, SLOT(parametersEdited()));
+    }
+    connect(ui->check_bilinear, SIGNAL(toggled(bool)), this, SLOT(parametersEdited()));
     ui->tabWidget->setCurrentIndex(0);
     QWidget::showMaximized();
 }
 
 MainWindow::~MainWindow()
 {
+    // stops the preview thread before the window goes.
+    delete mPreview;
     delete ui;
 }
 
@@ -53,6 +70,7 @@ void MainWindow::openFileOnClicked() {
         ui->edit_file_location->setText(filepath);
         mCorrection->SetFileLocation(filepath);
         mOriginalImage = mCorrection->GetDefaultImage();
+        mPreview->SetSource(mOriginalImage);
     }
     if (false == mOriginalImage.isNull())
     {
@@ -64,19 +82,15 @@ void MainWindow::openFileOnClicked() {
 }
 void MainWindow::generateBinOutput()
 {
-    int width_in    = ui->edit_width->text().toInt();
-    int height_in   = ui->edit_height->text().toInt();
-    mOriginalImage  = mCorrection->GenerateSampleImage(width_in, height_in);
-    processOnClicked();
-
-    QImage final    = ui->label_strecth_image->pixmap()->toImage();
-    mCorrection->GenerateMappingFileBin(sDefaultBinFile, &final, width_in, height_in);
-
+    // the table comes from the model directly, no sample image goes through the views.
+    applyParameters();
+    mCorrection->GenerateMappingFileBin(sDefaultBinFile, mCorrection->GetParameters());
 }
 
 void MainWindow::checkBinData()
 {
     mOriginalImage = mCorrection->GetDefaultImage();
+    mPreview->SetSource(mOriginalImage);
     QImage output = mCorrection->GetImageByBinData(sDefaultBinFile, &mOriginalImage);
     ui->label_original_image->setPixmap(QPixmap::fromImage(mOriginalImage));
     ui->label_strecth_image->setPixmap(QPixmap::fromImage(output));
@@ -84,26 +98,70 @@ void MainWindow::checkBinData()
 }
 
 
+void MainWindow::applyParameters()
+{
+    int width           = ui->edit_width->text().toInt();
+    int height          = ui->edit_height->text().toInt();
+    int opticalCenterW  = ui->edit_opt_center_x->text().toInt();
+    int opticalCenterH  = ui->edit_opt_center_y->text().toInt();
+    int rotation        = ui->edit_rotation->text().toInt();
+    int cropX           = ui->edit_crop_x->text().toInt();
+    int cropY           = ui->edit_crop_y->text().toInt();
+    int cropW           = ui->edit_crop_w->text().toInt();
+    int cropH           = ui->edit_crop_h->text().toInt();
+    int hBase           = ui->edit_h_base->text().toInt();
+    int vBase           = ui->edit_v_base->text().toInt();
+
+    mCorrection->SetPictureSize(width, height);
+    mCorrection->SetOpticalCenterPoint(opticalCenterW, opticalCenterH);
+    mCorrection->SetRotation(rotation);
+    mCorrection->SetCrop(cropX, cropY, cropW, cropH);
+    mCorrection->Set2rdCurveCoff(hBase, vBase);
+    mCorrection->SetInterpolation(ui->check_bilinear->isChecked() ? RemapTable::Bilinear
+                                                                  : RemapTable::NearestNeighbour);
+}
+
+void MainWindow::parametersEdited()
+{
+    if (mOriginalImage.isNull())
+    {
+        return;
+    }
+    applyParameters();
+    QImage preview = mPreview->Update(mCorrection->GetParameters());
+    if (false == preview.isNull())
+    {
+        // scaled back up, so the label keeps its size until the full resolution output comes.
+        const int divisor = mPreview->Divisor();
+        ui->label_strecth_image->setPixmap(QPixmap::fromImage(
+            preview.scaled(preview.width() * divisor, preview.height() * divisor)));
+        ui->statusBar->showMessage(tr("preview, the full resolution is in progress"));
+    }
+}
+
+void MainWindow::FullResolutionReady()
+{
+    // the preview thread, the image is taken on the GUI thread.
+    QMetaObject::invokeMethod(this, "showFullResolution", Qt::QueuedConnection);
+}
+
+void MainWindow::showFullResolution()
+{
+    QImage strecth_image;
+    if (mPreview->TakeFullResolution(&strecth_image))
+    {
+        ui->label_strecth_image->setPixmap(QPixmap::fromImage(strecth_image));
+        ui->statusBar->clearMessage();
+    }
+}
+
 void MainWindow::processOnClicked() {
     if (mCorrection != NULL)
     {
-        int width           = ui->edit_width->text().toInt();
-        int height          = ui->edit_height->text().toInt();
-        int opticalCenterW  = ui->edit_opt_center_x->text().toInt();
-        int opticalCenterH  = ui->edit_opt_center_y->text().toInt();
-        int rotation        = ui->edit_rotation->text().toInt();
-        int cropX           = ui->edit_crop_x->text().toInt();
-        int cropY           = ui->edit_crop_y->text().toInt();
-        int cropW           = ui->edit_crop_w->text().toInt();
-        int cropH           = ui->edit_crop_h->text().toInt();
-        int hBase           = ui->edit_h_base->text().toInt();
-        int vBase           = ui->edit_v_base->text().toInt();
-
-        mCorrection->SetPictureSize(width, height);
-        mCorrection->SetOpticalCenterPoint(opticalCenterW, opticalCenterH);
-        mCorrection->SetRotation(rotation);
-        mCorrection->SetCrop(cropX, cropY, cropW, cropH);
-        mCorrection->Set2rdCurveCoff(hBase, vBase);
+        // the views below are all full resolution, the background one is not needed.
+        mPreview->Cancel();
+        ui->statusBar->clearMessage();
+        applyParameters();
         QImage h_image;
         QImage v_image;
         QImage smooth_image;
@@ -3,11 +3,12 @@
 
 #include <QMainWindow>
 #include "FisheyeDistortionCorrection.h"
+#include "CorrectionPreview.h"
 namespace Ui {
 class MainWindow;
 }
 
-class MainWindow : public QMainWindow
+class MainWindow : public QMainWindow, public CorrectionPreview::Listener
 {
     Q_OBJECT
 
@@ -19,11 +20,20 @@ private:
     Ui::MainWindow              *ui;
     FisheyeDistortionCorrection *mCorrection;
     QImage                      mOriginalImage;
+    // the quarter resolution correction of every edit, the full one is computed in the background.
+    CorrectionPreview           *mPreview;
+
+    // the correction parameters of the edits.
+    void applyParameters();
+    void FullResolutionReady();
 public Q_SLOTS:
     void openFileOnClicked();
     void processOnClicked();
     void generateBinOutput();
     void checkBinData();
+    void parametersEdited();
+private Q_SLOTS:
+    void showFullResolution();
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,482 @@
+#include "CameraRegistry.h"
+#include "CorrectionContext.h"
+#include "CorrectionSession.h"
+#include "DebugOutput.h"
+#include "FisheyeDistortionCorrection.h"
+#include "Nv12Frame.h"
+#include "RemapKernel.h"
+#include "RemapTableCache.h"
+#include "RemapTableFile.h"
+#include "SurroundView.h"
+#include "WorkerPool.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QStringList>
+#include <QVector>
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+/**
+ * the inputs of one picture size, shared by all the cases.
+ * input is GenerateSampleImage(), final is its Process3 output (what the
+ * GUI hands to GenerateMappingFileBin()), imagePath is the input saved for
+ * Process() which reads the file location, binPath and bin2Path are the
+ * version 1 and version 2 mapping files, mapped is bin2Path mapped once.
+ * session is opened with the Process3 parameters of the size, surround
+ * with kSurroundCameras cameras of these parameters, timestamp is the
+ * next timestamp of surround. nv12 is input as a NV12 frame and
+ * nv12Context holds the tables of both formats. gray is the Process3
+ * table converted for grayInput, input as Format_Grayscale8.
+ **/
+typedef struct BenchmarkFrame
+{
+    FisheyeDistortionCorrection    *correction;
+    CorrectionSession              *session;
+    SurroundView                   *surround;
+    qint64                          timestamp;
+    QImage                          input;
+    QImage                          final;
+    QString                         imagePath;
+    QString                         binPath;
+    QString                         bin2Path;
+    RemapTable                      mapped;
+    Nv12Frame                       nv12;
+    CorrectionContextPtr            nv12Context;
+    RemapTable                      gray;
+    QImage                          grayInput;
+} BenchmarkFrame_t;
+
+typedef void (*CaseFunc)(BenchmarkFrame_t &frame);
+
+/**
+ * the cases only ask for the images the method cannot run without,
+ * the debug views which can be NULL are not generated.
+ **/
+static void RunProcess(BenchmarkFrame_t &frame)
+{
+    QImage original, h, v, smooth, strecth;
+    frame.correction->Process(&original, &h, &v, &smooth, &strecth);
+}
+
+static void RunProcess1(BenchmarkFrame_t &frame)
+{
+    QImage smooth, strecth;
+    frame.correction->Process1(&frame.input, NULL, NULL, NULL, &smooth, &strecth);
+}
+
+static void RunProcess2(BenchmarkFrame_t &frame)
+{
+    QImage smooth, strecth;
+    frame.correction->Process2(&frame.input, NULL, NULL, NULL, &smooth, &strecth);
+}
+
+static void RunProcess3(BenchmarkFrame_t &frame)
+{
+    QImage strecth;
+    frame.correction->Process3(&frame.input, NULL, NULL, NULL, NULL, &strecth);
+}
+
+static void RunSession(BenchmarkFrame_t &frame)
+{
+    CorrectionFrame_t corrected;
+    frame.session->PushFrame(frame.input);
+    if (frame.session->TakeFrame(&corrected))
+    {
+        frame.session->ReleaseFrame(&corrected);
+    }
+}
+
+static const int kSurroundCameras = 4;
+
+// one timestamp of every camera, the frame count is kSurroundCameras times the iterations.
+static void RunSurroundView(BenchmarkFrame_t &frame)
+{
+    SurroundFrameSet_t set;
+    for (int n = 0; n < kSurroundCameras; ++n)
+    {
+        frame.surround->PushFrame(n, frame.timestamp, frame.input);
+    }
+    frame.timestamp++;
+    frame.surround->TakeFrameSet(&set);
+}
+
+static void RunApplyNv12(BenchmarkFrame_t &frame)
+{
+    Nv12Frame output;
+    frame.nv12Context->ApplyNv12(&frame.nv12, &output);
+}
+
+// the same NV12 frame through the RGB888 table, the two conversions included.
+static void RunNv12ViaRgb(BenchmarkFrame_t &frame)
+{
+    QImage rgb = frame.nv12.ToImage();
+    QImage output;
+    frame.nv12Context->Apply(&rgb, &output);
+    Nv12Frame::FromImage(output);
+}
+
+static void RunApplyGray8(BenchmarkFrame_t &frame)
+{
+    QImage output;
+    frame.gray.Apply(&frame.grayInput, &output);
+}
+
+static void RunProcess4(BenchmarkFrame_t &frame)
+{
+    QImage output;
+    frame.correction->Process4(&frame.input, &output);
+}
+
+static void RunProcess5(BenchmarkFrame_t &frame)
+{
+    QImage output;
+    frame.correction->Process5(&frame.input, &output);
+}
+
+static void RunGenerateMappingFileBin(BenchmarkFrame_t &frame)
+{
+    frame.correction->GenerateMappingFileBin(frame.binPath, &frame.final,
+                                             frame.input.width(), frame.input.height());
+}
+
+// the table of the parameters, without the sample image round trip.
+static void RunMappingFileBinDirect(BenchmarkFrame_t &frame)
+{
+    frame.correction->GenerateMappingFileBin(frame.binPath, frame.correction->GetParameters());
+}
+
+static void RunGetImageByBinData(BenchmarkFrame_t &frame)
+{
+    frame.correction->GetImageByBinData(frame.binPath, &frame.input);
+}
+
+static void RunGenerateMappingFileBin2(BenchmarkFrame_t &frame)
+{
+    frame.correction->GenerateMappingFileBin(frame.bin2Path, &frame.final,
+                                             frame.input.width(), frame.input.height(), 2);
+}
+
+static void RunGetImageByBinData2(BenchmarkFrame_t &frame)
+{
+    frame.correction->GetImageByBinData(frame.bin2Path, &frame.input);
+}
+
+// the startup of a stream, MapTrustedBin2 skips the checks of a file the process wrote.
+static void RunMapMappingFileBin2(BenchmarkFrame_t &frame)
+{
+    RemapTable table;
+    frame.correction->MapMappingFileBin(frame.bin2Path, frame.input.width(), frame.input.height(), &table);
+}
+
+static void RunMapTrustedBin2(BenchmarkFrame_t &frame)
+{
+    RemapTable table;
+    frame.correction->MapMappingFileBin(frame.bin2Path, frame.input.width(), frame.input.height(), &table, 0);
+}
+
+// the table of a parameter set seen before, from the memory and from the directory.
+static void RunGenerateCorrectionTable3(BenchmarkFrame_t &frame)
+{
+    RemapTable table;
+    frame.correction->GenerateCorrectionTable3(frame.correction->GetParameters(), &table);
+}
+
+static void RunTableCacheMemory(BenchmarkFrame_t &frame)
+{
+    RemapTable table;
+    RemapTableCache::getInstance()->CorrectionTable3(frame.correction->GetParameters(), &table);
+}
+
+static void RunTableCacheDisk(BenchmarkFrame_t &frame)
+{
+    RemapTable table;
+    RemapTableCache::getInstance()->ClearMemory();
+    RemapTableCache::getInstance()->CorrectionTable3(frame.correction->GetParameters(), &table);
+}
+
+static void RunApplyMappedBin2(BenchmarkFrame_t &frame)
+{
+    QImage output;
+    frame.mapped.Apply(&frame.input, &output);
+}
+
+typedef struct BenchmarkCase
+{
+    const char     *name;
+    CaseFunc        run;
+} BenchmarkCase_t;
+
+static const BenchmarkCase_t kCases[] =
+{
+    { "Process",                RunProcess },
+    { "Process1",               RunProcess1 },
+    { "Process2",               RunProcess2 },
+    { "Process3",               RunProcess3 },
+    { "CorrectionSession",      RunSession },
+    { "SurroundView",           RunSurroundView },
+    { "ApplyNv12",              RunApplyNv12 },
+    { "Nv12ViaRgb",             RunNv12ViaRgb },
+    { "ApplyGray8",             RunApplyGray8 },
+    { "Process4",               RunProcess4 },
+    { "Process5",               RunProcess5 },
+    { "GenerateMappingFileBin", RunGenerateMappingFileBin },
+    { "MappingFileBinDirect",   RunMappingFileBinDirect },
+    { "GetImageByBinData",      RunGetImageByBinData },
+    { "GenerateMappingFileBin2", RunGenerateMappingFileBin2 },
+    { "GetImageByBinData2",     RunGetImageByBinData2 },
+    { "MapMappingFileBin2",     RunMapMappingFileBin2 },
+    { "MapTrustedBin2",         RunMapTrustedBin2 },
+    { "ApplyMappedBin2",        RunApplyMappedBin2 },
+    { "GenerateTable3",         RunGenerateCorrectionTable3 },
+    { "TableCacheMemory",       RunTableCacheMemory },
+    { "TableCacheDisk",         RunTableCacheDisk },
+};
+
+typedef struct BenchmarkSize
+{
+    const char     *name;
+    int             width;
+    int             height;
+} BenchmarkSize_t;
+
+static const BenchmarkSize_t kSizes[] =
+{
+    { "720p",   1280,   720 },
+    { "1080p",  1920,   1080 },
+    { "4k",     3840,   2160 },
+};
+
+/**
+ * ResetPeakRss() starts a new peak for the next case (linux 4.0 and later),
+ * otherwise PeakRssKb() is the peak of the whole process so far.
+ **/
+static bool ResetPeakRss()
+{
+#ifdef Q_OS_LINUX
+    FILE *file = fopen("/proc/self/clear_refs", "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+    const bool ok = (fputs("5", file) >= 0);
+    return (fclose(file) == 0) && ok;
+#else
+    return false;
+#endif
+}
+
+static long PeakRssKb()
+{
+#ifdef Q_OS_LINUX
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file != NULL)
+    {
+        char line[256];
+        long peak = -1;
+        while (fgets(line, sizeof(line), file) != NULL)
+        {
+            if (strncmp(line, "VmHWM:", 6) == 0)
+            {
+                peak = atol(line + 6);
+                break;
+            }
+        }
+        fclose(file);
+        if (peak >= 0)
+        {
+            return peak;
+        }
+    }
+#endif
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef Q_OS_MAC
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return -1;
+}
+
+/**
+ * the nearest rank percentile of the sorted latencies.
+ **/
+static qint64 Percentile(const QVector<qint64> &sorted, int percent)
+{
+    const int rank = (sorted.size() * percent + 99) / 100;
+    return sorted[qBound(0, rank - 1, sorted.size() - 1)];
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure the latency, the throughput and the peak memory of the corrections.");
+    parser.addHelpOption();
+    QCommandLineOption iterationsOption("iterations", "measured runs per case.", "count", "20");
+    QCommandLineOption warmupOption("warmup", "runs before the measure, they build the tables.", "count", "2");
+    QCommandLineOption sizesOption("sizes", "comma separated sizes: 720p, 1080p, 4k.", "list", "720p,1080p,4k");
+    QCommandLineOption casesOption("cases", "comma separated cases, all of them by default.", "list");
+    QCommandLineOption threadsOption("threads", "worker pool threads, 0 for one per cpu.", "count", "0");
+    QCommandLineOption csvOption("csv", "print comma separated values for the regression tracking.");
+    QCommandLineOption verboseOption("verbose", "keep the debug messages of the corrections.");
+    parser.addOption(iterationsOption);
+    parser.addOption(warmupOption);
+    parser.addOption(sizesOption);
+    parser.addOption(casesOption);
+    parser.addOption(threadsOption);
+    parser.addOption(csvOption);
+    parser.addOption(verboseOption);
+    parser.process(app);
+
+    SetQuietDebugOutput(!parser.isSet(verboseOption));
+    const int iterations    = qMax(1, parser.value(iterationsOption).toInt());
+    const int warmup        = qMax(0, parser.value(warmupOption).toInt());
+    const int threads       = parser.value(threadsOption).toInt();
+    const bool csv          = parser.isSet(csvOption);
+    const QStringList sizeNames = parser.value(sizesOption).split(',');
+    const QStringList caseNames = parser.value(casesOption).split(',');
+    if (threads > 0)
+    {
+        WorkerPool::getInstance()->SetThreadCount(threads);
+    }
+
+    QTemporaryDir directory;
+    if (!directory.isValid())
+    {
+        fprintf(stderr, "can not create the temporary directory.\n");
+        return 1;
+    }
+    // the cached tables of an earlier run would hide the generation.
+    RemapTableCache::getInstance()->SetDirectory(directory.filePath("remap_tables"));
+
+    QTextStream out(stdout);
+    if (csv)
+    {
+        out << "size,case,iterations,median_ms,p99_ms,fps,mpixel_per_s,peak_rss_kb\n";
+    }
+    else
+    {
+        out << "kernel: " << RemapKernel::IsaName(RemapKernel::ActiveIsa())
+            << ", threads: " << WorkerPool::getInstance()->ThreadCount()
+            << ", iterations: " << iterations << ", warmup: " << warmup << "\n";
+        out << "size   case                    median ms  p99 ms     fps        Mpixel/s   peak RSS MB\n";
+    }
+
+    FisheyeDistortionCorrection *correction = FisheyeDistortionCorrection::getInstance();
+    for (unsigned int s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); ++s)
+    {
+        const BenchmarkSize_t &size = kSizes[s];
+        if (!sizeNames.contains(QString(size.name)))
+        {
+            continue;
+        }
+
+        BenchmarkFrame_t frame;
+        CorrectionSession session;
+        SurroundView surround;
+        frame.correction    = correction;
+        frame.session       = &session;
+        frame.surround      = &surround;
+        frame.timestamp     = 0;
+        frame.imagePath     = directory.filePath(QString("sample_%1.bmp").arg(size.name));
+        frame.binPath       = directory.filePath(QString("mapping_%1.bin").arg(size.name));
+        frame.bin2Path      = directory.filePath(QString("mapping2_%1.bin").arg(size.name));
+        correction->SetPictureSize(size.width, size.height);
+        correction->SetFileLocation(frame.imagePath);
+        frame.input = correction->GenerateSampleImage(size.width, size.height);
+        if (!frame.input.save(frame.imagePath))
+        {
+            fprintf(stderr, "can not save %s, Process reads nothing.\n", qPrintable(frame.imagePath));
+        }
+        correction->Process3(&frame.input, NULL, NULL, NULL, NULL, &frame.final);
+        session.Open(correction->GetParameters());
+        QList<int> cameras;
+        for (int n = 0; n < kSurroundCameras; ++n)
+        {
+            // the cameras share one table, like the identical lenses of a vehicle.
+            CameraRegistry::getInstance()->Register(n, correction->GetParameters());
+            cameras.append(n);
+        }
+        surround.Open(cameras);
+        frame.nv12          = Nv12Frame::FromImage(frame.input);
+        frame.nv12Context   = CorrectionContext::Create(correction->GetParameters(),
+                                                        CorrectionContext::RgbFrames | CorrectionContext::Nv12Frames);
+        RemapTableCache::getInstance()->CorrectionTable3(correction->GetParameters(), &frame.gray);
+        // TableCacheDisk reads the file of this table.
+        RemapTableCache::getInstance()->WaitForWrites();
+        frame.gray.ConvertFormat(QImage::Format_Grayscale8);
+        frame.grayInput     = frame.input.convertToFormat(QImage::Format_Grayscale8);
+        RunGenerateMappingFileBin(frame);
+        RunGenerateMappingFileBin2(frame);
+        correction->MapMappingFileBin(frame.bin2Path, size.width, size.height, &frame.mapped);
+
+        for (unsigned int c = 0; c < sizeof(kCases) / sizeof(kCases[0]); ++c)
+        {
+            const BenchmarkCase_t &benchmarkCase = kCases[c];
+            if (parser.isSet(casesOption) && !caseNames.contains(QString(benchmarkCase.name)))
+            {
+                continue;
+            }
+
+            for (int n = 0; n < warmup; ++n)
+            {
+                benchmarkCase.run(frame);
+            }
+            ResetPeakRss();
+
+            QVector<qint64> latencies(iterations);
+            QElapsedTimer timer;
+            qint64 total = 0;
+            for (int n = 0; n < iterations; ++n)
+            {
+                timer.start();
+                benchmarkCase.run(frame);
+                latencies[n]    = timer.nsecsElapsed();
+                total          += latencies[n];
+            }
+            const long peakRss = PeakRssKb();
+            std::sort(latencies.begin(), latencies.end());
+
+            const double median = Percentile(latencies, 50) / 1e6;
+            const double p99    = Percentile(latencies, 99) / 1e6;
+            const double fps    = (total > 0) ? iterations * 1e9 / total : 0;
+            const double mpixel = fps * size.width * size.height / 1e6;
+            if (csv)
+            {
+                out << size.name << "," << benchmarkCase.name << "," << iterations << ","
+                    << QString::number(median, 'f', 3) << "," << QString::number(p99, 'f', 3) << ","
+                    << QString::number(fps, 'f', 2) << "," << QString::number(mpixel, 'f', 2) << ","
+                    << peakRss << "\n";
+            }
+            else
+            {
+                out << QString(size.name).leftJustified(7)
+                    << QString(benchmarkCase.name).leftJustified(24)
+                    << QString::number(median, 'f', 3).leftJustified(11)
+                    << QString::number(p99, 'f', 3).leftJustified(11)
+                    << QString::number(fps, 'f', 2).leftJustified(11)
+                    << QString::number(mpixel, 'f', 2).leftJustified(11)
+                    << ((peakRss < 0) ? QString("n/a") : QString::number(peakRss / 1024.0, 'f', 1)) << "\n";
+            }
+            out.flush();
+        }
+    }
+    // the writes end before the temporary directory is removed.
+    RemapTableCache::getInstance()->WaitForWrites();
+    return 0;
+}
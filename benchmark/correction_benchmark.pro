@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# correction benchmark: the latency, the throughput and the peak RSS of
+# Process, Process1-5, the CorrectionSession and the mapping file, without
+# the GUI.
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+TARGET = correction_benchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../correction/correction.pri)
+
+SOURCES += \
+    correction_benchmark.cpp
@@ -0,0 +1,474 @@
+#include "CircleKernel.h"
+#include "FisheyeDistortionCorrection.h"
+#include "RemapTable.h"
+#include "RemapSpanTable.h"
+#include "RemapSymmetricTable.h"
+#include "RemapKernel.h"
+#include "WorkerPool.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+
+#include <cmath>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#endif
+
+/**
+ * PerfCounter : one hardware counter of the calling thread (perf_event_open).
+ * IsValid() is false when the kernel or the cpu does not expose the event.
+ **/
+class PerfCounter
+{
+public:
+    PerfCounter() : mFd(-1) {}
+    ~PerfCounter()
+    {
+#ifdef Q_OS_LINUX
+        if (mFd >= 0) close(mFd);
+#endif
+    }
+
+    bool Open(quint32 type, quint64 config)
+    {
+#ifdef Q_OS_LINUX
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = type;
+        attr.config         = config;
+        attr.disabled       = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        mFd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        Q_UNUSED(type);
+        Q_UNUSED(config);
+#endif
+        return IsValid();
+    }
+
+    bool IsValid() const { return mFd >= 0; }
+
+    void Start()
+    {
+#ifdef Q_OS_LINUX
+        if (!IsValid()) return;
+        ioctl(mFd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    quint64 Stop()
+    {
+        quint64 value = 0;
+#ifdef Q_OS_LINUX
+        if (!IsValid()) return 0;
+        ioctl(mFd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(mFd, &value, sizeof(value)) != sizeof(value))
+        {
+            value = 0;
+        }
+#endif
+        return value;
+    }
+
+private:
+    int mFd;
+};
+
+#ifdef Q_OS_LINUX
+static quint64 CacheMissConfig(quint64 cache)
+{
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+#endif
+
+static const char *OrderName(RemapTable::TraversalOrder order)
+{
+    switch (order)
+    {
+    case RemapTable::SourceSortedOrder: return "source-sorted";
+    case RemapTable::MortonOrder:       return "morton";
+    default:                            return "row-major";
+    }
+}
+
+static QString Count(const PerfCounter &counter, quint64 total, int iterations)
+{
+    if (!counter.IsValid()) return QString("n/a");
+    return QString::number(total / iterations);
+}
+
+/**
+ * the counters of the calling thread while the table remaps the frame.
+ **/
+class Measurement
+{
+public:
+    Measurement(PerfCounter *l1, PerfCounter *l2, PerfCounter *llc, int iterations)
+        : mL1(l1),
+          mL2(l2),
+          mLlc(llc),
+          mIterations(iterations)
+    {
+    }
+
+    template<typename Table>
+    void Run(const Table &table, const QImage &input, QImage *output, const QString &name, QTextStream &out)
+    {
+        table.Apply(&input, output);
+
+        QElapsedTimer timer;
+        timer.start();
+        mL1->Start();
+        mL2->Start();
+        mLlc->Start();
+        for (int n = 0; n < mIterations; ++n)
+        {
+            table.Apply(&input, output);
+        }
+        const quint64 l1    = mL1->Stop();
+        const quint64 l2    = mL2->Stop();
+        const quint64 llc   = mLlc->Stop();
+        const double ms     = timer.nsecsElapsed() / 1e6 / mIterations;
+
+        out << QString("%1x%2").arg(input.width()).arg(input.height()).leftJustified(11)
+            << name.leftJustified(15)
+            << QString::number(ms, 'f', 3).leftJustified(11)
+            << Count(*mL1, l1, mIterations).leftJustified(17)
+            << Count(*mL2, l2, mIterations).leftJustified(17)
+            << Count(*mLlc, llc, mIterations) << "\n";
+    }
+
+private:
+    PerfCounter    *mL1;
+    PerfCounter    *mL2;
+    PerfCounter    *mLlc;
+    int             mIterations;
+};
+
+/**
+ * the rows of output which differ from the ones of expected, only the
+ * pixels are compared, not the scanline padding.
+ **/
+static int DifferentRows(const QImage &expected, const QImage &output)
+{
+    if (expected.size() != output.size() || expected.format() != output.format())
+    {
+        return qMax(1, expected.height());
+    }
+    const int bytes = expected.width() * expected.depth() / 8;
+    int rows        = 0;
+    for (int y = 0; y < expected.height(); ++y)
+    {
+        if (memcmp(expected.constScanLine(y), output.constScanLine(y), bytes) != 0)
+        {
+            ++rows;
+        }
+    }
+    return rows;
+}
+
+/**
+ * Verifier : the SIMD kernels against the scalar ones, every kernel the
+ * cpu supports is selected with RemapKernel::SetIsa() and its output is
+ * compared byte by byte.
+ **/
+class Verifier
+{
+public:
+    explicit Verifier(QTextStream &out)
+        : mOut(out),
+          mFailures(0)
+    {
+    }
+
+    int Failures() const { return mFailures; }
+
+    /*
+     * Apply() : table (RemapTable, RemapSpanTable or RemapSymmetricTable)
+     * with every kernel, against expected, the scalar RemapTable output.
+     **/
+    template<typename Table>
+    void Apply(const Table &table, const QImage &input, const QImage &expected, const QString &name)
+    {
+        for (int isa = RemapKernel::SSE41; isa <= RemapKernel::SupportedIsa(); ++isa)
+        {
+            RemapKernel::SetIsa(static_cast<RemapKernel::Isa>(isa));
+            QImage output;
+            table.Apply(&input, &output);
+            Report(name, static_cast<RemapKernel::Isa>(isa), DifferentRows(expected, output), "rows");
+        }
+        RemapKernel::SetIsa(RemapKernel::Scalar);
+    }
+
+    /*
+     * Circle() : ArcLengths() and Heights() of every circle row of params
+     * against the scalar kernels, the floats must be the same bits.
+     **/
+    void Circle(const CorrectionParameters_t &params, const QString &name)
+    {
+        const int width             = params.width;
+        const int height            = params.height;
+        const int opticalCenterW    = (params.optical_center_x == 0) ? ((width -1) / 2) : params.optical_center_x;
+        const int opticalCenterH    = (params.optical_center_y == 0) ? ((height -1) / 2) : params.optical_center_y;
+        const int verticalBase      = (params.vertical_base == 0) ? height / 4: params.vertical_base;
+
+        // the columns and the sub-pixel points between them, as GenerateHorizontalMap3() passes them.
+        QVector<float> xs(width * 4);
+        for (int n = 0; n < xs.size(); ++n)
+        {
+            xs[n] = qMax(0.0f, n / 4.0f - 0.5f);
+        }
+        QVector<float> expected(xs.size());
+        QVector<float> output(xs.size());
+        for (int isa = RemapKernel::SSE41; isa <= RemapKernel::SupportedIsa(); ++isa)
+        {
+            const CircleKernel::ArcLengthsFunc arcLengths = CircleKernel::ArcLengths(static_cast<RemapKernel::Isa>(isa));
+            const CircleKernel::HeightsFunc heights       = CircleKernel::Heights(static_cast<RemapKernel::Isa>(isa));
+            int arcRows     = 0;
+            int heightRows  = 0;
+            for (int h = 0; h <= opticalCenterH; ++h)
+            {
+                // the circles of GenerateHorizontalMap3().
+                double coffH = h * (opticalCenterH - verticalBase + 1) / static_cast<double>(opticalCenterH) + verticalBase;
+                if (std::abs(h - coffH) < 1)
+                {
+                    h = h + 1;
+                }
+                const double a = opticalCenterW;
+                const double b = (h + coffH - a * a / static_cast<double>(h - coffH)) / 2;
+                const double r = std::abs(h - b);
+                CircleRow_t circle;
+                circle.a        = opticalCenterW;
+                circle.r        = r;
+                circle.rMinusA  = r - opticalCenterW;
+                circle.bMinusR  = b - r;
+
+                CircleKernel::ArcLengthsScalar(expected.data(), opticalCenterW, circle);
+                arcLengths(output.data(), opticalCenterW, circle);
+                if (memcmp(expected.constData(), output.constData(), opticalCenterW * sizeof(float)) != 0)
+                {
+                    ++arcRows;
+                }
+                CircleKernel::HeightsScalar(expected.data(), xs.constData(), xs.size(), circle);
+                heights(output.data(), xs.constData(), xs.size(), circle);
+                if (memcmp(expected.constData(), output.constData(), xs.size() * sizeof(float)) != 0)
+                {
+                    ++heightRows;
+                }
+            }
+            Report(name + " arc", static_cast<RemapKernel::Isa>(isa), arcRows, "circles");
+            Report(name + " height", static_cast<RemapKernel::Isa>(isa), heightRows, "circles");
+        }
+    }
+
+private:
+    void Report(const QString &name, RemapKernel::Isa isa, int differences, const char *unit)
+    {
+        mOut << name.leftJustified(30) << QString(RemapKernel::IsaName(isa)).leftJustified(8)
+             << ((differences == 0) ? QString("ok") : QString("%1 %2 differ").arg(differences).arg(unit)) << "\n";
+        if (differences != 0)
+        {
+            ++mFailures;
+        }
+    }
+
+    QTextStream    &mOut;
+    int             mFailures;
+};
+
+/**
+ * the verify mode, the 1080p and 4k tables (nearest and bilinear) in the
+ * pixel formats of the kernels, then the span, the symmetric and the
+ * circle kernels. return the number of kernels which differ.
+ **/
+static int Verify(QTextStream &out)
+{
+    const QSize sizes[] = { QSize(1920, 1080), QSize(3840, 2160) };
+    const RemapTable::Interpolation modes[] = { RemapTable::NearestNeighbour, RemapTable::Bilinear };
+    const QImage::Format formats[] =
+    {
+        QImage::Format_RGB888, QImage::Format_Grayscale8, QImage::Format_RGBA8888,
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+        QImage::Format_Grayscale16
+#endif
+    };
+    const RemapKernel::Isa active = RemapKernel::ActiveIsa();
+    out << "supported kernel: " << RemapKernel::IsaName(RemapKernel::SupportedIsa()) << "\n";
+
+    Verifier verifier(out);
+    FisheyeDistortionCorrection *correction = FisheyeDistortionCorrection::getInstance();
+    for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        const int width     = sizes[s].width();
+        const int height    = sizes[s].height();
+        correction->SetPictureSize(width, height);
+        CorrectionParameters_t params = correction->GetParameters();
+        const QString size  = QString("%1x%2").arg(width).arg(height);
+
+        QImage input(width, height, QImage::Format_RGB888);
+        for (int y = 0; y < height; ++y)
+        {
+            uchar *line = input.scanLine(y);
+            for (int x = 0; x < width * 3; ++x)
+            {
+                line[x] = static_cast<uchar>(x * 7 + y * 13);
+            }
+        }
+
+        for (unsigned int m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+        {
+            params.interpolation = modes[m];
+            RemapTable table;
+            correction->GenerateCorrectionTable3(params, &table);
+            const QString mode = (modes[m] == RemapTable::Bilinear) ? "bilinear" : "nearest";
+
+            QImage expected;
+            for (unsigned int f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+            {
+                RemapTable converted = table;
+                converted.ConvertFormat(formats[f]);
+                const QImage frame = input.convertToFormat(formats[f]);
+                RemapKernel::SetIsa(RemapKernel::Scalar);
+                QImage scalar;
+                converted.Apply(&frame, &scalar);
+                verifier.Apply(converted, frame, scalar,
+                               QString("%1 %2 %3 bytes").arg(size).arg(mode).arg(RemapTable::PixelBytes(formats[f])));
+                if (formats[f] == QImage::Format_RGB888)
+                {
+                    expected = scalar;
+                }
+            }
+            if (modes[m] != RemapTable::NearestNeighbour)
+            {
+                continue;
+            }
+
+            RemapSpanTable span;
+            if (span.Build(table))
+            {
+                verifier.Apply(span, input, expected, size + " span");
+            }
+            RemapSymmetricTable symmetric;
+            if (symmetric.Build(table))
+            {
+                verifier.Apply(symmetric, input, expected, size + " symmetric");
+            }
+        }
+        verifier.Circle(params, size);
+    }
+    RemapKernel::SetIsa(active);
+    return verifier.Failures();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compare the cache misses of the remap traversal orders and the symmetric table.");
+    parser.addHelpOption();
+    QCommandLineOption iterationsOption("iterations", "remap passes per measurement.", "count", "20");
+    QCommandLineOption threadsOption("threads", "worker pool threads, the counters only see the calling thread.",
+                                     "count", "1");
+    QCommandLineOption l2Option("l2-event", "raw perf event of the L2 misses (hex), e.g. 0x3f24 on Intel.", "event");
+    QCommandLineOption verifyOption("verify", "compare the output of every SIMD kernel with the scalar one, "
+                                    "the exit code is 1 when one differs.");
+    parser.addOption(iterationsOption);
+    parser.addOption(threadsOption);
+    parser.addOption(l2Option);
+    parser.addOption(verifyOption);
+    parser.process(app);
+
+    const int iterations    = qMax(1, parser.value(iterationsOption).toInt());
+    const int threads       = qMax(1, parser.value(threadsOption).toInt());
+    WorkerPool::getInstance()->SetThreadCount(threads);
+
+    if (parser.isSet(verifyOption))
+    {
+        QTextStream out(stdout);
+        const int failures = Verify(out);
+        out << ((failures == 0) ? QString("all kernels match the scalar ones\n")
+                                : QString("%1 kernels differ from the scalar ones\n").arg(failures));
+        out.flush();
+        return (failures == 0) ? 0 : 1;
+    }
+
+    PerfCounter l1Misses;
+    PerfCounter l2Misses;
+    PerfCounter llcMisses;
+#ifdef Q_OS_LINUX
+    l1Misses.Open(PERF_TYPE_HW_CACHE, CacheMissConfig(PERF_COUNT_HW_CACHE_L1D));
+    llcMisses.Open(PERF_TYPE_HW_CACHE, CacheMissConfig(PERF_COUNT_HW_CACHE_LL));
+    if (parser.isSet(l2Option))
+    {
+        bool ok = false;
+        const quint64 event = parser.value(l2Option).toULongLong(&ok, 16);
+        if (ok) l2Misses.Open(PERF_TYPE_RAW, event);
+    }
+#endif
+
+    QTextStream out(stdout);
+    out << "kernel: " << RemapKernel::IsaName(RemapKernel::ActiveIsa()) << ", threads: " << threads
+        << ", iterations: " << iterations << "\n";
+    if (!l1Misses.IsValid() && !llcMisses.IsValid())
+    {
+        out << "perf counters are not available, only the time is measured.\n";
+    }
+    out << "size       order          ms/frame   L1D miss/frame   L2 miss/frame    LLC miss/frame\n";
+
+    const QSize sizes[] = { QSize(1920, 1080), QSize(3840, 2160) };
+    const RemapTable::TraversalOrder orders[] =
+    {
+        RemapTable::RowMajorOrder, RemapTable::SourceSortedOrder, RemapTable::MortonOrder
+    };
+    FisheyeDistortionCorrection *correction = FisheyeDistortionCorrection::getInstance();
+    for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        const int width     = sizes[s].width();
+        const int height    = sizes[s].height();
+        correction->SetPictureSize(width, height);
+        const CorrectionParameters_t params = correction->GetParameters();
+
+        QVector<QPoint> mappedX;
+        const int mapWidth = correction->GenerateHorizontalMap3(params, &mappedX);
+        RemapTable table;
+        correction->GenerateCorrectionTable3(params, mappedX, mapWidth, correction->GetCropRect3(params, mapWidth),
+                                             &table);
+
+        QImage input(width, height, QImage::Format_RGB888);
+        for (int y = 0; y < height; ++y)
+        {
+            uchar *line = input.scanLine(y);
+            for (int x = 0; x < width * 3; ++x)
+            {
+                line[x] = static_cast<uchar>(x * 7 + y * 13);
+            }
+        }
+        QImage output;
+
+        Measurement measurement(&l1Misses, &l2Misses, &llcMisses, iterations);
+        for (unsigned int o = 0; o < sizeof(orders) / sizeof(orders[0]); ++o)
+        {
+            table.SetTraversalOrder(orders[o]);
+            measurement.Run(table, input, &output, OrderName(orders[o]), out);
+        }
+
+        RemapSymmetricTable symmetric;
+        if (symmetric.Build(table))
+        {
+            measurement.Run(symmetric, input, &output, symmetric.MirrorY() ? "symmetric 1/4" : "symmetric 1/2", out);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# remap benchmark: the traversal orders and the symmetric form of the
+# Process3 remap table.
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+TARGET = remap_benchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../correction/correction.pri)
+
+SOURCES += \
+    remap_benchmark.cpp
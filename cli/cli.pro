@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# fisheye_cli: the batch correction of images and directories,
+# a console tool without QApplication.
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+TARGET = fisheye_cli
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../correction/correction.pri)
+
+SOURCES += \
+    main.cpp
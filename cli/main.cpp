@@ -0,0 +1,325 @@
+#include "BatchPipeline.h"
+#include "DebugOutput.h"
+#include "FisheyeDistortionCorrection.h"
+#include "RemapTable.h"
+#include "RemapTableCache.h"
+#include "RemapTableFile.h"
+#include "RemapSymmetricTable.h"
+#include "WorkerPool.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QStringList>
+
+#include <stdio.h>
+
+/**
+ * fisheye_cli : correct images and directories of images without the GUI.
+ * the correction is either the calibration parameters (Process3 by default)
+ * or a mapping file written by GenerateMappingFileBin().
+ * the images go through a BatchPipeline, the decode, the correction and
+ * the encode of different images overlap.
+ **/
+
+/**
+ * TableCorrector : the Process3 correction or the mapping file as a remap
+ * table per input size. the first image of a size generates its table,
+ * then all the remap threads share it.
+ **/
+class TableCorrector : public BatchPipeline::Corrector
+{
+public:
+    // mapFlags are the RemapTableFile::Map() flags of the mapping file.
+    TableCorrector(const QString &binPath, int mapFlags)
+        : mBinPath(binPath),
+          mMapFlags(mapFlags)
+    {
+    }
+
+    ~TableCorrector()
+    {
+        qDeleteAll(mTables);
+    }
+
+    bool Correct(const QImage &input, QImage *output)
+    {
+        const CorrectionTables *tables = GetTables(input.width(), input.height());
+        if (tables == NULL)
+        {
+            return false;
+        }
+        if (!tables->symmetric.IsNull())
+        {
+            return tables->symmetric.Apply(&input, output);
+        }
+        return tables->table.Apply(&input, output);
+    }
+
+private:
+    struct CorrectionTables
+    {
+        RemapTable          table;
+        RemapSymmetricTable symmetric;
+    };
+
+    const CorrectionTables *GetTables(int width, int height)
+    {
+        QMutexLocker locker(&mMutex);
+        const QPair<int, int> size(width, height);
+        if (mTables.contains(size))
+        {
+            return mTables.value(size);
+        }
+
+        CorrectionTables *tables = new CorrectionTables;
+        FisheyeDistortionCorrection *correction = FisheyeDistortionCorrection::getInstance();
+        if (!mBinPath.isEmpty())
+        {
+            if (!correction->MapMappingFileBin(mBinPath, width, height, &tables->table, mMapFlags))
+            {
+                qWarning("%s: can not load the mapping file.", qPrintable(mBinPath));
+                delete tables;
+                tables = NULL;
+            }
+        }
+        else
+        {
+            correction->SetPictureSize(width, height);
+            const CorrectionParameters_t params = correction->GetParameters();
+            RemapTableCache::getInstance()->CorrectionTable3(params, &tables->table);
+            if (params.symmetric_tables && tables->symmetric.Build(tables->table))
+            {
+                tables->table.Clear();
+            }
+        }
+        // a failed size stays NULL, its images fail without loading the file again.
+        mTables.insert(size, tables);
+        return tables;
+    }
+
+    QString                                         mBinPath;
+    int                                             mMapFlags;
+    QMutex                                          mMutex;
+    QMap<QPair<int, int>, CorrectionTables *>       mTables;
+};
+
+/**
+ * ProcessCorrector : Process1 and Process2 keep their state in the
+ * correction, one image is corrected at a time.
+ **/
+class ProcessCorrector : public BatchPipeline::Corrector
+{
+public:
+    explicit ProcessCorrector(int method)
+        : mMethod(method)
+    {
+    }
+
+    bool Correct(const QImage &input, QImage *output)
+    {
+        QMutexLocker locker(&mMutex);
+        FisheyeDistortionCorrection *correction = FisheyeDistortionCorrection::getInstance();
+        QImage image = input;
+        QImage smooth;
+        correction->SetPictureSize(image.width(), image.height());
+        if (mMethod == 1)
+        {
+            correction->Process1(&image, NULL, NULL, NULL, &smooth, output);
+        }
+        else
+        {
+            correction->Process2(&image, NULL, NULL, NULL, &smooth, output);
+        }
+        return !output->isNull();
+    }
+
+private:
+    int     mMethod;
+    QMutex  mMutex;
+};
+
+/**
+ * "a,b,..." into count integers, false when it is not exactly count integers.
+ **/
+static bool ParseIntegers(const QString &value, int count, int *integers)
+{
+    const QStringList parts = value.split(',');
+    if (parts.size() != count)
+    {
+        return false;
+    }
+    for (int n = 0; n < count; ++n)
+    {
+        bool ok = false;
+        integers[n] = parts[n].trimmed().toInt(&ok);
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * the files of the paths, a directory gives its images (not recursive).
+ **/
+static QStringList CollectImages(const QStringList &paths)
+{
+    QStringList filters;
+    const QList<QByteArray> formats = QImageReader::supportedImageFormats();
+    for (int n = 0; n < formats.size(); ++n)
+    {
+        filters.append(QString("*.") + QString(formats[n]));
+    }
+
+    QStringList images;
+    for (int n = 0; n < paths.size(); ++n)
+    {
+        const QFileInfo info(paths[n]);
+        if (!info.isDir())
+        {
+            images.append(paths[n]);
+            continue;
+        }
+        const QDir directory(paths[n]);
+        const QStringList names = directory.entryList(filters, QDir::Files, QDir::Name);
+        for (int k = 0; k < names.size(); ++k)
+        {
+            images.append(directory.filePath(names[k]));
+        }
+    }
+    return images;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Correct the fisheye distortion of images or directories of images.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("inputs", "images or directories of images.", "inputs...");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "the output directory.", "directory");
+    QCommandLineOption binOption("bin", "correct with a GenerateMappingFileBin() mapping file.", "file");
+    QCommandLineOption trustedBinOption("trusted-bin", "the --bin file (version 2) was written by this pipeline, "
+                                        "skip its checksum and entry checks.");
+    QCommandLineOption populateBinOption("populate-bin", "fault the pages of the --bin file (version 2) in "
+                                         "when it is mapped (linux), not during the first images.");
+    QCommandLineOption methodOption("method", "the correction: 1, 2 or 3.", "method", "3");
+    QCommandLineOption centerOption("center", "the optical center, 0,0 is the image center.", "x,y", "0,0");
+    QCommandLineOption curveOption("curve", "the horizontal and the vertical curve base.", "h,v", "0,0");
+    QCommandLineOption rotationOption("rotation", "the rotation in degrees.", "degrees", "0");
+    QCommandLineOption cropOption("crop", "the crop of the corrected image, 0,0,0,0 is no crop.", "x,y,w,h", "0,0,0,0");
+    QCommandLineOption bilinearOption("bilinear", "bilinear sampling (method 3).");
+    QCommandLineOption symmetricOption("symmetric", "keep only the mirrored part of the tables (method 3).");
+    QCommandLineOption formatOption("format", "the output format, the input format by default.", "suffix");
+    QCommandLineOption qualityOption("quality", "the output quality, -1 is the format default.", "quality", "-1");
+    QCommandLineOption threadsOption("threads", "worker pool threads, 0 for one per cpu.", "count", "0");
+    QCommandLineOption decodeOption("decode-threads", "decode threads, 0 for half of the cpus.", "count", "0");
+    QCommandLineOption remapOption("remap-threads", "correction threads.", "count", "1");
+    QCommandLineOption encodeOption("encode-threads", "encode threads, 0 for half of the cpus.", "count", "0");
+    QCommandLineOption queueOption("queue", "images waiting between two stages, 0 for automatic.", "count", "0");
+    QCommandLineOption cacheOption("table-cache", "the directory of the cached tables (method 3), "
+                                   "empty to keep them in memory only.", "directory",
+                                   RemapTableCache::getInstance()->Directory());
+    QCommandLineOption verboseOption("verbose", "keep the debug messages of the correction.");
+    parser.addOption(outputOption);
+    parser.addOption(binOption);
+    parser.addOption(trustedBinOption);
+    parser.addOption(populateBinOption);
+    parser.addOption(methodOption);
+    parser.addOption(centerOption);
+    parser.addOption(curveOption);
+    parser.addOption(rotationOption);
+    parser.addOption(cropOption);
+    parser.addOption(bilinearOption);
+    parser.addOption(symmetricOption);
+    parser.addOption(formatOption);
+    parser.addOption(qualityOption);
+    parser.addOption(threadsOption);
+    parser.addOption(decodeOption);
+    parser.addOption(remapOption);
+    parser.addOption(encodeOption);
+    parser.addOption(queueOption);
+    parser.addOption(cacheOption);
+    parser.addOption(verboseOption);
+    parser.process(app);
+
+    SetQuietDebugOutput(!parser.isSet(verboseOption));
+
+    int center[2];
+    int curve[2];
+    int crop[4];
+    bool rotationOk = false;
+    const int rotation  = parser.value(rotationOption).toInt(&rotationOk);
+    const int method    = parser.value(methodOption).toInt();
+    if (!ParseIntegers(parser.value(centerOption), 2, center) || !ParseIntegers(parser.value(curveOption), 2, curve)
+            || !ParseIntegers(parser.value(cropOption), 4, crop) || !rotationOk || method < 1 || method > 3)
+    {
+        fprintf(stderr, "bad correction parameters.\n");
+        return 1;
+    }
+    if (!parser.isSet(outputOption) || parser.positionalArguments().isEmpty())
+    {
+        fprintf(stderr, "an output directory and inputs are needed, see --help.\n");
+        return 1;
+    }
+    const QDir output(parser.value(outputOption));
+    if (!output.mkpath("."))
+    {
+        fprintf(stderr, "can not create %s.\n", qPrintable(output.path()));
+        return 1;
+    }
+    WorkerPool::getInstance()->SetThreadCount(parser.value(threadsOption).toInt());
+    RemapTableCache::getInstance()->SetDirectory(parser.value(cacheOption));
+
+    FisheyeDistortionCorrection *correction = FisheyeDistortionCorrection::getInstance();
+    correction->SetOpticalCenterPoint(center[0], center[1]);
+    correction->Set2rdCurveCoff(curve[0], curve[1]);
+    correction->SetRotation(rotation);
+    correction->SetCrop(crop[0], crop[1], crop[2], crop[3]);
+    correction->SetInterpolation(parser.isSet(bilinearOption) ? RemapTable::Bilinear : RemapTable::NearestNeighbour);
+    correction->SetSymmetricTables(parser.isSet(symmetricOption));
+
+    const QStringList images = CollectImages(parser.positionalArguments());
+    QStringList outputs;
+    for (int n = 0; n < images.size(); ++n)
+    {
+        const QFileInfo info(images[n]);
+        const QString suffix = parser.isSet(formatOption) ? parser.value(formatOption) : info.suffix();
+        outputs.append(output.filePath(info.completeBaseName() + "." + suffix));
+    }
+
+    BatchPipeline pipeline;
+    pipeline.SetThreadCounts(parser.value(decodeOption).toInt(), parser.value(remapOption).toInt(),
+                             parser.value(encodeOption).toInt());
+    pipeline.SetQueueCapacity(parser.value(queueOption).toInt());
+    pipeline.SetQuality(parser.value(qualityOption).toInt());
+
+    const int mapFlags = (parser.isSet(trustedBinOption) ? 0 : RemapTableFile::MapVerify)
+                       | (parser.isSet(populateBinOption) ? RemapTableFile::MapPopulate : 0);
+    TableCorrector tableCorrector(parser.value(binOption), mapFlags);
+    ProcessCorrector processCorrector(method);
+    BatchPipeline::Corrector *corrector = &tableCorrector;
+    if (!parser.isSet(binOption) && method != 3)
+    {
+        corrector = &processCorrector;
+    }
+
+    const BatchResult_t result = pipeline.Run(images, outputs, corrector);
+    printf("%d images corrected, %d failed, %lld ms, %.2f images/s\n", result.corrected, result.failed,
+           static_cast<long long>(result.elapsedMs), result.imagesPerSecond);
+    printf("busy ms: decode %lld (%d threads), remap %lld (%d threads), encode %lld (%d threads)\n",
+           static_cast<long long>(result.decodeBusyMs), pipeline.DecodeThreads(),
+           static_cast<long long>(result.remapBusyMs), pipeline.RemapThreads(),
+           static_cast<long long>(result.encodeBusyMs), pipeline.EncodeThreads());
+    // the tables of this batch are on disk for the next one.
+    RemapTableCache::getInstance()->WaitForWrites();
+    return (result.failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+#include "BatchPipeline.h"
+
+#include <QAtomicInt>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <string.h>
+
+typedef struct BatchItem
+{
+    int     index;
+    QImage  image;
+} BatchItem_t;
+
+/**
+ * BatchQueue : the bounded queue between two stages.
+ * Push() waits while the queue is full, Pop() waits while it is empty and
+ * returns false once every producer is done and the queue is drained.
+ **/
+class BatchQueue
+{
+public:
+    BatchQueue(int capacity, int producers)
+        : mCapacity(capacity),
+          mProducers(producers)
+    {
+    }
+
+    void Push(const BatchItem_t &item)
+    {
+        QMutexLocker locker(&mMutex);
+        while (mItems.size() >= mCapacity)
+        {
+            mNotFull.wait(&mMutex);
+        }
+        mItems.append(item);
+        mNotEmpty.wakeOne();
+    }
+
+    bool Pop(BatchItem_t *item)
+    {
+        QMutexLocker locker(&mMutex);
+        while (mItems.isEmpty())
+        {
+            if (mProducers == 0)
+            {
+                return false;
+            }
+            mNotEmpty.wait(&mMutex);
+        }
+        *item = mItems.takeFirst();
+        mNotFull.wakeOne();
+        return true;
+    }
+
+    // the last producer closes the queue, the waiting consumers return.
+    void ProducerDone()
+    {
+        QMutexLocker locker(&mMutex);
+        if (--mProducers == 0)
+        {
+            mNotEmpty.wakeAll();
+        }
+    }
+
+private:
+    QMutex              mMutex;
+    QWaitCondition      mNotFull;
+    QWaitCondition      mNotEmpty;
+    QList<BatchItem_t>  mItems;
+    int                 mCapacity;
+    int                 mProducers;
+};
+
+/**
+ * the state of one Run(), shared by the threads of all the stages.
+ **/
+class BatchRun
+{
+public:
+    BatchRun(const QStringList &inputs, const QStringList &outputs, BatchPipeline::Corrector *corrector,
+             int quality, int capacity, int decodeThreads, int remapThreads)
+        : inputs(inputs),
+          outputs(outputs),
+          corrector(corrector),
+          quality(quality),
+          next(0),
+          decoded(capacity, decodeThreads),
+          corrected(capacity, remapThreads),
+          correctedCount(0),
+          failedCount(0),
+          decodeBusy(0),
+          remapBusy(0),
+          encodeBusy(0)
+    {
+    }
+
+    void AddFailure(const QString &message)
+    {
+        QMutexLocker locker(&mutex);
+        qWarning("%s", qPrintable(message));
+        failedCount++;
+    }
+
+    void AddBusy(qint64 *busy, qint64 nsecs)
+    {
+        QMutexLocker locker(&mutex);
+        *busy += nsecs;
+    }
+
+    const QStringList          &inputs;
+    const QStringList          &outputs;
+    BatchPipeline::Corrector   *corrector;
+    const int                   quality;
+    QAtomicInt                  next;
+    BatchQueue                  decoded;
+    BatchQueue                  corrected;
+
+    QMutex                      mutex;
+    int                         correctedCount;
+    int                         failedCount;
+    qint64                      decodeBusy;
+    qint64                      remapBusy;
+    qint64                      encodeBusy;
+};
+
+static void DecodeLoop(BatchRun *run)
+{
+    QElapsedTimer timer;
+    for (;;)
+    {
+        const int index = run->next.fetchAndAddOrdered(1);
+        if (index >= run->inputs.size())
+        {
+            break;
+        }
+        timer.start();
+        BatchItem_t item;
+        item.index = index;
+        item.image = QImage(run->inputs[index]);
+        if (item.image.isNull())
+        {
+            run->AddFailure(QString("can not read %1").arg(run->inputs[index]));
+            continue;
+        }
+        // the remap tables read RGB888, convert it here instead of on the remap threads.
+        if (item.image.format() != QImage::Format_RGB888)
+        {
+            item.image = item.image.convertToFormat(QImage::Format_RGB888);
+        }
+        run->AddBusy(&run->decodeBusy, timer.nsecsElapsed());
+        run->decoded.Push(item);
+    }
+    run->decoded.ProducerDone();
+}
+
+static void RemapLoop(BatchRun *run)
+{
+    QElapsedTimer timer;
+    BatchItem_t item;
+    while (run->decoded.Pop(&item))
+    {
+        timer.start();
+        BatchItem_t output;
+        output.index = item.index;
+        const bool ok = run->corrector->Correct(item.image, &output.image);
+        // release the decoded image before waiting on the full queue.
+        item.image = QImage();
+        run->AddBusy(&run->remapBusy, timer.nsecsElapsed());
+        if (!ok || output.image.isNull())
+        {
+            run->AddFailure(QString("can not correct %1").arg(run->inputs[output.index]));
+            continue;
+        }
+        run->corrected.Push(output);
+    }
+    run->corrected.ProducerDone();
+}
+
+static void EncodeLoop(BatchRun *run)
+{
+    QElapsedTimer timer;
+    BatchItem_t item;
+    while (run->corrected.Pop(&item))
+    {
+        timer.start();
+        const bool ok = item.image.save(run->outputs[item.index], NULL, run->quality);
+        item.image = QImage();
+        run->AddBusy(&run->encodeBusy, timer.nsecsElapsed());
+        if (!ok)
+        {
+            run->AddFailure(QString("can not write %1").arg(run->outputs[item.index]));
+            continue;
+        }
+        QMutexLocker locker(&run->mutex);
+        run->correctedCount++;
+    }
+}
+
+class BatchStageThread : public QThread
+{
+public:
+    typedef void (*StageLoop)(BatchRun *run);
+
+    BatchStageThread(BatchRun *run, StageLoop loop)
+        : mRun(run),
+          mLoop(loop)
+    {
+    }
+
+protected:
+    void run()
+    {
+        mLoop(mRun);
+    }
+
+private:
+    BatchRun   *mRun;
+    StageLoop   mLoop;
+};
+
+BatchPipeline::BatchPipeline()
+    : mQueueCapacity(0),
+      mQuality(-1)
+{
+    SetThreadCounts(0, 0, 0);
+}
+
+void BatchPipeline::SetThreadCounts(int decode, int remap, int encode)
+{
+    const int half  = qMax(1, QThread::idealThreadCount() / 2);
+    mDecodeThreads  = (decode > 0) ? decode : half;
+    mRemapThreads   = (remap > 0) ? remap : 1;
+    mEncodeThreads  = (encode > 0) ? encode : half;
+}
+
+void BatchPipeline::SetQueueCapacity(int capacity)
+{
+    mQueueCapacity = qMax(0, capacity);
+}
+
+int BatchPipeline::QueueCapacity() const
+{
+    // 0 is enough to keep every consumer busy while a producer is late.
+    if (mQueueCapacity > 0)
+    {
+        return mQueueCapacity;
+    }
+    return 2 * qMax(mDecodeThreads, qMax(mRemapThreads, mEncodeThreads));
+}
+
+void BatchPipeline::SetQuality(int quality)
+{
+    mQuality = quality;
+}
+
+BatchResult_t BatchPipeline::Run(const QStringList &inputs, const QStringList &outputs, Corrector *corrector)
+{
+    BatchResult_t result;
+    memset(&result, 0, sizeof(result));
+    result.images = inputs.size();
+    if (inputs.size() != outputs.size())
+    {
+        qDebug("batch: %d inputs for %d outputs", inputs.size(), outputs.size());
+        result.failed = inputs.size();
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    BatchRun run(inputs, outputs, corrector, mQuality, QueueCapacity(), mDecodeThreads, mRemapThreads);
+    QVector<BatchStageThread *> threads;
+    for (int n = 0; n < mDecodeThreads; ++n)
+    {
+        threads.append(new BatchStageThread(&run, DecodeLoop));
+    }
+    for (int n = 0; n < mRemapThreads; ++n)
+    {
+        threads.append(new BatchStageThread(&run, RemapLoop));
+    }
+    for (int n = 0; n < mEncodeThreads; ++n)
+    {
+        threads.append(new BatchStageThread(&run, EncodeLoop));
+    }
+    for (int n = 0; n < threads.size(); ++n)
+    {
+        threads[n]->start();
+    }
+    for (int n = 0; n < threads.size(); ++n)
+    {
+        threads[n]->wait();
+        delete threads[n];
+    }
+
+    result.corrected        = run.correctedCount;
+    result.failed           = run.failedCount;
+    result.elapsedMs        = timer.elapsed();
+    result.imagesPerSecond  = (result.elapsedMs > 0) ? result.corrected * 1000.0 / result.elapsedMs : 0;
+    result.decodeBusyMs     = run.decodeBusy / 1000000;
+    result.remapBusyMs      = run.remapBusy / 1000000;
+    result.encodeBusyMs     = run.encodeBusy / 1000000;
+    qDebug("batch: %d of %d images in %lld ms, %.2f images/s", result.corrected, result.images,
+           static_cast<long long>(result.elapsedMs), result.imagesPerSecond);
+    return result;
+}
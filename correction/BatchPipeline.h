@@ -0,0 +1,80 @@
+#ifndef BatchPipeline_H
+#define BatchPipeline_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+/**
+ * the counters of one BatchPipeline::Run().
+ * the busy times are summed over the threads of the stage, a stage with
+ * busy / threads close to elapsedMs is the bottleneck.
+ **/
+typedef struct BatchResult
+{
+    int     images;
+    int     corrected;
+    int     failed;
+    qint64  elapsedMs;
+    double  imagesPerSecond;
+    qint64  decodeBusyMs;
+    qint64  remapBusyMs;
+    qint64  encodeBusyMs;
+} BatchResult_t;
+
+/**
+ * BatchPipeline : correct a list of image files in three stages, decode,
+ * remap and encode. every stage has its own threads and the stages are
+ * connected by bounded queues, so the decode of the next images and the
+ * encode of the previous ones overlap the remap of the current one, and a
+ * slow stage never holds more than the queue capacity of decoded images.
+ * the images are written in the order they are finished.
+ **/
+class BatchPipeline
+{
+public:
+    /*
+     * Corrector : the remap stage, Correct() is called from all the
+     * remap threads at the same time.
+     **/
+    class Corrector
+    {
+    public:
+        virtual ~Corrector() {}
+        virtual bool Correct(const QImage &input, QImage *output) = 0;
+    };
+
+    BatchPipeline();
+
+    /*
+     * SetThreadCounts() : the threads of every stage, 0 gives the decode
+     * and the encode half of QThread::idealThreadCount() each, and one
+     * remap thread (the remap tables already run on the WorkerPool).
+     **/
+    void    SetThreadCounts(int decode, int remap, int encode);
+    // the decoded and the corrected images waiting for the next stage, per queue.
+    // 0 is twice the threads of the biggest stage.
+    void    SetQueueCapacity(int capacity);
+    // the QImage::save() quality of the encode stage, -1 is the format default.
+    void    SetQuality(int quality);
+
+    int     DecodeThreads() const   { return mDecodeThreads; }
+    int     RemapThreads() const    { return mRemapThreads; }
+    int     EncodeThreads() const   { return mEncodeThreads; }
+    int     QueueCapacity() const;
+
+    /*
+     * Run() : correct inputs[n] into outputs[n], the format of the output
+     * is its suffix. return when every image is written or failed.
+     **/
+    BatchResult_t Run(const QStringList &inputs, const QStringList &outputs, Corrector *corrector);
+
+private:
+    int     mDecodeThreads;
+    int     mRemapThreads;
+    int     mEncodeThreads;
+    int     mQueueCapacity;
+    int     mQuality;
+};
+
+#endif // BatchPipeline_H
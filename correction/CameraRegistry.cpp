@@ -0,0 +1,66 @@
+#include "CameraRegistry.h"
+
+#include <QDebug>
+
+CameraRegistry *CameraRegistry::getInstance()
+{
+    static CameraRegistry registry;
+    return &registry;
+}
+
+CameraRegistry::CameraRegistry()
+{
+}
+
+CorrectionContextPtr CameraRegistry::Register(int cameraId, const CorrectionParameters_t &params, int formats)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        QMap<int, CorrectionContextPtr>::const_iterator it;
+        for (it = mContexts.constBegin(); it != mContexts.constEnd(); ++it)
+        {
+            if (it.value()->Parameters() == params && it.value()->Formats() == formats)
+            {
+                mContexts[cameraId] = it.value();
+                qDebug("camera %d: shares the table of camera %d", cameraId, it.key());
+                return it.value();
+            }
+        }
+    }
+
+    // the table generation is the long part, the other cameras stay usable meanwhile.
+    CorrectionContextPtr context = CorrectionContext::Create(params, formats);
+    if (context.isNull())
+    {
+        return context;
+    }
+    QMutexLocker locker(&mMutex);
+    mContexts[cameraId] = context;
+    qDebug("camera %d: %dx%d -> %dx%d", cameraId, params.width, params.height,
+           context->OutputSize().width(), context->OutputSize().height());
+    return context;
+}
+
+void CameraRegistry::Unregister(int cameraId)
+{
+    QMutexLocker locker(&mMutex);
+    mContexts.remove(cameraId);
+}
+
+void CameraRegistry::Clear()
+{
+    QMutexLocker locker(&mMutex);
+    mContexts.clear();
+}
+
+CorrectionContextPtr CameraRegistry::Context(int cameraId) const
+{
+    QMutexLocker locker(&mMutex);
+    return mContexts.value(cameraId);
+}
+
+QList<int> CameraRegistry::Cameras() const
+{
+    QMutexLocker locker(&mMutex);
+    return mContexts.keys();
+}
@@ -0,0 +1,43 @@
+#ifndef CameraRegistry_H
+#define CameraRegistry_H
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include "CorrectionContext.h"
+
+/**
+ * CameraRegistry : the CorrectionContext of every camera of the process,
+ * by camera id. the FisheyeDistortionCorrection singleton keeps the one
+ * parameter set of the GUI, the cameras of a surround view each get their
+ * own context here.
+ * Register() again replaces the context of the camera, the frames which
+ * are corrected with the old one keep it until they are done.
+ **/
+class CameraRegistry
+{
+public:
+    static  CameraRegistry *getInstance();
+
+    /*
+     * Register() : the context of params for the camera, a camera with
+     * the same parameters and formats shares its tables. NULL for a bad size.
+     * formats are the CorrectionContext::FrameFormat flags.
+     **/
+    CorrectionContextPtr Register(int cameraId, const CorrectionParameters_t &params,
+                                  int formats = CorrectionContext::RgbFrames);
+    void    Unregister(int cameraId);
+    void    Clear();
+
+    // NULL when the camera is not registered.
+    CorrectionContextPtr Context(int cameraId) const;
+    QList<int> Cameras() const;
+
+private:
+    CameraRegistry();
+
+    mutable QMutex                      mMutex;
+    QMap<int, CorrectionContextPtr>     mContexts;
+};
+
+#endif // CameraRegistry_H
@@ -0,0 +1,223 @@
+#include "CircleKernel.h"
+
+#include <cmath>
+
+// the same targets as RemapKernel.cpp.
+#if defined(Q_PROCESSOR_X86) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG) || defined(Q_CC_MSVC))
+#  define CIRCLE_KERNEL_X86
+#  if !(defined(Q_OS_WIN) && !defined(Q_PROCESSOR_X86_64) && defined(Q_CC_GNU))
+#    define CIRCLE_KERNEL_AVX2
+#  endif
+#endif
+
+#ifdef CIRCLE_KERNEL_X86
+#  include <immintrin.h>
+#  if defined(Q_CC_GNU) || defined(Q_CC_CLANG)
+#    define CIRCLE_TARGET(isa) __attribute__((target(isa)))
+#  else
+#    define CIRCLE_TARGET(isa)
+#  endif
+#endif
+
+/**
+ * the Cephes asinf() polynomial, asin(s) = s + s * z * P(z) with z = s^2
+ * on [0, 0.5]. above 0.5, asin(x) = pi / 2 - 2 * asin(s) with
+ * s = sqrt((1 - x) / 2), where 1 - x comes from rMinusA without cancellation.
+ * every kernel evaluates it in the same order, without FMA.
+ **/
+static const float kAsinP0  = 4.2163199048e-2f;
+static const float kAsinP1  = 2.4181311049e-2f;
+static const float kAsinP2  = 4.5470025998e-2f;
+static const float kAsinP3  = 7.4953002686e-2f;
+static const float kAsinP4  = 1.6666752422e-1f;
+static const float kHalfPi  = 1.5707963268f;
+
+static inline float AsinPolynomial(float s, float z)
+{
+    float p = kAsinP0 * z + kAsinP1;
+    p = p * z + kAsinP2;
+    p = p * z + kAsinP3;
+    p = p * z + kAsinP4;
+    return p * z * s + s;
+}
+
+static inline float ArcLength(int i, const CircleRow_t &circle)
+{
+    const float x       = qMin((circle.a - i) / circle.r, 1.0f);
+    const float below   = qMax((circle.rMinusA + i) / circle.r, 0.0f);   // 1 - x
+    float angle;
+    if (x > 0.5f)
+    {
+        const float z = 0.5f * below;
+        angle = kHalfPi - 2.0f * AsinPolynomial(std::sqrt(z), z);
+    }
+    else
+    {
+        angle = AsinPolynomial(x, x * x);
+    }
+    return circle.r * angle;
+}
+
+void CircleKernel::ArcLengthsScalar(float *lengths, int count, const CircleRow_t &circle)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        lengths[i] = ArcLength(i, circle);
+    }
+}
+
+void CircleKernel::HeightsScalar(float *heights, const float *xs, int count, const CircleRow_t &circle)
+{
+    // b - sqrt(r^2 - d^2) = (b - r) + d^2 / (r + sqrt((r - d) * (r + d))).
+    for (int i = 0; i < count; ++i)
+    {
+        const float d = qMin(std::fabs(xs[i] - circle.a), circle.r);
+        heights[i] = circle.bMinusR + d * d / (circle.r + std::sqrt((circle.r - d) * (circle.r + d)));
+    }
+}
+
+#ifdef CIRCLE_KERNEL_X86
+CIRCLE_TARGET("sse4.1")
+static inline __m128 AsinPolynomialSSE41(__m128 s, __m128 z)
+{
+    __m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kAsinP0), z), _mm_set1_ps(kAsinP1));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(kAsinP2));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(kAsinP3));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(kAsinP4));
+    return _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), s), s);
+}
+
+CIRCLE_TARGET("sse4.1")
+static void ArcLengthsSSE41(float *lengths, int count, const CircleRow_t &circle)
+{
+    const __m128 a          = _mm_set1_ps(circle.a);
+    const __m128 r          = _mm_set1_ps(circle.r);
+    const __m128 rMinusA    = _mm_set1_ps(circle.rMinusA);
+    const __m128 one        = _mm_set1_ps(1.0f);
+    const __m128 half       = _mm_set1_ps(0.5f);
+    __m128 index            = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 x      = _mm_min_ps(_mm_div_ps(_mm_sub_ps(a, index), r), one);
+        const __m128 below  = _mm_max_ps(_mm_div_ps(_mm_add_ps(rMinusA, index), r), _mm_setzero_ps());
+        const __m128 z      = _mm_mul_ps(half, below);
+        const __m128 upper  = _mm_sub_ps(_mm_set1_ps(kHalfPi),
+                                         _mm_mul_ps(_mm_set1_ps(2.0f), AsinPolynomialSSE41(_mm_sqrt_ps(z), z)));
+        const __m128 lower  = AsinPolynomialSSE41(x, _mm_mul_ps(x, x));
+        const __m128 angle  = _mm_blendv_ps(lower, upper, _mm_cmpgt_ps(x, half));
+        _mm_storeu_ps(lengths + i, _mm_mul_ps(r, angle));
+        index = _mm_add_ps(index, _mm_set1_ps(4.0f));
+    }
+    for (; i < count; ++i)
+    {
+        lengths[i] = ArcLength(i, circle);
+    }
+}
+
+CIRCLE_TARGET("sse4.1")
+static void HeightsSSE41(float *heights, const float *xs, int count, const CircleRow_t &circle)
+{
+    const __m128 a          = _mm_set1_ps(circle.a);
+    const __m128 r          = _mm_set1_ps(circle.r);
+    const __m128 bMinusR    = _mm_set1_ps(circle.bMinusR);
+    const __m128 absMask    = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 d      = _mm_min_ps(_mm_and_ps(_mm_sub_ps(_mm_loadu_ps(xs + i), a), absMask), r);
+        const __m128 root   = _mm_sqrt_ps(_mm_mul_ps(_mm_sub_ps(r, d), _mm_add_ps(r, d)));
+        _mm_storeu_ps(heights + i, _mm_add_ps(bMinusR, _mm_div_ps(_mm_mul_ps(d, d), _mm_add_ps(r, root))));
+    }
+    CircleKernel::HeightsScalar(heights + i, xs + i, count - i, circle);
+}
+#endif // CIRCLE_KERNEL_X86
+
+#ifdef CIRCLE_KERNEL_AVX2
+CIRCLE_TARGET("avx2")
+static inline __m256 AsinPolynomialAVX2(__m256 s, __m256 z)
+{
+    __m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kAsinP0), z), _mm256_set1_ps(kAsinP1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(kAsinP2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(kAsinP3));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(kAsinP4));
+    return _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, z), s), s);
+}
+
+CIRCLE_TARGET("avx2")
+static void ArcLengthsAVX2(float *lengths, int count, const CircleRow_t &circle)
+{
+    const __m256 a          = _mm256_set1_ps(circle.a);
+    const __m256 r          = _mm256_set1_ps(circle.r);
+    const __m256 rMinusA    = _mm256_set1_ps(circle.rMinusA);
+    const __m256 one        = _mm256_set1_ps(1.0f);
+    const __m256 half       = _mm256_set1_ps(0.5f);
+    __m256 index            = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 x      = _mm256_min_ps(_mm256_div_ps(_mm256_sub_ps(a, index), r), one);
+        const __m256 below  = _mm256_max_ps(_mm256_div_ps(_mm256_add_ps(rMinusA, index), r), _mm256_setzero_ps());
+        const __m256 z      = _mm256_mul_ps(half, below);
+        const __m256 upper  = _mm256_sub_ps(_mm256_set1_ps(kHalfPi),
+                                            _mm256_mul_ps(_mm256_set1_ps(2.0f),
+                                                          AsinPolynomialAVX2(_mm256_sqrt_ps(z), z)));
+        const __m256 lower  = AsinPolynomialAVX2(x, _mm256_mul_ps(x, x));
+        const __m256 angle  = _mm256_blendv_ps(lower, upper, _mm256_cmp_ps(x, half, _CMP_GT_OQ));
+        _mm256_storeu_ps(lengths + i, _mm256_mul_ps(r, angle));
+        index = _mm256_add_ps(index, _mm256_set1_ps(8.0f));
+    }
+    for (; i < count; ++i)
+    {
+        lengths[i] = ArcLength(i, circle);
+    }
+}
+
+CIRCLE_TARGET("avx2")
+static void HeightsAVX2(float *heights, const float *xs, int count, const CircleRow_t &circle)
+{
+    const __m256 a          = _mm256_set1_ps(circle.a);
+    const __m256 r          = _mm256_set1_ps(circle.r);
+    const __m256 bMinusR    = _mm256_set1_ps(circle.bMinusR);
+    const __m256 absMask    = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 d      = _mm256_min_ps(_mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(xs + i), a), absMask), r);
+        const __m256 root   = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_sub_ps(r, d), _mm256_add_ps(r, d)));
+        _mm256_storeu_ps(heights + i, _mm256_add_ps(bMinusR, _mm256_div_ps(_mm256_mul_ps(d, d),
+                                                                           _mm256_add_ps(r, root))));
+    }
+    CircleKernel::HeightsScalar(heights + i, xs + i, count - i, circle);
+}
+#endif // CIRCLE_KERNEL_AVX2
+
+CircleKernel::ArcLengthsFunc CircleKernel::ArcLengths(RemapKernel::Isa isa)
+{
+    if (isa > RemapKernel::SupportedIsa()) isa = RemapKernel::SupportedIsa();
+    switch (isa)
+    {
+#ifdef CIRCLE_KERNEL_X86
+#ifdef CIRCLE_KERNEL_AVX2
+    case RemapKernel::AVX2:  return ArcLengthsAVX2;
+#endif
+    case RemapKernel::SSE41: return ArcLengthsSSE41;
+#endif
+    default:                 return ArcLengthsScalar;
+    }
+}
+
+CircleKernel::HeightsFunc CircleKernel::Heights(RemapKernel::Isa isa)
+{
+    if (isa > RemapKernel::SupportedIsa()) isa = RemapKernel::SupportedIsa();
+    switch (isa)
+    {
+#ifdef CIRCLE_KERNEL_X86
+#ifdef CIRCLE_KERNEL_AVX2
+    case RemapKernel::AVX2:  return HeightsAVX2;
+#endif
+    case RemapKernel::SSE41: return HeightsSSE41;
+#endif
+    default:                 return HeightsScalar;
+    }
+}
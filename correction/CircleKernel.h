@@ -0,0 +1,58 @@
+#ifndef CircleKernel_H
+#define CircleKernel_H
+
+#include "RemapKernel.h"
+
+/**
+ * CircleRow : one row of the Process3 circle model,
+ * (x - a)^2 + (y - b)^2 = r^2 with b - r at the row.
+ * rMinusA and bMinusR are computed in double by the caller, so the
+ * kernels never subtract two big floats (r grows to 1e5 near the rows
+ * where the circle is almost a line).
+ **/
+typedef struct CircleRow
+{
+    float a;
+    float r;
+    float rMinusA;  // r - a, r >= a.
+    float bMinusR;  // b - r, the y of the top of the circle.
+} CircleRow_t;
+
+/**
+ * CircleKernel : the batched float kernels of GenerateHorizontalMap3().
+ * asin is the Cephes single precision polynomial (relative error below
+ * 2.5e-7 on [0, 1]) and the square roots are the IEEE ones. up to 4k
+ * frames the arc lengths stay within 3e-4 pixel of the double model and
+ * the heights within 1e-4 pixel, so only the columns within that of a
+ * pixel border can be truncated to the next pixel. the SSE4.1 and AVX2
+ * kernels give exactly the floats of the scalar one as long as no
+ * multiply and add is fused, correction.pro turns the contraction off and
+ * remap_benchmark --verify compares them. the kernel of
+ * RemapKernel::ActiveIsa() is picked.
+ **/
+class CircleKernel
+{
+public:
+    /*
+     * ArcLengthsFunc : lengths[i] = r * asin((a - i) / r), the arc length
+     * from the column i to the top of the circle, for 0 <= i <= a.
+     **/
+    typedef void (*ArcLengthsFunc)(float *lengths, int count, const CircleRow_t &circle);
+
+    /*
+     * HeightsFunc : heights[i] = b - sqrt(r^2 - (xs[i] - a)^2), the upper
+     * half of the circle. the columns out of the circle get b.
+     **/
+    typedef void (*HeightsFunc)(float *heights, const float *xs, int count, const CircleRow_t &circle);
+
+    static ArcLengthsFunc   ArcLengths()    { return ArcLengths(RemapKernel::ActiveIsa()); }
+    static ArcLengthsFunc   ArcLengths(RemapKernel::Isa isa);
+
+    static HeightsFunc      Heights()       { return Heights(RemapKernel::ActiveIsa()); }
+    static HeightsFunc      Heights(RemapKernel::Isa isa);
+
+    static void             ArcLengthsScalar(float *lengths, int count, const CircleRow_t &circle);
+    static void             HeightsScalar(float *heights, const float *xs, int count, const CircleRow_t &circle);
+};
+
+#endif // CircleKernel_H
@@ -0,0 +1,74 @@
+#include "CorrectionContext.h"
+#include "RemapTableCache.h"
+
+#include <QDebug>
+
+CorrectionContext::CorrectionContext()
+    : mFormats(RgbFrames)
+{
+}
+
+CorrectionContextPtr CorrectionContext::Create(const CorrectionParameters_t &params, int formats,
+                                               const QAtomicInt *cancelled)
+{
+    if (params.width <= 0 || params.height <= 0)
+    {
+        qDebug("context: bad size %dx%d", params.width, params.height);
+        return CorrectionContextPtr();
+    }
+
+    RemapTable table;
+    if (!RemapTableCache::getInstance()->CorrectionTable3(params, &table, cancelled))
+    {
+        return CorrectionContextPtr();
+    }
+    return Create(params, table, formats);
+}
+
+CorrectionContextPtr CorrectionContext::Create(const CorrectionParameters_t &params, const RemapTable &table,
+                                               int formats)
+{
+    if (table.IsNull())
+    {
+        qDebug("context: no table");
+        return CorrectionContextPtr();
+    }
+
+    CorrectionContext *context = new CorrectionContext;
+    context->mParams    = params;
+    context->mFormats   = formats;
+    context->mTable     = table;
+    context->mOutputSize = QSize(context->mTable.Width(), context->mTable.Height());
+    if (formats & Nv12Frames)
+    {
+        context->mNv12.Build(context->mTable);
+    }
+    if (!(formats & RgbFrames))
+    {
+        context->mTable.Clear();
+    }
+    else if (params.symmetric_tables && context->mSymmetric.Build(context->mTable))
+    {
+        context->mTable.Clear();
+    }
+    return CorrectionContextPtr(context);
+}
+
+bool CorrectionContext::Apply(const QImage *input, QImage *output) const
+{
+    if (!mSymmetric.IsNull())
+    {
+        return mSymmetric.Apply(input, output);
+    }
+    return mTable.Apply(input, output);
+}
+
+bool CorrectionContext::ApplyNv12(const Nv12Frame *input, Nv12Frame *output) const
+{
+    if (mNv12.IsNull())
+    {
+        qDebug("context: no nv12 table");
+        return false;
+    }
+    return mNv12.Apply(input, output);
+}
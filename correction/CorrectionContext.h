@@ -0,0 +1,74 @@
+#ifndef CorrectionContext_H
+#define CorrectionContext_H
+
+#include <QImage>
+#include <QSharedPointer>
+#include <QSize>
+#include "FisheyeDistortionCorrection.h"
+#include "Nv12Frame.h"
+#include "RemapNv12Table.h"
+#include "RemapTable.h"
+#include "RemapSymmetricTable.h"
+
+class CorrectionContext;
+typedef QSharedPointer<const CorrectionContext> CorrectionContextPtr;
+
+/**
+ * CorrectionContext : the Process3 correction of one parameter set, its
+ * parameters and its table (or the mirrored form of it).
+ * a context never changes once it is created, so any number of threads
+ * can Apply() it at the same time, and it stays valid for the frames
+ * which use it while the camera is calibrated again.
+ * the tables are only kept for the frame formats it is created for.
+ **/
+class CorrectionContext
+{
+public:
+    enum FrameFormat
+    {
+        RgbFrames   = 1,
+        Nv12Frames  = 2
+    };
+
+    /*
+     * Create() : generate the tables of params for formats (FrameFormat
+     * flags), NULL for a bad size or when cancelled (optional, see
+     * GenerateCorrectionTable3()) is set during the generation.
+     **/
+    static CorrectionContextPtr Create(const CorrectionParameters_t &params, int formats = RgbFrames,
+                                       const QAtomicInt *cancelled = NULL);
+    /*
+     * Create() : the context of table, already generated for params (the
+     * CorrectionTable() of Process3Stages), it is not cached.
+     **/
+    static CorrectionContextPtr Create(const CorrectionParameters_t &params, const RemapTable &table,
+                                       int formats = RgbFrames);
+
+    const CorrectionParameters_t &Parameters() const  { return mParams; }
+    QSize   InputSize() const                           { return QSize(mParams.width, mParams.height); }
+    QSize   OutputSize() const                          { return mOutputSize; }
+    bool    IsSymmetric() const                         { return !mSymmetric.IsNull(); }
+    int     Formats() const                             { return mFormats; }
+
+    /*
+     * Apply() : the strecthImage of Process3, the tiles run on the WorkerPool.
+     **/
+    bool    Apply(const QImage *input, QImage *output) const;
+    /*
+     * ApplyNv12() : the same correction of a NV12 frame, plane by plane.
+     * false when the context is not created for Nv12Frames.
+     **/
+    bool    ApplyNv12(const Nv12Frame *input, Nv12Frame *output) const;
+
+private:
+    CorrectionContext();
+
+    CorrectionParameters_t  mParams;
+    int                     mFormats;
+    QSize                   mOutputSize;
+    RemapTable              mTable;
+    RemapSymmetricTable     mSymmetric;
+    RemapNv12Table          mNv12;
+};
+
+#endif // CorrectionContext_H
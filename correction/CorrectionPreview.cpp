@@ -0,0 +1,211 @@
+#include "CorrectionPreview.h"
+#include "CorrectionContext.h"
+#include "RemapTableCache.h"
+
+#include <QThread>
+#include <QDebug>
+
+class CorrectionPreviewThread : public QThread
+{
+public:
+    explicit CorrectionPreviewThread(CorrectionPreview *preview)
+        : mPreview(preview)
+    {
+    }
+
+protected:
+    void run()
+    {
+        mPreview->ThreadLoop();
+    }
+
+private:
+    CorrectionPreview *mPreview;
+};
+
+CorrectionPreview::CorrectionPreview()
+    : mDivisor(2),
+      mPreviewParams(CorrectionParameters_t()),
+      mThread(NULL),
+      mListener(NULL),
+      mRequest(0),
+      mQueued(0),
+      mCancelled(0),
+      mStages(false),
+      mQueuedParams(CorrectionParameters_t()),
+      mResultParams(CorrectionParameters_t()),
+      mResultReady(false),
+      mQuit(false)
+{
+    mThread = new CorrectionPreviewThread(this);
+    mThread->start();
+}
+
+CorrectionPreview::~CorrectionPreview()
+{
+    {
+        QMutexLocker locker(&mMutex);
+        mQuit = true;
+        ++mRequest;
+        mCancelled.storeRelease(1);
+        mWakeUp.wakeAll();
+    }
+    mThread->wait();
+    delete mThread;
+}
+
+void CorrectionPreview::SetListener(Listener *listener)
+{
+    QMutexLocker locker(&mMutex);
+    mListener = listener;
+}
+
+void CorrectionPreview::SetDivisor(int divisor)
+{
+    mDivisor = qMax(1, divisor);
+    SetSource(mSource);
+}
+
+void CorrectionPreview::SetSource(const QImage &image)
+{
+    mSource = image;
+    mScaledSource = (mDivisor == 1 || image.isNull()) ? image
+                  : image.scaled(image.width() / mDivisor, image.height() / mDivisor,
+                                 Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+CorrectionParameters_t CorrectionPreview::ScaleParameters(const CorrectionParameters_t &params, int divisor)
+{
+    CorrectionParameters_t scaled = params;
+    scaled.width            = params.width / divisor;
+    scaled.height           = params.height / divisor;
+    scaled.optical_center_x = params.optical_center_x / divisor;
+    scaled.optical_center_y = params.optical_center_y / divisor;
+    scaled.horizontal_base  = params.horizontal_base / divisor;
+    scaled.vertical_base    = params.vertical_base / divisor;
+    scaled.crop_x           = params.crop_x / divisor;
+    scaled.crop_y           = params.crop_y / divisor;
+    scaled.crop_w           = params.crop_w / divisor;
+    scaled.crop_h           = params.crop_h / divisor;
+    return scaled;
+}
+
+QImage CorrectionPreview::Update(const CorrectionParameters_t &params)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        mQueued         = ++mRequest;
+        mCancelled.storeRelease(1);
+        mQueuedParams   = params;
+        mQueuedSource   = mSource;
+        mResult         = QImage();
+        mResultReady    = false;
+        mWakeUp.wakeAll();
+    }
+
+    // the preview is always nearest neighbour, Bilinear tables take twice as long to generate.
+    CorrectionParameters_t scaled   = ScaleParameters(params, mDivisor);
+    scaled.interpolation            = RemapTable::NearestNeighbour;
+    if (scaled.width <= 0 || scaled.height <= 0
+        || scaled.width != mScaledSource.width() || scaled.height != mScaledSource.height())
+    {
+        qDebug("preview: %dx%d does not match the source %dx%d", scaled.width, scaled.height,
+               mScaledSource.width(), mScaledSource.height());
+        return QImage();
+    }
+    // the preview tables are not cached, they are only good for tuning.
+    if (mPreviewTable.IsNull() || scaled != mPreviewParams)
+    {
+        FisheyeDistortionCorrection::getInstance()->GenerateCorrectionTable3(scaled, &mPreviewTable);
+        mPreviewParams = scaled;
+    }
+    QImage preview;
+    mPreviewTable.Apply(&mScaledSource, &preview);
+    return preview;
+}
+
+void CorrectionPreview::Cancel()
+{
+    QMutexLocker locker(&mMutex);
+    ++mRequest;
+    mCancelled.storeRelease(1);
+    mQueued         = 0;
+    mQueuedSource   = QImage();
+    mResult         = QImage();
+    mResultReady    = false;
+}
+
+bool CorrectionPreview::TakeFullResolution(QImage *image, CorrectionParameters_t *params)
+{
+    QMutexLocker locker(&mMutex);
+    if (!mResultReady)
+    {
+        return false;
+    }
+    *image = mResult;
+    if (params != NULL)
+    {
+        *params = mResultParams;
+    }
+    mResult         = QImage();
+    mResultReady    = false;
+    return true;
+}
+
+void CorrectionPreview::ThreadLoop()
+{
+    QMutexLocker locker(&mMutex);
+    while (!mQuit)
+    {
+        if (mQueued == 0)
+        {
+            mWakeUp.wait(&mMutex);
+            continue;
+        }
+        const qint64 request                = mQueued;
+        const CorrectionParameters_t params = mQueuedParams;
+        const QImage source                 = mQueuedSource;
+        mQueued         = 0;
+        mQueuedSource   = QImage();
+        mCancelled.storeRelease(0);
+        locker.unlock();
+
+        // a newer request stops the table generation between its stages, and the remap before it starts.
+        RemapTableCache *cache = RemapTableCache::getInstance();
+        RemapTable table;
+        if (!cache->Find(params, RemapTableCache::CorrectionTable, &table))
+        {
+            mStages.Update(params, &mCancelled);
+            if (mCancelled.loadAcquire() == 0)
+            {
+                table = mStages.CorrectionTable();
+                cache->Insert(params, RemapTableCache::CorrectionTable, table);
+            }
+        }
+        CorrectionContextPtr context;
+        if (!table.IsNull())
+        {
+            context = CorrectionContext::Create(params, table, CorrectionContext::RgbFrames);
+        }
+        QImage output;
+        const bool done = !context.isNull() && mCancelled.loadAcquire() == 0 && context->Apply(&source, &output);
+
+        locker.relock();
+        if (!done || request != mRequest)
+        {
+            qDebug("preview: full resolution request %lld %s", request,
+                   (request != mRequest) ? "cancelled" : "failed");
+            continue;
+        }
+        mResult         = output;
+        mResultParams   = params;
+        mResultReady    = true;
+        Listener *listener = mListener;
+        if (listener != NULL)
+        {
+            locker.unlock();
+            listener->FullResolutionReady();
+            locker.relock();
+        }
+    }
+}
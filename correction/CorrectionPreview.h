@@ -0,0 +1,102 @@
+#ifndef CorrectionPreview_H
+#define CorrectionPreview_H
+
+#include <QAtomicInt>
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+#include "FisheyeDistortionCorrection.h"
+#include "Process3Stages.h"
+#include "RemapTable.h"
+
+class CorrectionPreviewThread;
+
+/**
+ * CorrectionPreview : the Process3 output while the parameters are tuned.
+ * Update() returns at once the correction of the source scaled down by the
+ * divisor, with a nearest neighbour table generated at the reduced size,
+ * and queues the full resolution correction on the preview thread.
+ * TakeFullResolution() then gives the full resolution output, the
+ * Listener is told when it is ready.
+ * the preview thread keeps its own Process3Stages, a full resolution
+ * table which is not cached only generates the stages the last change
+ * reaches (a crop change only copies the crop out of the vertical table).
+ * a newer Update() (or Cancel()) replaces the queued request and cancels
+ * the one in progress: the table generation stops after the stage it is
+ * in, the next request generates the stages which are left, and nothing
+ * is cached. a remap in progress finishes and its output is dropped.
+ * Update() and SetSource() are called from one thread (the GUI).
+ **/
+class CorrectionPreview
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+        // called from the preview thread, TakeFullResolution() has a new output.
+        virtual void FullResolutionReady() = 0;
+    };
+
+    CorrectionPreview();
+    ~CorrectionPreview();
+
+    void    SetListener(Listener *listener);
+    /*
+     * SetDivisor() : the preview is width / divisor x height / divisor,
+     * the default 2 is a quarter of the pixels.
+     **/
+    void    SetDivisor(int divisor);
+    int     Divisor() const     { return mDivisor; }
+    void    SetSource(const QImage &image);
+
+    /*
+     * Update() : the preview of params, a null image when the preview size
+     * does not match the scaled source. the full resolution correction of
+     * params is queued.
+     **/
+    QImage  Update(const CorrectionParameters_t &params);
+    void    Cancel();
+
+    /*
+     * TakeFullResolution() : the full resolution output of the last
+     * Update(), false when it is not ready (or it was cancelled or failed).
+     **/
+    bool    TakeFullResolution(QImage *image, CorrectionParameters_t *params = NULL);
+
+    /*
+     * ScaleParameters() : params for the frame scaled down by divisor,
+     * every length is divided, the rotation stays.
+     **/
+    static CorrectionParameters_t ScaleParameters(const CorrectionParameters_t &params, int divisor);
+
+private:
+    friend class CorrectionPreviewThread;
+
+    void    ThreadLoop();
+
+    int                     mDivisor;
+    QImage                  mSource;
+    QImage                  mScaledSource;
+    // the preview table of the last Update().
+    RemapTable              mPreviewTable;
+    CorrectionParameters_t  mPreviewParams;
+
+    // the full resolution request, shared with the preview thread.
+    mutable QMutex          mMutex;
+    QWaitCondition          mWakeUp;
+    CorrectionPreviewThread *mThread;
+    Listener               *mListener;
+    qint64                  mRequest;       // the last Update() or Cancel()
+    qint64                  mQueued;        // the request waiting for the thread, 0 for none
+    QAtomicInt              mCancelled;     // set when the request on the thread is not the last one
+    Process3Stages          mStages;        // the preview thread only
+    CorrectionParameters_t  mQueuedParams;
+    QImage                  mQueuedSource;
+    QImage                  mResult;
+    CorrectionParameters_t  mResultParams;
+    bool                    mResultReady;
+    bool                    mQuit;
+};
+
+#endif // CorrectionPreview_H
@@ -0,0 +1,146 @@
+#include "CorrectionSession.h"
+
+#include <QDebug>
+
+CorrectionSession::CorrectionSession()
+    : mSequence(0),
+      mDropped(0),
+      mOpen(false)
+{
+}
+
+bool CorrectionSession::Open(const CorrectionParameters_t &params, int bufferCount)
+{
+    return Open(CorrectionContext::Create(params), bufferCount);
+}
+
+bool CorrectionSession::Open(const CorrectionContextPtr &context, int bufferCount)
+{
+    Close();
+    if (context.isNull() || context->OutputSize().isEmpty() || bufferCount <= 0)
+    {
+        qDebug("session: no correction or %d buffers", bufferCount);
+        return false;
+    }
+
+    const CorrectionParameters_t &params    = context->Parameters();
+    const QSize outputSize                  = context->OutputSize();
+    QMutexLocker locker(&mMutex);
+    mContext    = context;
+    mParams     = params;
+    mOutputSize = outputSize;
+    mBuffers.resize(bufferCount);
+    for (int n = 0; n < bufferCount; ++n)
+    {
+        mBuffers[n] = QImage(outputSize, QImage::Format_RGB888);
+        mFree.append(n);
+    }
+    mSequence   = 0;
+    mDropped    = 0;
+    mOpen       = true;
+    qDebug("session: %dx%d -> %dx%d, %d buffers", params.width, params.height,
+           outputSize.width(), outputSize.height(), bufferCount);
+    return true;
+}
+
+void CorrectionSession::Close()
+{
+    QMutexLocker locker(&mMutex);
+    mOpen = false;
+    mContext.clear();
+    mBuffers.clear();
+    mFree.clear();
+    mReady.clear();
+    mOutputSize = QSize();
+}
+
+bool CorrectionSession::IsOpen() const
+{
+    QMutexLocker locker(&mMutex);
+    return mOpen;
+}
+
+int CorrectionSession::BufferCount() const
+{
+    QMutexLocker locker(&mMutex);
+    return mBuffers.size();
+}
+
+int CorrectionSession::FreeBuffers() const
+{
+    QMutexLocker locker(&mMutex);
+    return mFree.size();
+}
+
+qint64 CorrectionSession::DroppedFrames() const
+{
+    QMutexLocker locker(&mMutex);
+    return mDropped;
+}
+
+bool CorrectionSession::PushFrame(const QImage &frame)
+{
+    int buffer = 0;
+    qint64 sequence = 0;
+    QImage *output = NULL;
+    {
+        QMutexLocker locker(&mMutex);
+        if (!mOpen)
+        {
+            return false;
+        }
+        if (frame.width() != mParams.width || frame.height() != mParams.height)
+        {
+            qDebug("session: frame %dx%d, opened for %dx%d", frame.width(), frame.height(),
+                   mParams.width, mParams.height);
+            return false;
+        }
+        if (mFree.isEmpty())
+        {
+            mDropped++;
+            return false;
+        }
+        buffer      = mFree.takeFirst();
+        sequence    = mSequence++;
+        output      = &mBuffers[buffer];
+    }
+
+    // the buffer belongs to this call until it is in the ready list, remap it unlocked.
+    const bool ok = mContext->Apply(&frame, output);
+
+    QMutexLocker locker(&mMutex);
+    if (!ok)
+    {
+        mFree.append(buffer);
+        return false;
+    }
+    CorrectionFrame_t corrected;
+    corrected.buffer    = buffer;
+    corrected.sequence  = sequence;
+    corrected.image     = *output;
+    mReady.append(corrected);
+    return true;
+}
+
+bool CorrectionSession::TakeFrame(CorrectionFrame_t *frame)
+{
+    QMutexLocker locker(&mMutex);
+    if (mReady.isEmpty())
+    {
+        return false;
+    }
+    *frame = mReady.takeFirst();
+    return true;
+}
+
+void CorrectionSession::ReleaseFrame(CorrectionFrame_t *frame)
+{
+    // drop the reference first, the buffer is only reused in place when the pool holds the last one.
+    frame->image = QImage();
+    QMutexLocker locker(&mMutex);
+    if (mOpen && frame->buffer >= 0 && frame->buffer < mBuffers.size() && !mFree.contains(frame->buffer))
+    {
+        mFree.append(frame->buffer);
+    }
+    frame->buffer = -1;
+}
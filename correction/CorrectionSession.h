@@ -0,0 +1,86 @@
+#ifndef CorrectionSession_H
+#define CorrectionSession_H
+
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QSize>
+#include <QVector>
+#include "CorrectionContext.h"
+#include "FisheyeDistortionCorrection.h"
+
+/**
+ * one corrected frame of a CorrectionSession.
+ * image is the pool buffer, hand the frame back with ReleaseFrame() once
+ * it is consumed, a copy of image kept after that makes the next frame
+ * written in this buffer allocate a new one.
+ **/
+typedef struct CorrectionFrame
+{
+    int     buffer;
+    qint64  sequence;
+    QImage  image;
+} CorrectionFrame_t;
+
+/**
+ * CorrectionSession : the streaming form of Process3 for a video or a
+ * frame sequence of fixed parameters.
+ * Open() takes the CorrectionContext of the parameters and allocates a pool of
+ * output buffers, then every PushFrame() is one remap pass into a free
+ * buffer, without any allocation, and TakeFrame() gives the corrected
+ * frames in the push order.
+ * the session does not use the Process3 tables of the correction, so
+ * several sessions (several cameras) can run at the same time, and they
+ * can share one context.
+ * one thread pushes the frames, another one can take and release them.
+ * Open() and Close() must not run during a PushFrame().
+ **/
+class CorrectionSession
+{
+public:
+    CorrectionSession();
+
+    /*
+     * Open() : generate the table of params (or take the context of a
+     * camera from the CameraRegistry) and allocate bufferCount output
+     * frames, params.width x params.height is the input size.
+     **/
+    bool    Open(const CorrectionParameters_t &params, int bufferCount = 4);
+    bool    Open(const CorrectionContextPtr &context, int bufferCount = 4);
+    void    Close();
+    bool    IsOpen() const;
+
+    CorrectionParameters_t Parameters() const   { return mParams; }
+    QSize   OutputSize() const                  { return mOutputSize; }
+    int     BufferCount() const;
+    int     FreeBuffers() const;
+    // the frames PushFrame() refused because every buffer was in use.
+    qint64  DroppedFrames() const;
+
+    /*
+     * PushFrame() : correct the frame into a free buffer. return false
+     * when the frame size does not match or every buffer is in use (the
+     * frame is dropped, take and release the corrected frames faster).
+     **/
+    bool    PushFrame(const QImage &frame);
+
+    /*
+     * TakeFrame() : the oldest corrected frame, false when there is none.
+     **/
+    bool    TakeFrame(CorrectionFrame_t *frame);
+    void    ReleaseFrame(CorrectionFrame_t *frame);
+
+private:
+    mutable QMutex          mMutex;
+    CorrectionParameters_t  mParams;
+    QSize                   mOutputSize;
+    CorrectionContextPtr    mContext;
+    QVector<QImage>         mBuffers;
+    QList<int>              mFree;
+    QList<CorrectionFrame_t> mReady;
+    qint64                  mSequence;
+    qint64                  mDropped;
+    bool                    mOpen;
+};
+
+#endif // CorrectionSession_H
@@ -0,0 +1,19 @@
+#include "DebugOutput.h"
+
+#include <QtGlobal>
+#include <QString>
+#include <stdio.h>
+
+static void QuietMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    Q_UNUSED(context);
+    if (type != QtDebugMsg)
+    {
+        fprintf(stderr, "%s\n", qPrintable(message));
+    }
+}
+
+void SetQuietDebugOutput(bool quiet)
+{
+    qInstallMessageHandler(quiet ? QuietMessageHandler : 0);
+}
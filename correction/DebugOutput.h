@@ -0,0 +1,12 @@
+#ifndef DebugOutput_H
+#define DebugOutput_H
+
+/*
+ * SetQuietDebugOutput() : drop the qDebug() messages of the correction
+ * (several per table and per frame) for the command line tools, the
+ * warnings and the errors still go to stderr. false gives the default
+ * Qt output back.
+ **/
+void    SetQuietDebugOutput(bool quiet);
+
+#endif // DebugOutput_H
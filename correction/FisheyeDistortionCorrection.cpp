@@ -0,0 +1,2438 @@
+#include "FisheyeDistortionCorrection.h"
+#include "CircleKernel.h"
+#include "Process3Stages.h"
+#include "RemapTableCache.h"
+#include "RemapTableFile.h"
+#include "WorkerPool.h"
+
+#include <QImage>
+#include <QDebug>
+#include <qmath.h>
+#include <cmath>
+#include <QFile>
+
+//#define PARABOLIC
+#define CIRCEL
+//#define ELLIPSE
+
+/**
+ * ImageRotation : the geometry of DoImageRotate().
+ * the image is rotated by angle degrees around its top-left corner, moved
+ * into its bounding box, and the box is stretched back to width x height.
+ * Map() and MapPixel() go back from the rotated image to the original one,
+ * so the rotation is composed into the remap tables instead of rotating
+ * every frame. the right angles use the exact sine and cosine.
+ **/
+class ImageRotation
+{
+public:
+    ImageRotation(int width, int height, int angle)
+        : mWidth(width),
+          mHeight(height)
+    {
+        const int degrees = ((angle % 360) + 360) % 360;
+        switch (degrees)
+        {
+        case 0:     mCos = 1;   mSin = 0;   break;
+        case 90:    mCos = 0;   mSin = 1;   break;
+        case 180:   mCos = -1;  mSin = 0;   break;
+        case 270:   mCos = 0;   mSin = -1;  break;
+        default:
+            mCos = qCos(qDegreesToRadians(static_cast<qreal>(degrees)));
+            mSin = qSin(qDegreesToRadians(static_cast<qreal>(degrees)));
+            break;
+        }
+        mIdentity = (degrees == 0);
+
+        // the bounding box of the rotated corners, (x, y) -> (x cos - y sin, x sin + y cos).
+        const qreal xs[4] = { 0, width * mCos, -height * mSin, width * mCos - height * mSin };
+        const qreal ys[4] = { 0, width * mSin, height * mCos, width * mSin + height * mCos };
+        mMinX = qMin(qMin(xs[0], xs[1]), qMin(xs[2], xs[3]));
+        mMinY = qMin(qMin(ys[0], ys[1]), qMin(ys[2], ys[3]));
+        mBoxWidth   = qMax(qMax(xs[0], xs[1]), qMax(xs[2], xs[3])) - mMinX;
+        mBoxHeight  = qMax(qMax(ys[0], ys[1]), qMax(ys[2], ys[3])) - mMinY;
+        mBoxPixelsX = qMax(1, qRound(mBoxWidth));
+        mBoxPixelsY = qMax(1, qRound(mBoxHeight));
+    }
+
+    bool IsIdentity() const { return mIdentity; }
+
+    /*
+     * Map() : the original image position of the rotated image position,
+     * the pixel centers are at the integer coordinates.
+     **/
+    QPointF Map(const QPointF &point) const
+    {
+        if (mIdentity) return point;
+        return Unrotate((point.x() + 0.5) * mBoxWidth / mWidth, (point.y() + 0.5) * mBoxHeight / mHeight)
+             - QPointF(0.5, 0.5);
+    }
+
+    /*
+     * MapPixel() : the original pixel which the nearest rotation and the
+     * nearest stretch put at the rotated pixel, (-1, -1) out of the image.
+     **/
+    QPoint MapPixel(const QPoint &point) const
+    {
+        if (mIdentity) return point;
+        if (point.x() < 0 || point.x() >= mWidth || point.y() < 0 || point.y() >= mHeight)
+        {
+            return QPoint(-1, -1);
+        }
+        const int boxX          = qMin(static_cast<int>((point.x() + 0.5) * mBoxPixelsX / mWidth), mBoxPixelsX - 1);
+        const int boxY          = qMin(static_cast<int>((point.y() + 0.5) * mBoxPixelsY / mHeight), mBoxPixelsY - 1);
+        const QPointF source    = Unrotate((boxX + 0.5) * mBoxWidth / mBoxPixelsX, (boxY + 0.5) * mBoxHeight / mBoxPixelsY);
+        const int x             = qFloor(source.x());
+        const int y             = qFloor(source.y());
+        if (x < 0 || x >= mWidth || y < 0 || y >= mHeight)
+        {
+            return QPoint(-1, -1);
+        }
+        return QPoint(x, y);
+    }
+
+private:
+    // the bounding box position (x, y) back to the original image.
+    QPointF Unrotate(qreal x, qreal y) const
+    {
+        x += mMinX;
+        y += mMinY;
+        return QPointF(x * mCos + y * mSin, y * mCos - x * mSin);
+    }
+
+    int     mWidth;
+    int     mHeight;
+    bool    mIdentity;
+    qreal   mCos;
+    qreal   mSin;
+    qreal   mMinX;
+    qreal   mMinY;
+    qreal   mBoxWidth;
+    qreal   mBoxHeight;
+    int     mBoxPixelsX;
+    int     mBoxPixelsY;
+};
+
+FisheyeDistortionCorrection::FisheyeDistortionCorrection()
+    : mStages3(new Process3Stages())
+{
+    Initialize();
+}
+
+FisheyeDistortionCorrection::~FisheyeDistortionCorrection()
+{
+    delete mStages3;
+}
+
+FisheyeDistortionCorrection *FisheyeDistortionCorrection::getInstance() {
+   static FisheyeDistortionCorrection correction;
+   return &correction;
+}
+
+void FisheyeDistortionCorrection::Initialize() {
+    mRotationAngle = 0;
+    SetPictureSize(0,0);
+    SetOpticalCenterPoint(0, 0);
+    SetRotation(0);
+    SetCrop(0, 0, 0, 0);
+    SetInterpolation(RemapTable::NearestNeighbour);
+    SetTraversalOrder(RemapTable::RowMajorOrder);
+    SetSymmetricTables(false);
+    Set2rdCurveCoff(0,0);
+    SetFileLocation(QString(""));
+}
+
+void FisheyeDistortionCorrection::SetPictureSize(int width, int height) {
+    mWidth = width;
+    mHeight = height;
+    qDebug("PictureSize: %dx%d", width, height);
+}
+
+void FisheyeDistortionCorrection::SetFileLocation(QString filepath) {
+    mFilePath = filepath;
+    qDebug() << "FilePath: " << filepath << endl;
+}
+
+
+QImage FisheyeDistortionCorrection::DoImageRotate(QImage *image, int angleValue)
+{
+    const ImageRotation rotation(image->width(), image->height(), angleValue);
+    if (rotation.IsIdentity())
+    {
+        return image->copy();
+    }
+
+    // one remap pass, the table is kept for the next frame of the same size and angle.
+    if (mRotationTable.SourceWidth() != image->width() || mRotationTable.SourceHeight() != image->height()
+            || mRotationAngle != angleValue)
+    {
+        mRotationTable.Reset(image->width(), image->height(), image->width(), image->height());
+        for (int y = 0; y < image->height(); ++y)
+        {
+            for (int x = 0; x < image->width(); ++x)
+            {
+                const QPoint point = rotation.MapPixel(QPoint(x, y));
+                mRotationTable.SetEntry(x, y, point.x(), point.y());
+            }
+        }
+        mRotationAngle = angleValue;
+    }
+    QImage rotated;
+    mRotationTable.Apply(image, &rotated);
+    return rotated;
+}
+
+void FisheyeDistortionCorrection::SetOpticalCenterPoint(int x, int y)
+{
+    mOpticalCenterX = x;
+    mOpticalCenterY = y;
+    qDebug("OpticalCenterPoint = %dx%d", mOpticalCenterX, mOpticalCenterY);
+}
+
+void FisheyeDistortionCorrection::Set2rdCurveCoff(int hBase, int vBase)
+{
+    mHorizontalBase = hBase;
+    mVerticalBase   = vBase;
+    qDebug("Set 2rd Curve Coff: %d, %d", mHorizontalBase, mVerticalBase);
+}
+
+void FisheyeDistortionCorrection::SetRotation(int rotation)
+{
+    mRotation = rotation;
+    qDebug("Rotation= %d", rotation);
+}
+
+void FisheyeDistortionCorrection::SetCrop(int x, int y, int w, int h)
+{
+    mCropX = x;
+    mCropY = y;
+    mCropW = w;
+    mCropH = h;
+    qDebug("SetCrop: %d, %d, %d, %d", mCropX, mCropY, mCropW, mCropH);
+}
+
+void FisheyeDistortionCorrection::SetInterpolation(RemapTable::Interpolation mode)
+{
+    mInterpolation = mode;
+    qDebug("Interpolation = %s", (mode == RemapTable::Bilinear) ? "bilinear" : "nearest");
+}
+
+void FisheyeDistortionCorrection::SetTraversalOrder(RemapTable::TraversalOrder order)
+{
+    mTraversalOrder = order;
+    qDebug("TraversalOrder = %d", order);
+}
+
+void FisheyeDistortionCorrection::SetSymmetricTables(bool enable)
+{
+    mSymmetricTables = enable;
+    qDebug("SymmetricTables = %d", enable);
+}
+
+CorrectionParameters_t FisheyeDistortionCorrection::GetParameters() const
+{
+    CorrectionParameters_t params;
+    params.width            = mWidth;
+    params.height           = mHeight;
+    params.optical_center_x = mOpticalCenterX;
+    params.optical_center_y = mOpticalCenterY;
+    params.rotation         = mRotation;
+    params.horizontal_base  = mHorizontalBase;
+    params.vertical_base    = mVerticalBase;
+    params.crop_x           = mCropX;
+    params.crop_y           = mCropY;
+    params.crop_w           = mCropW;
+    params.crop_h           = mCropH;
+    params.interpolation    = mInterpolation;
+    params.traversal_order  = mTraversalOrder;
+    params.symmetric_tables = mSymmetricTables;
+    return params;
+}
+
+bool CorrectionParameters::operator==(const CorrectionParameters &other) const
+{
+    return width            == other.width
+        && height           == other.height
+        && optical_center_x == other.optical_center_x
+        && optical_center_y == other.optical_center_y
+        && rotation         == other.rotation
+        && horizontal_base  == other.horizontal_base
+        && vertical_base    == other.vertical_base
+        && crop_x           == other.crop_x
+        && crop_y           == other.crop_y
+        && crop_w           == other.crop_w
+        && crop_h           == other.crop_h
+        && interpolation    == other.interpolation
+        && traversal_order  == other.traversal_order
+        && symmetric_tables == other.symmetric_tables;
+}
+
+QImage FisheyeDistortionCorrection::GetDefaultImage()
+{
+    QImage image(mFilePath);
+    if (image.isNull())
+    {
+        qDebug() << "bad image input";
+        return image;
+    }
+    return image.convertToFormat(QImage::Format_RGB888);
+}
+
+double FisheyeDistortionCorrection::GetArchLensOfCircel(double a, double b, double r, int x)
+{
+    (void)b;
+    // original pos( a, b), ref pos (a, 0).
+    return ((asin(qAbs(a-x) / r))  * r);
+}
+
+double FisheyeDistortionCorrection::GetAngelOfTwoLines(double k1, double k2)
+{
+    if (k1 * k2 > -1.05 && k1 * k2 < -0.95)
+        return M_PI_4;
+    double tanangel = qAbs((k1 - k2) / ( 1 + k1 * k2));
+    double angle = atan(tanangel);
+    if (k1 * k2 < 0 && k1 * k2 > -1.0)
+        angle = M_PI - angle;
+    return angle;
+}
+
+void FisheyeDistortionCorrection::Process5(QImage *oriImage, QImage *output)
+{
+    const int width     = oriImage->width();
+    const int height    = oriImage->height();
+    // the optical center and radius should be calibrated alone.
+    const int oc_x      = (width -1) / 2;
+    const int oc_y      = (height -1) / 2;
+    const int max_arc   = oc_x;
+
+    // radius1 * PI / 2 =  max_arc
+    const int radius1   = static_cast<int>(max_arc / M_PI_2);
+    const int width1    = radius1 * 2;
+    const int height1   = radius1 * 2;
+    const int oc_x1     = radius1;
+    const int oc_y1     = radius1;
+
+    RemapTable table;
+    table.Reset(width, height, width1, height1);
+    for (int y1 = 0; y1 < height1; ++y1)
+    {
+        for (int x1 = 0; x1 < width1; ++x1)
+        {
+            double k    = (x1 - oc_x1) / static_cast<double>(y1 - oc_y1);
+            int dist1   = GetDistance(x1, y1, oc_x1, oc_y1);
+            // k        = (x - oc_x) / static_cast<double>(y - oc_y)
+            // int arc  = GetDistance(x, y, oc_x, oc_y);
+            // angle    = arc/max_arc * M_PI_2;
+            // dist1    = radius1 * (1 - cos(angle)).
+            // we can calculate the x, y.
+            //int arc     = static_cast<int>(asin(dist1/static_cast<double>(radius1)) * max_arc / M_PI_2);
+            int arc     = static_cast<int>(acos( 1 - dist1/static_cast<double>(radius1)) * max_arc / M_PI_2);
+            //arc         = static_cast<int>(qPow(arc/static_cast<double>(max_arc), 0.01) * arc);
+
+            int y = 0;
+            if ( y1 < oc_y1)
+            {
+                y = static_cast<int>(oc_y - arc / qSqrt(k * k + 1));
+            }
+            else
+            {
+                y = static_cast<int>(oc_y + arc/qSqrt(k * k + 1));
+            }
+            int x = static_cast<int>( (y - oc_y) * k + oc_x);
+
+            if (x < 0) x = 0;
+            if (x > width -1) x = width-1;
+
+            if (y < 0) y = 0;
+            if (y > height -1) y = height -1;
+            table.SetEntry(x1, y1, x, y);
+        }
+    }
+    table.Apply(oriImage, output);
+}
+
+void FisheyeDistortionCorrection::Process4(QImage *oriImage, QImage *hImage)
+{
+    const int width     = oriImage->width();
+    const int height    = oriImage->height();
+    
+    // the optical center and radius should be calibrated alone.
+    const int optical_center_x  = (width -1) / 2;
+    const int optical_center_y  = (height -1) / 2;
+    const int radius            = optical_center_x;
+    
+    qDebug(" image size = %dx%d", width, height);
+    qDebug(" image optical center point = %dx%d", optical_center_x, optical_center_y);
+    
+
+    const int width1            = AlignTo(static_cast<int>(radius * M_PI), 2);
+    const int height1           = width1;
+    const int optical_center_x1 = (width1-1) / 2;
+    const int optical_center_y1 = (height1-1) / 2;
+    const int radius1           = optical_center_x1;
+    //const int max_arc       = x1_width / 2;
+    //const int width_center  = max_arc -1;
+    //const int height_center = max_arc -1;
+    qDebug(" new Image size = %dx%d",width1, height1);
+    qDebug(" new image optical center point = %dx%d", optical_center_x1, optical_center_y1);
+
+    QPoint **array;
+    Create2DArray(array, height1, width1);
+
+    int dist_max    = optical_center_x;//GetDistance(optical_center_x, 0, optical_center_x, optical_center_y);
+    int dist1_max   = optical_center_x1;//GetDistance(optical_center_x1, 0, optical_center_x1, optical_center_y1);
+    qDebug("dist_max = %d, dist1_max1 = %d", dist_max, dist1_max);
+
+    for (int h1 = 0; h1 < height1; h1++)
+    {
+        for (int w1 = 0; w1 < width1; w1++)
+        {
+            int dist1 = GetDistance(w1, h1, optical_center_x1, optical_center_y1);
+            if (dist1 > dist1_max)
+            {
+                array[h1][w1].setX(0);
+                array[h1][w1].setY(0);
+            }
+            else
+            {
+                int x1 = w1;
+                int y1 = h1;
+                if ( y1 == optical_center_y1)
+                {
+                    array[h1][w1].setX(0);
+                    array[h1][w1].setY(0);
+                }
+                else
+                {
+                    double k1        = (x1 - optical_center_x1) / static_cast<double>(y1 - optical_center_y1);
+                    //k1            = (x - optical_center_x) / (y - optical_center_y);
+                    // cos(dist/dist_max * M_PI_2) = (dist1_max - dist1) / dist1_max
+
+                    //int distance    = static_cast<int>(acos((dist1_max - dist1) / static_cast<double>(dist1_max)) * dist_max / M_PI_2);
+
+                    // distance1 = sin(dist/dist_max * M_PI_2) * radius
+                    // int distance = static_cast<int>(asin(dist1 / static_cast<double>(radius)) * dist_max / M_PI_2);
+
+                    // dist1_max - dist1 = cos(dist /dist_max * M_PI_2)*radius
+                    int distance = static_cast<int>(acos((dist1_max - dist1) / static_cast<double>(radius1)) * dist_max / M_PI_2);
+                    // distance     = GetDistance(x, y, optical_center_x, optical_center_y);
+                    // int distance = static_cast<int>(dist1/static_cast<float>(dist1_max) * radius);
+                    // here we can calculate the x, y.
+                    int x = 0;
+                    int y = 0;
+                    if (y1 <optical_center_y1)
+                    {
+                        //x = optical_cen+-_x - distance/(1+k);
+                        y = static_cast<int>(optical_center_y - distance/qSqrt(1+k1*k1));
+
+                    }
+                    else
+                    {
+                        y = static_cast<int>(optical_center_y + distance/qSqrt(1+k1*k1));
+                    }
+
+                    x = static_cast<int>(k1 * ( y - optical_center_y) + optical_center_x);
+
+                    if (x < 0 || x > width || y < 0 || y > height)
+                    {
+                        array[h1][w1].setX(0);
+                        array[h1][w1].setY(0);
+                    }
+                    else
+                    {
+                        array[h1][w1].setX(x);
+                        array[h1][w1].setY(y);
+                    }
+                    if (x1 == 200)
+                    {
+                        qDebug("k1 = %f, x = %d, y = %d, x1 = %d, y1 = %d,dist = %d, dist1 =%d",
+                               k1, x, y, x1, y1, distance, dist1);
+                    }
+                }
+
+            }
+            
+        }
+    }
+    RemapTable table;
+    table.Reset(width, height, width1, height1);
+    for (int y = 0; y < height1; y++)
+    {
+        for (int x = 0; x < width1; x++)
+        {
+            table.SetEntry(x, y, array[y][x].x(), array[y][x].y());
+        }
+    }
+    table.Apply(oriImage, hImage);
+}
+
+int FisheyeDistortionCorrection::GetDistance(int x, int y, int x1, int y1)
+{
+    return static_cast<int>(qSqrt((x - x1) * (x -x1) + (y - y1) * (y - y1)));
+}
+
+int FisheyeDistortionCorrection::GetDistance2(int x, int y, int x1, int y1)
+{
+    return static_cast<int>((x1 - x1) * (x - x1) + (y - y1) * (y - y1));
+}
+
+template<typename T>
+void FisheyeDistortionCorrection::Create2DArray(T **&array, int height, int width)
+{
+    array = new T * [height];
+    for (int h = 0; h < height; ++h)
+    {
+        array[h] = new T [width];
+    }
+}
+
+template <typename T>
+void FisheyeDistortionCorrection::Destroy2DArray(T **&array, int height)
+{
+    if (array != NULL)
+    {
+        for (int h = 0; h < height; h++)
+        {
+            delete [] array[h];
+        }
+    }
+    delete[] array;
+}
+
+int FisheyeDistortionCorrection::GetMapWidth3(const CorrectionParameters_t &params)
+{
+    const int opticalCenterW = (params.optical_center_x == 0) ? ((params.width -1) / 2) : params.optical_center_x;
+    return AlignTo(static_cast<int>(opticalCenterW * M_PI), 2);
+}
+
+/**
+ * HorizontalMapRow3 : one circle row of GenerateHorizontalMap3(), the row h
+ * and its mirror are stored when they are in the map.
+ **/
+typedef struct HorizontalMapRow3
+{
+    int     h;
+    bool    storeRow;
+    bool    storeFlip;
+    double  b;
+    double  r;
+} HorizontalMapRow3_t;
+
+/**
+ * HorizontalMap3 : the map GenerateHorizontalMap3() fills, columns holds
+ * the floats 0 .. width - 1 for the CircleKernel.
+ **/
+typedef struct HorizontalMap3
+{
+    int             width;
+    int             height;
+    int             opticalCenterW;
+    int             mapWidth;
+    int             firstRow;
+    const float    *columns;
+    QPoint         *mapped;
+    QPointF        *subPixel;
+} HorizontalMap3_t;
+
+static void GenerateHorizontalRow3(const HorizontalMap3_t &map, const HorizontalMapRow3_t &row)
+{
+    const int width             = map.width;
+    const int height            = map.height;
+    const int opticalCenterW    = map.opticalCenterW;
+    const int mapWidth          = map.mapWidth;
+    const int h                 = row.h;
+
+    CircleRow_t circle;
+    circle.a        = opticalCenterW;
+    circle.r        = row.r;
+    circle.rMinusA  = row.r - opticalCenterW;
+    circle.bMinusR  = row.b - row.r;
+
+    QVector<float> arcLength(opticalCenterW);
+    QVector<float> heights(width);
+    CircleKernel::ArcLengths()(arcLength.data(), opticalCenterW, circle);
+    CircleKernel::Heights()(heights.data(), map.columns, width, circle);
+
+    if (h == 0)
+    {
+        qDebug("arctan = %lf", asin(opticalCenterW / row.r));
+        qDebug("a = %d, b = %f, r = %f", opticalCenterW, row.b, row.r);
+        qDebug("the maxHorizontalArcLengh = %d, arcLength = %f", mapWidth, arcLength[0]);
+    }
+
+    int start       = 0;
+    int curr        = 0;
+    int baseX       = (h - map.firstRow) * mapWidth;
+    int baseXFlip   = (height -1 - h - map.firstRow) * mapWidth;
+    // the end of the run of every column, for the sub-pixel points.
+    QVector<int> runEnd(map.subPixel != NULL ? width : 0);
+
+    for (int w = 0; w < width; ++w)
+    {
+        int x0                  = w;
+        int y0                  = qBound(0, static_cast<int>(heights[w]), height - 1);
+        int x0Flip              = w;
+        int y0Flip              = height - 1 - y0;
+        // the right border runs past the mirrored arc table, clamp it to the outmost arc.
+        int arc                 = qBound(0, (w < opticalCenterW) ? w : ( 2 * opticalCenterW - w - 1), opticalCenterW - 1);
+        float arcLengthx        = arcLength[arc];
+
+        // do arcLengthx compensation, it will better for strength
+        const float ratio       = arcLengthx / arcLength[0];
+        arcLengthx = (1 + 0.6f * ratio * ratio * ratio) * arcLengthx;
+        if ( x0 < opticalCenterW )
+        {
+            curr = mapWidth / 2 - static_cast<int>(arcLengthx);
+        }
+        else
+        {
+            curr = mapWidth / 2 + static_cast<int>(arcLengthx);
+        }
+        curr = qBound(0, curr, mapWidth - 1);
+        if (curr < start) curr = start;
+
+        for (int k = start; k < curr; ++k)
+        {
+            if (row.storeRow)
+            {
+                map.mapped[baseX + k].setX(x0);
+                map.mapped[baseX + k].setY(y0);
+            }
+            if (row.storeFlip)
+            {
+                map.mapped[baseXFlip + k].setX(x0Flip);
+                map.mapped[baseXFlip + k].setY(y0Flip);
+            }
+        }
+        if (map.subPixel != NULL)
+        {
+            runEnd[w] = curr;
+        }
+        start = curr;
+    }
+
+    if (map.subPixel == NULL || start == 0)
+    {
+        return;
+    }
+
+    /**
+     * the run [start, curr) is filled by the column w, so it covers the
+     * source pixel [w - 0.5, w + 0.5). spread the pixel centers of the
+     * run over it and put them back on the circle, the whole row at once.
+     **/
+    QVector<double> pointX(start);
+    QVector<float> pointXf(start);
+    QVector<float> pointY(start);
+    for (int w = 0, k = 0; w < width; ++w)
+    {
+        const int runStart = k;
+        for (; k < runEnd[w]; ++k)
+        {
+            pointX[k]   = qMax(0.0, w - 0.5 + (k - runStart + 0.5) / (runEnd[w] - runStart));
+            pointXf[k]  = pointX[k];
+        }
+    }
+    CircleKernel::Heights()(pointY.data(), pointXf.constData(), start, circle);
+    for (int k = 0; k < start; ++k)
+    {
+        const double y = qBound(0.0, static_cast<double>(pointY[k]), height - 1.0);
+        if (row.storeRow)
+        {
+            map.subPixel[baseX + k] = QPointF(pointX[k], y);
+        }
+        if (row.storeFlip)
+        {
+            map.subPixel[baseXFlip + k] = QPointF(pointX[k], height - 1 - y);
+        }
+    }
+}
+
+class HorizontalMapJob : public WorkerPool::Job
+{
+public:
+    HorizontalMapJob(const HorizontalMap3_t &map, const QVector<HorizontalMapRow3_t> &rows)
+        : mMap(map),
+          mRows(rows)
+    {
+    }
+
+    void Run(int index)
+    {
+        GenerateHorizontalRow3(mMap, mRows[index]);
+    }
+
+private:
+    const HorizontalMap3_t                 &mMap;
+    const QVector<HorizontalMapRow3_t>     &mRows;
+};
+
+int FisheyeDistortionCorrection::GenerateHorizontalMap3(const CorrectionParameters_t &params, QVector<QPoint> *mappedX,
+                                                        QVector<QPointF> *subPixelX, int firstRow, int rowCount)
+{
+    const int width                 = params.width;
+    const int height                = params.height;
+    const int opticalCenterW        = (params.optical_center_x == 0) ? ((width -1) / 2) : params.optical_center_x;
+    const int opticalCenterH        = (params.optical_center_y == 0) ? ((height -1) / 2) : params.optical_center_y;
+    const int maxHorizontalArcLengh = GetMapWidth3(params);
+    if (rowCount < 0)
+    {
+        rowCount = height - firstRow;
+    }
+    const int lastRow               = firstRow + rowCount;
+
+    /**
+     * do horizontal correction.
+     * suspect the opitial pointer: (opticalCenterW, opticalCenterW).
+     * the coordinate system: x aix <---> width; y aix <---> height.
+     */
+
+    mappedX->fill(QPoint(0, 0), maxHorizontalArcLengh * rowCount);
+    QPointF *subPixel           = NULL;
+    if (subPixelX != NULL)
+    {
+        subPixelX->fill(QPointF(-1, -1), maxHorizontalArcLengh * rowCount);
+        subPixel = subPixelX->data();
+    }
+    const int verticalBase      = (params.vertical_base == 0) ? height / 4: params.vertical_base;
+
+    // the circles of the rows, the rows themselves are independent.
+    QVector<HorizontalMapRow3_t> rows;
+    for (int h = 0; h <= opticalCenterH; ++h)
+    {
+        /**
+         * the euqtion should locate on these three points.
+         * then, we can calculate the coff: a , b , r
+         * here, the coffH is tuneable value according the the h
+         **/
+
+        // h / (height / 2) = (coffH - hBase) / (height/2 - hBase).
+
+        // Notice: here plus 1 is to avoid the circel equation error at the critical status,
+        double coffH    = h * (opticalCenterH - verticalBase + 1) / static_cast<double>(opticalCenterH) + verticalBase;
+
+        if (std::abs(h - coffH) < 1)
+        {
+            qDebug("h = %d, coffH = %lf", h , coffH);
+            h = h +1;
+            //continue;
+        }
+        // the rows out of [firstRow, lastRow) are never stored, skip the rows which have no row to store.
+        HorizontalMapRow3_t row;
+        row.h           = h;
+        row.storeRow    = (h >= firstRow && h < lastRow);
+        row.storeFlip   = (height - 1 - h >= firstRow && height - 1 - h < lastRow && h != height - 1 - h);
+        if (!row.storeRow && !row.storeFlip)
+        {
+            continue;
+        }
+        double a = opticalCenterW;
+        row.b    = (h + coffH - a * a / static_cast<double>(h- coffH)) / 2;
+        row.r    = pow((h - row.b) * (h - row.b), 0.5);
+
+        if ( h + 10 > opticalCenterH)
+        {
+            qDebug("a = %lf, b = %lf, c = %lf", a, row.b, row.r);
+        }
+        rows.append(row);
+    }
+
+    /**
+     * with the optical center off the middle, a row and the mirror of
+     * another one can be the same map row, the later one overwrites it.
+     * keep that order by generating such maps row after row.
+     **/
+    QVector<bool> stored(rowCount, false);
+    bool overlap = false;
+    for (int n = 0; n < rows.size(); ++n)
+    {
+        const int rowIndex  = rows[n].h - firstRow;
+        const int flipIndex = height - 1 - rows[n].h - firstRow;
+        if (rows[n].storeRow)
+        {
+            overlap = overlap || stored[rowIndex];
+            stored[rowIndex] = true;
+        }
+        if (rows[n].storeFlip)
+        {
+            overlap = overlap || stored[flipIndex];
+            stored[flipIndex] = true;
+        }
+    }
+
+    QVector<float> columns(width);
+    for (int w = 0; w < width; ++w)
+    {
+        columns[w] = w;
+    }
+    HorizontalMap3_t map;
+    map.width           = width;
+    map.height          = height;
+    map.opticalCenterW  = opticalCenterW;
+    map.mapWidth        = maxHorizontalArcLengh;
+    map.firstRow        = firstRow;
+    map.columns         = columns.constData();
+    map.mapped          = mappedX->data();
+    map.subPixel        = subPixel;
+
+    HorizontalMapJob job(map, rows);
+    if (overlap)
+    {
+        for (int n = 0; n < rows.size(); ++n)
+        {
+            job.Run(n);
+        }
+    }
+    else
+    {
+        WorkerPool::getInstance()->Run(&job, rows.size());
+    }
+
+    qDebug("Horizontal map generated: %dx%d, rows %d - %d", maxHorizontalArcLengh, height, firstRow, lastRow - 1);
+    return maxHorizontalArcLengh;
+}
+
+QRect FisheyeDistortionCorrection::GetCropRect3(const CorrectionParameters_t &params, int mapWidth)
+{
+    // keep the QImage::copy() behaviour: a null crop rect means the whole image.
+    QRect crop(params.crop_x, params.crop_y, params.crop_w, params.crop_h);
+    if (crop.isNull())
+    {
+        crop = QRect(0, 0, mapWidth, params.height);
+    }
+    return crop;
+}
+
+/**
+ * sample one row of the sub-pixel horizontal map at the position x,
+ * the points which are not mapped fall back to the mapped neighbour.
+ **/
+static QPointF SampleSubPixelRow(const QPointF *row, int mapWidth, double x)
+{
+    const int x0        = qBound(0, qFloor(x), mapWidth - 1);
+    const int x1        = qMin(x0 + 1, mapWidth - 1);
+    const double t      = qBound(0.0, x - x0, 1.0);
+    const QPointF &p0   = row[x0];
+    const QPointF &p1   = row[x1];
+    const bool valid0   = (p0.x() >= 0);
+    const bool valid1   = (p1.x() >= 0);
+    if (valid0 && valid1)
+    {
+        return p0 + (p1 - p0) * t;
+    }
+    if (valid0)
+    {
+        return p0;
+    }
+    if (valid1)
+    {
+        return p1;
+    }
+    // same as the nearest map, which leaves these points at (0, 0).
+    return QPointF(0, 0);
+}
+
+void FisheyeDistortionCorrection::GenerateVerticalMap3(const CorrectionParameters_t &params, int mapWidth,
+                                                       const QRect &region, QVector<int> *mappedW,
+                                                       QVector<double> *subPixelW)
+{
+    /**
+     *  the vertical correction.
+     *  equation: y = a*x*x + b*x + c.
+     *  it maps vImage(w, h) to hImage(w1, h).
+     *  only the columns and the rows of the region are computed.
+     **/
+    const int width         = params.width;
+    const int height        = params.height;
+    const int halfWidth     = mapWidth / 2;
+    double base_offset      = (params.horizontal_base == 0) ? width / 4.0: params.horizontal_base;
+    double center_offset    = mapWidth / 2;
+    const int regionX0      = region.x();
+    const int regionY0      = qMax(region.y(), 0);
+    const int regionX1      = region.x() + region.width();
+    const int regionY1      = qMin(region.y() + region.height(), height);
+    const int regionWidth   = region.width();
+
+    mappedW->fill(-1, region.width() * region.height());
+    if (subPixelW != NULL)
+    {
+        subPixelW->fill(-1, region.width() * region.height());
+    }
+    for (int w = 0; w < halfWidth; ++w)
+    {
+        const int wFlip     = mapWidth - w - 1;
+        const bool inside   = (w >= regionX0 && w < regionX1);
+        const bool flipIn   = (wFlip >= regionX0 && wFlip < regionX1);
+        if (!inside && !flipIn) continue;
+
+        double offset = (w / center_offset) * (center_offset - base_offset) + base_offset;
+        double x0   = height/2.0;
+        double y0   = w;
+
+        double x2   = height;
+
+        double c    = offset;
+        double a    = (y0 - c) / (x0 * x0 - x0*x2);
+        double b    = -a*x2;
+        if (fabs(w -c) < 0.1) continue;
+        for (int h = regionY0; h < regionY1; ++h)
+        {
+            int x = h;
+            double yf = a * x * x + b * x + c;
+            int y = static_cast<int>(yf);
+
+            int w1 = y;
+            if (w1 > mapWidth -1)
+                w1 = mapWidth -1;
+            if (w1 < 0)
+                continue;
+
+            const int row = (h - region.y()) * regionWidth;
+            if (inside)
+            {
+                (*mappedW)[row + w - regionX0]     = w1;
+            }
+            if (flipIn)
+            {
+                (*mappedW)[row + wFlip - regionX0] = mapWidth - w1 - 1;
+            }
+            if (subPixelW != NULL)
+            {
+                // hImage pixel w1 covers [w1, w1 + 1), its center is w1 + 0.5.
+                double s = qBound(0.0, yf - 0.5, mapWidth - 1.0);
+                if (inside)
+                {
+                    (*subPixelW)[row + w - regionX0]       = s;
+                }
+                if (flipIn)
+                {
+                    (*subPixelW)[row + wFlip - regionX0]   = mapWidth - 1 - s;
+                }
+            }
+        }
+    }
+}
+
+void FisheyeDistortionCorrection::ComposeCorrectionTable3(const CorrectionParameters_t &params,
+                                                          const QVector<QPoint> &mappedX,
+                                                          int mapWidth,
+                                                          const QRect &region,
+                                                          const QVector<int> &mappedW,
+                                                          RemapTable *table,
+                                                          const QVector<QPointF> *subPixelX,
+                                                          const QVector<double> *subPixelW,
+                                                          int mapFirstRow)
+{
+    const int width         = params.width;
+    const int height        = params.height;
+    const int mapRows       = (mapWidth > 0) ? mappedX.size() / mapWidth : 0;
+    const int regionWidth   = region.width();
+    const bool bilinear     = (subPixelX != NULL && subPixelW != NULL);
+
+    // mappedW is composed with mappedX directly, so vImage reads the rotated image.
+    // the map points are in the rotated image, the table reads the original one.
+    const ImageRotation rotation(width, height, params.rotation);
+    table->Reset(width, height, region.width(), region.height(),
+                 bilinear ? RemapTable::Bilinear : RemapTable::NearestNeighbour);
+    for (int y = 0; y < region.height(); ++y)
+    {
+        const int h = region.y() + y;
+        if (h < 0 || h >= height) continue;
+        if (h < mapFirstRow || h >= mapFirstRow + mapRows)
+        {
+            qDebug("correction table: the row %d is not in the horizontal map", h);
+            continue;
+        }
+        const int mapRow = (h - mapFirstRow) * mapWidth;
+        for (int x = 0; x < region.width(); ++x)
+        {
+            const int w = region.x() + x;
+            if (w < 0 || w >= mapWidth) continue;
+            const int w1 = mappedW[y * regionWidth + x];
+            if (w1 < 0) continue;
+            if (bilinear)
+            {
+                const QPointF point = rotation.Map(SampleSubPixelRow(subPixelX->constData() + mapRow, mapWidth,
+                                                                     (*subPixelW)[y * regionWidth + x]));
+                table->SetSubPixelEntry(x, y, point.x(), point.y());
+                continue;
+            }
+            const QPoint point = rotation.MapPixel(mappedX[mapRow + w1]);
+            table->SetEntry(x, y, point.x(), point.y());
+        }
+    }
+    qDebug("correction table generated: %dx%d", region.width(), region.height());
+}
+
+void FisheyeDistortionCorrection::GenerateCorrectionTable3(const CorrectionParameters_t &params,
+                                                           const QVector<QPoint> &mappedX,
+                                                           int mapWidth,
+                                                           const QRect &region,
+                                                           RemapTable *table,
+                                                           const QVector<QPointF> *subPixelX,
+                                                           int mapFirstRow)
+{
+    // the hImage column of every region pixel, and the same in the sub-pixel
+    // position of hImage, only for the bilinear table.
+    QVector<int> mappedW;
+    QVector<double> subPixelW;
+    GenerateVerticalMap3(params, mapWidth, region, &mappedW, (subPixelX != NULL) ? &subPixelW : NULL);
+    ComposeCorrectionTable3(params, mappedX, mapWidth, region, mappedW, table, subPixelX,
+                            (subPixelX != NULL) ? &subPixelW : NULL, mapFirstRow);
+}
+
+/**
+ * the cancel flag of GenerateCorrectionTable3(), the table is cleared once it is set.
+ **/
+static bool IsCancelled(const QAtomicInt *cancelled, RemapTable *table)
+{
+    if (cancelled == NULL || cancelled->loadAcquire() == 0)
+    {
+        return false;
+    }
+    qDebug("correction table: cancelled");
+    table->Clear();
+    return true;
+}
+
+bool FisheyeDistortionCorrection::GenerateCorrectionTable3(const CorrectionParameters_t &params, RemapTable *table,
+                                                           const QAtomicInt *cancelled)
+{
+    QVector<QPoint> mappedX;
+    QVector<QPointF> subPixelX;
+    QVector<int> mappedW;
+    QVector<double> subPixelW;
+    const bool bilinear = (params.interpolation == RemapTable::Bilinear);
+    const QRect crop    = GetCropRect3(params, GetMapWidth3(params));
+
+    // only the rows of the crop are generated.
+    const int firstRow  = qBound(0, crop.y(), params.height);
+    const int rowCount  = qBound(firstRow, crop.y() + crop.height(), params.height) - firstRow;
+    const int mapWidth  = GenerateHorizontalMap3(params, &mappedX, bilinear ? &subPixelX : NULL, firstRow, rowCount);
+    if (IsCancelled(cancelled, table))
+    {
+        return false;
+    }
+    GenerateVerticalMap3(params, mapWidth, crop, &mappedW, bilinear ? &subPixelW : NULL);
+    if (IsCancelled(cancelled, table))
+    {
+        return false;
+    }
+    ComposeCorrectionTable3(params, mappedX, mapWidth, crop, mappedW, table, bilinear ? &subPixelX : NULL,
+                            bilinear ? &subPixelW : NULL, firstRow);
+    if (IsCancelled(cancelled, table))
+    {
+        return false;
+    }
+    table->SetTraversalOrder(params.traversal_order);
+    return true;
+}
+
+void FisheyeDistortionCorrection::GenerateHorizontalTable3(const CorrectionParameters_t &params,
+                                                           const QVector<QPoint> &mappedX,
+                                                           const QVector<QPointF> *subPixelX,
+                                                           int mapWidth,
+                                                           RemapTable *table)
+{
+    const ImageRotation rotation(params.width, params.height, params.rotation);
+    table->Reset(params.width, params.height, mapWidth, params.height,
+                 (subPixelX != NULL) ? RemapTable::Bilinear : RemapTable::NearestNeighbour);
+    if (subPixelX != NULL)
+    {
+        for (int h = 0; h < params.height; ++h)
+        {
+            for (int w = 0; w < mapWidth; ++w)
+            {
+                const QPointF point = rotation.Map(SampleSubPixelRow(subPixelX->constData() + h * mapWidth,
+                                                                     mapWidth, w));
+                table->SetSubPixelEntry(w, h, point.x(), point.y());
+            }
+        }
+    }
+    else
+    {
+        for (int h = 0; h < params.height; ++h)
+        {
+            for (int w = 0; w < mapWidth; ++w)
+            {
+                const QPoint point = rotation.MapPixel(mappedX[h * mapWidth + w]);
+                table->SetEntry(w, h, point.x(), point.y());
+            }
+        }
+    }
+}
+
+void FisheyeDistortionCorrection::GenerateTables3(const CorrectionParameters_t &params, bool diagnostics)
+{
+    RemapTableCache *cache = RemapTableCache::getInstance();
+    mCorrectionSymmetric3.Clear();
+    mVerticalSymmetric3.Clear();
+    mHorizontalSpans3.Clear();
+    if (!diagnostics)
+    {
+        cache->CorrectionTable3(params, &mCorrectionTable3);
+        mHorizontalTable3.Clear();
+        mVerticalTable3.Clear();
+    }
+    else
+    {
+        if (!cache->Find(params, RemapTableCache::CorrectionTable, &mCorrectionTable3)
+                || !cache->Find(params, RemapTableCache::HorizontalTable, &mHorizontalTable3)
+                || !cache->Find(params, RemapTableCache::VerticalTable, &mVerticalTable3))
+        {
+            mStages3->Update(params);
+            mCorrectionTable3   = mStages3->CorrectionTable();
+            mHorizontalTable3   = mStages3->HorizontalTable();
+            mVerticalTable3     = mStages3->VerticalTable();
+            cache->Insert(params, RemapTableCache::CorrectionTable, mCorrectionTable3);
+            cache->Insert(params, RemapTableCache::HorizontalTable, mHorizontalTable3);
+            cache->Insert(params, RemapTableCache::VerticalTable, mVerticalTable3);
+        }
+        // the horizontal map is filled by runs, keep it as spans.
+        if (params.interpolation != RemapTable::Bilinear && mHorizontalSpans3.Build(mHorizontalTable3))
+        {
+            mHorizontalTable3.Clear();
+        }
+        if (params.symmetric_tables && mVerticalSymmetric3.Build(mVerticalTable3))
+        {
+            mVerticalTable3.Clear();
+        }
+    }
+    if (params.symmetric_tables && mCorrectionSymmetric3.Build(mCorrectionTable3))
+    {
+        mCorrectionTable3.Clear();
+    }
+    mTable3Params = params;
+}
+
+// here, we suspect the standard equation of the circle satisfied the our requirement.
+// (x -a) * (x -a) + (y -b) * (y -b) = r * r;
+void FisheyeDistortionCorrection::Process3(QImage *oriImage, QImage *rotateImage, QImage *hImage, QImage *vImage, QImage *smoothImage, QImage *strecthImage)
+{
+
+
+    const int width     = oriImage->width();
+    const int height    = oriImage->height();
+
+    if (width != mWidth || height != mHeight)
+    {
+        qDebug("mismatch: set size: %dx%d, image size: %dx%d", mWidth, mHeight, width, height);
+        return;
+    }
+    qDebug("original image size = %dx%d", width, height);
+
+
+    /**
+     * we need do the rotate before the lend distortion correction.
+     * our calculate ldc based on the iamge coordinate system.
+     * we separate the correction with the horizontal base on image x aix.
+     * and the vertical base on image y aix.
+     * so, we sould make sure the image distortion without angle shift.
+     **/
+
+    if (rotateImage != NULL)
+    {
+        *rotateImage = DoImageRotate(oriImage, mRotation);
+        qDebug("rotate Image size: %d, %d", rotateImage->width(), rotateImage->height());
+    }
+
+    /**
+     * the rotation, the horizontal circle correction, the vertical parabola
+     * correction and the crop are composed into one remap table, which only
+     * depends on the parameters. so it is generated once per parameter set
+     * and every frame is corrected by one gather pass from the original image.
+     * rotateImage, hImage, vImage and smoothImage are only for the debug views,
+     * they are generated when the caller asks for them.
+     */
+    const CorrectionParameters_t params = GetParameters();
+    const bool diagnostics = (hImage != NULL || vImage != NULL || smoothImage != NULL);
+    if ((mCorrectionTable3.IsNull() && mCorrectionSymmetric3.IsNull()) || mTable3Params != params
+            || (diagnostics && mVerticalTable3.IsNull() && mVerticalSymmetric3.IsNull()))
+    {
+        GenerateTables3(params, diagnostics);
+    }
+
+    if (hImage != NULL || smoothImage != NULL)
+    {
+        QImage horizonCorrection;
+        if (!mHorizontalSpans3.IsNull())
+        {
+            mHorizontalSpans3.Apply(oriImage, &horizonCorrection);
+        }
+        else
+        {
+            mHorizontalTable3.Apply(oriImage, &horizonCorrection);
+        }
+        if (hImage != NULL)
+        {
+            *hImage = horizonCorrection;
+        }
+        if (smoothImage != NULL)
+        {
+            *smoothImage = horizonCorrection.copy(GetCropRect3(params, horizonCorrection.width()));
+        }
+    }
+    if (vImage != NULL)
+    {
+        if (!mVerticalSymmetric3.IsNull())
+        {
+            mVerticalSymmetric3.Apply(oriImage, vImage);
+        }
+        else
+        {
+            mVerticalTable3.Apply(oriImage, vImage);
+        }
+    }
+
+    if (!mCorrectionSymmetric3.IsNull())
+    {
+        mCorrectionSymmetric3.Apply(oriImage, strecthImage);
+    }
+    else
+    {
+        mCorrectionTable3.Apply(oriImage, strecthImage);
+    }
+    qDebug("strecth image wxh = %dx%d", strecthImage->width(), strecthImage->height());
+}
+
+
+/**
+ * the hImage pixels the vertical map of Process1/2 reads, mappedY is the
+ * crop of vImage. the crop pixels out of vImage and the points out of
+ * hImage read nothing.
+ **/
+static QRect VerticalMapSourceRect(const QVector<QPoint> &mappedY, const QRect &crop, const QSize &vImageSize,
+                                   const QSize &hImageSize)
+{
+    const QRect vImageRect(QPoint(0, 0), vImageSize);
+    const QRect hImageRect(QPoint(0, 0), hImageSize);
+    int left    = hImageSize.width();
+    int top     = hImageSize.height();
+    int right   = -1;
+    int bottom  = -1;
+    for (int y = 0; y < crop.height(); ++y)
+    {
+        for (int x = 0; x < crop.width(); ++x)
+        {
+            const QPoint &point = mappedY[y * crop.width() + x];
+            if (!vImageRect.contains(crop.x() + x, crop.y() + y) || !hImageRect.contains(point))
+            {
+                continue;
+            }
+            left    = qMin(left, point.x());
+            top     = qMin(top, point.y());
+            right   = qMax(right, point.x());
+            bottom  = qMax(bottom, point.y());
+        }
+    }
+    return (right < left) ? QRect() : QRect(left, top, right - left + 1, bottom - top + 1);
+}
+
+/**
+ * the table of the crop of vImage, mappedY holds the hImage points of the
+ * crop. with mappedX (the horizontalRegion of hImage) the two maps are
+ * composed, the table reads oriImage, otherwise hImage.
+ **/
+static void SetVerticalCropEntries(RemapTable *table, const QVector<QPoint> &mappedY, const QRect &crop,
+                                   const QSize &vImageSize, const QVector<QPoint> *mappedX,
+                                   const QRect &horizontalRegion)
+{
+    const QRect vImageRect(QPoint(0, 0), vImageSize);
+    for (int y = 0; y < crop.height(); ++y)
+    {
+        for (int x = 0; x < crop.width(); ++x)
+        {
+            const QPoint &point = mappedY[y * crop.width() + x];
+            if (!vImageRect.contains(crop.x() + x, crop.y() + y))
+            {
+                table->SetInvalid(x, y);
+            }
+            else if (mappedX == NULL)
+            {
+                table->SetEntry(x, y, point.x(), point.y());
+            }
+            else if (!horizontalRegion.contains(point))
+            {
+                table->SetInvalid(x, y);
+            }
+            else
+            {
+                const QPoint &source = (*mappedX)[(point.y() - horizontalRegion.y()) * horizontalRegion.width()
+                                                  + point.x() - horizontalRegion.x()];
+                table->SetEntry(x, y, source.x(), source.y());
+            }
+        }
+    }
+}
+
+// here, we suspect the standard equation of the circle satisfied the our requirement. 
+// (x -a) * (x -a) + (y -b) * (y -b) = r * r;
+void FisheyeDistortionCorrection::Process2(QImage *oriImage, QImage *rotateImage, QImage *hImage, QImage *vImage, QImage *smoothImage, QImage *strecthImage)
+{
+    const int width     = oriImage->width();
+    const int height    = oriImage->height();
+
+    if (width != mWidth || height != mHeight)
+    {
+        qDebug("mismatch: set size: %dx%d, image size: %dx%d", mWidth, mHeight, width, height);
+        return;
+    }
+    qDebug("original image size = %dx%d", width, height);
+
+    if (rotateImage != NULL)
+    {
+        *rotateImage = DoImageRotate(oriImage, mRotation);
+        qDebug("rotate Image size: %d, %d", rotateImage->width(), rotateImage->height());
+    }
+
+    const int opticalCenterW        = (mOpticalCenterX == 0) ? ((width -1) / 2) : mOpticalCenterX;
+    const int opticalCenterH        = (mOpticalCenterY == 0) ? ((height -1) / 2) : mOpticalCenterY;
+    const int maxVerticalArcLength   = AlignTo(opticalCenterH * M_PI, 2);
+    const int maxHorizontalArcLengh = AlignTo(opticalCenterW * M_PI, 2);
+    qDebug("optical center point: %dx%d", opticalCenterW, opticalCenterH);
+    qDebug("maxVerticalArcLength = %d, maxHorizontalArcLength = %d",
+           maxVerticalArcLength, maxHorizontalArcLengh);
+
+    // the crop of vImage, a null crop is the whole vImage, like QImage::copy().
+    QRect crop(mCropX, mCropY, mCropW, mCropH);
+    qDebug("cropX =%d, cropY = %d, cropW = %d, cropH = %d", crop.x(), crop.y(), crop.width(), crop.height());
+    if (crop.isNull())
+    {
+        crop = QRect(0, 0, maxHorizontalArcLengh, maxVerticalArcLength);
+    }
+    const QSize hImageSize(maxHorizontalArcLengh, height);
+    const QSize vImageSize(maxHorizontalArcLengh, maxVerticalArcLength);
+    QImage horizontalImage;
+    if (hImage == NULL && vImage != NULL)
+    {
+        hImage = &horizontalImage;
+    }
+    // without the vImage view only the crop of the vertical map is generated.
+    const QRect verticalRegion = (vImage != NULL) ? QRect(QPoint(0, 0), vImageSize) : crop;
+
+    /**
+     * do vertical correction, circle.
+     * suspect the opitial pointer: (w/2, h/2).
+     * the coordinate system: x aix <---> height, y aix <---> width.
+     * three point should be:
+     *  (0, coffW), (height / 2, y'), (height, coffW).
+     * here, the y' should be changed according to the peak of the curve.
+     *       the coffW is the dynamic change according the picture view.
+     */
+
+    QVector<QPoint> mappedY(verticalRegion.width() * verticalRegion.height());
+    // the arc lengths of one circle, both passes use it.
+    QVector<float> arcLength(qMax(opticalCenterW, opticalCenterH));
+    int horizontalBase          = (mHorizontalBase == 0) ? maxHorizontalArcLengh / 8 : mHorizontalBase;
+    for (int w = 0; w < maxHorizontalArcLengh / 2; ++w)
+    {
+        const int wFlip         = maxHorizontalArcLengh - 1 - w;
+        const bool column       = (w >= verticalRegion.left() && w <= verticalRegion.right());
+        const bool columnFlip   = (wFlip >= verticalRegion.left() && wFlip <= verticalRegion.right());
+        if (!column && !columnFlip)
+        {
+            continue;
+        }
+
+        /**
+         * the equation should locate these three points.
+         * (0, coffW), (opticalCenterH, w), (2 * opticalCenterH,  coffW)
+         **/
+        //  coffW / (width / 2 - baseW) = w / (width / 2)
+        int coffW       = w * (maxHorizontalArcLengh / 2 - horizontalBase) / (maxHorizontalArcLengh / 2) + horizontalBase;
+
+        float a = opticalCenterH;
+        float b = (w + coffW - a * a / (float)(w -coffW)) / 2;
+        float r = pow((w - b) * (w - b), 0.5f);
+
+        //qDebug("a = %f, b = %f, c = %f", a, b, c);
+        for (int arc = 0; arc < opticalCenterH; arc++)
+        {
+            arcLength[arc] = GetArchLensOfCircel(a, b, r, arc);
+        }
+
+        int start = 0;
+        int curr  = 0;
+        for (int h = 0; h < height; ++h)
+        {
+            int x0                  = h;
+            int y0                  = Range(b - pow (pow(r, 2) - pow( x0 - a, 2), 0.5f), 0, width-1);
+            int x0Flip              = h;
+            int y0Flip              = maxHorizontalArcLengh - 1 - y0;
+
+            // the arc length table ends before the optical center.
+            int arc = (x0 < opticalCenterH) ? x0 : ( 2 * opticalCenterH - x0);
+            arc     = qBound(0, arc, opticalCenterH - 1);
+            int arcLengthY = arcLength[arc];
+            if ( h == 0 && w == 0)
+            {
+                qDebug("a = %f, b = %f, r = %f", a, b, r);
+                qDebug("the maxVerticalArcLength= %d, arcLength = %d", maxVerticalArcLength, arcLengthY);
+            }
+
+            if ( x0 < opticalCenterH)
+            {
+                curr = maxVerticalArcLength / 2 - (int)arcLengthY;
+            }
+            else
+            {
+                curr = maxVerticalArcLength / 2 + (int)arcLengthY;
+            }
+
+            curr = Range(curr, 0, maxVerticalArcLength -1);
+            // only the rows of the region are stored.
+            const int first = qMax(start, verticalRegion.top());
+            const int last  = qMin(curr, verticalRegion.bottom() + 1);
+            for ( int k = first; k < last; ++k)
+            {
+                const int offset = (k - verticalRegion.top()) * verticalRegion.width() - verticalRegion.left();
+                if (column)
+                {
+                    mappedY[offset + w] = QPoint(y0, x0);
+                }
+                if (columnFlip)
+                {
+                    mappedY[offset + wFlip] = QPoint(y0Flip, x0Flip);
+                }
+            }
+            start = curr;
+        }
+    }
+
+    // without the hImage view only the hImage pixels the vertical map reads are generated.
+    const QRect horizontalRegion = (hImage != NULL) ? QRect(QPoint(0, 0), hImageSize)
+                                 : VerticalMapSourceRect(mappedY, verticalRegion, vImageSize, hImageSize);
+
+    /**
+     * do horizontal correction.
+     * suspect the opitial pointer: (opticalCenterW, opticalCenterW).
+     * the coordinate system: x aix <---> width; y aix <---> height.
+     */
+
+    QVector<QPoint> mappedX(horizontalRegion.width() * horizontalRegion.height());
+    const int verticalBase      = (mVerticalBase == 0) ? height / 4: mVerticalBase;
+
+    for (int h = 0; h < opticalCenterH; ++h)
+    {
+        /**
+         * the euqtion should locate on these three points.
+         * then, we can calculate the coff: a , b , r
+         * here, the coffH is tuneable value according the the h
+         **/
+
+        // h / (height / 2) = (coffH - hBase) / (height/2 - hBase).
+        float coffH    = h * (opticalCenterH - verticalBase) / (opticalCenterH) + verticalBase;
+
+        if (h == coffH) break;
+        const int hFlip     = height - 1 - h;
+        const bool row      = (h >= horizontalRegion.top() && h <= horizontalRegion.bottom());
+        const bool rowFlip  = (hFlip >= horizontalRegion.top() && hFlip <= horizontalRegion.bottom());
+        if (!row && !rowFlip)
+        {
+            continue;
+        }
+        float a = opticalCenterW;
+        float b = (h + coffH - a * a / (float)(h- coffH)) / 2;
+        float r = pow((h - b) * (h - b), 0.5f);
+
+        //qDebug("a = %f, b = %f, c = %f", a, b, c);
+        for (int arc = 0; arc < opticalCenterW; arc++)
+        {
+            arcLength[arc] = GetArchLensOfCircel(a, b, r, arc);
+        }
+
+        int start = 0;
+        int curr  = 0;
+        for (int w = 0; w < width; ++w)
+        {
+            int x0                  = w;
+            int y0                  = Range(b - pow (pow(r, 2) - pow( x0 - a, 2), 0.5f), 0, height-1);
+            int x0Flip              = w;
+            int y0Flip              = Range(height - 1 - y0, 0, height-1);
+
+            // the arc length table ends before the optical center.
+            int arc = qBound(0, (w < opticalCenterW) ? w : ( 2 * opticalCenterW - w), opticalCenterW - 1);
+
+            float arcLenghx          = arcLength[arc];
+
+            if (h == 0 && w == 0)
+            {
+                qDebug("arctan = %lf", asin(a/r));
+                qDebug("a = %f, b = %f, r = %f", a, b, r);
+                qDebug("the maxHorizontalArcLengh = %d, arcLength = %f", maxHorizontalArcLengh, arcLenghx);
+            }
+
+            if ( x0 < opticalCenterW ) {
+                curr = maxHorizontalArcLengh / 2 - (int)arcLenghx;
+            }
+            else
+            {
+                curr = maxHorizontalArcLengh / 2 + (int)arcLenghx;
+            }
+
+            curr = Range(curr, 0, maxHorizontalArcLengh - 1);
+
+            // only the columns of the region are stored.
+            const int first = qMax(start, horizontalRegion.left());
+            const int last  = qMin(curr, horizontalRegion.right() + 1);
+            for (int k = first; k < last; ++k)
+            {
+                if (row)
+                {
+                    mappedX[(h - horizontalRegion.top()) * horizontalRegion.width() + k - horizontalRegion.left()]
+                        = QPoint(x0, y0);
+                }
+                if (rowFlip)
+                {
+                    mappedX[(hFlip - horizontalRegion.top()) * horizontalRegion.width() + k - horizontalRegion.left()]
+                        = QPoint(x0Flip, y0Flip);
+                }
+            }
+
+            start = curr;
+        }
+    }
+
+    // mappedX is in the rotated image, the tables read the original one.
+    const ImageRotation rotation(width, height, mRotation);
+    if (!rotation.IsIdentity())
+    {
+        for (int n = 0; n < mappedX.size(); ++n)
+        {
+            mappedX[n] = rotation.MapPixel(mappedX[n]);
+        }
+    }
+
+    RemapTable verticalTable;
+    if (hImage == NULL)
+    {
+        // no view, one pass from oriImage to the crop with the two maps composed.
+        verticalTable.Reset(width, height, crop.width(), crop.height());
+        SetVerticalCropEntries(&verticalTable, mappedY, crop, vImageSize, &mappedX, horizontalRegion);
+        verticalTable.Apply(oriImage, smoothImage);
+    }
+    else
+    {
+        qDebug("Horizontal Correction");
+        RemapTable horizonTable;
+        horizonTable.Reset(width, height, maxHorizontalArcLengh, height);
+        horizonTable.SetEntries(mappedX.constData());
+        horizonTable.Apply(oriImage, hImage);
+        if (vImage != NULL)
+        {
+            verticalTable.Reset(maxHorizontalArcLengh, height, maxHorizontalArcLengh, maxVerticalArcLength);
+            verticalTable.SetEntries(mappedY.constData());
+            verticalTable.Apply(hImage, vImage);
+            *smoothImage = vImage->copy(crop);
+        }
+        else
+        {
+            verticalTable.Reset(maxHorizontalArcLengh, height, crop.width(), crop.height());
+            SetVerticalCropEntries(&verticalTable, mappedY, crop, vImageSize, NULL, QRect());
+            verticalTable.Apply(hImage, smoothImage);
+        }
+    }
+    *strecthImage = smoothImage->scaled(width, height, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    qDebug("strecth image wxh = %dx%d", strecthImage->width(), strecthImage->height());
+}
+
+
+// here, we suspect the second-order curve (y = a*x*x + b* x + c) satisfied the our requirement.
+void FisheyeDistortionCorrection::Process1(QImage *oriImage, QImage *rotateImage, QImage *hImage, QImage *vImage, QImage *smoothImage, QImage *strecthImage)
+{
+    const int width     = oriImage->width();
+    const int height    = oriImage->height();
+
+    if (width != mWidth || height != mHeight)
+    {
+        qDebug("mismatch: set size: %dx%d, image size: %dx%d", mWidth, mHeight, width, height);
+        return;
+    }
+    qDebug("original image size = %dx%d", width, height);
+
+    if (rotateImage != NULL)
+    {
+        *rotateImage = DoImageRotate(oriImage, mRotation);
+        qDebug("rotate Image size: %d, %d", rotateImage->width(), rotateImage->height());
+    }
+
+    const int opticalCenterW        = (mOpticalCenterX == 0) ? ((width -1) / 2) : mOpticalCenterX;
+    const int opticalCenterH        = (mOpticalCenterY == 0) ? ((height -1) / 2) : mOpticalCenterY;
+    const int maxVerticalArcLength   = AlignTo(opticalCenterH * M_PI, 2);
+    const int maxHorizontalArcLengh = AlignTo(opticalCenterW * M_PI, 2);
+    qDebug("optical center point: %dx%d", opticalCenterW, opticalCenterH);
+    qDebug("maxVerticalArcLength = %d, maxHorizontalArcLength = %d",
+           maxVerticalArcLength, maxHorizontalArcLengh);
+
+    // the crop of vImage, a null crop is the whole vImage, like QImage::copy().
+    QRect crop(mCropX, mCropY, mCropW, mCropH);
+    qDebug("cropX =%d, cropY = %d, cropW = %d, cropH = %d", crop.x(), crop.y(), crop.width(), crop.height());
+    if (crop.isNull())
+    {
+        crop = QRect(0, 0, maxHorizontalArcLengh, maxVerticalArcLength);
+    }
+    const QSize hImageSize(maxHorizontalArcLengh, height);
+    const QSize vImageSize(maxHorizontalArcLengh, maxVerticalArcLength);
+    QImage horizontalImage;
+    if (hImage == NULL && vImage != NULL)
+    {
+        hImage = &horizontalImage;
+    }
+    // without the vImage view only the crop of the vertical map is generated.
+    const QRect verticalRegion = (vImage != NULL) ? QRect(QPoint(0, 0), vImageSize) : crop;
+
+    /**
+     * do vertical correction, two-order curve.
+     * suspect the opitial pointer: (w/2, h/2).
+     * the coordinate system: x aix <---> height, y aix <---> width.
+     * the equation: y = a*x^x + b*x + c.
+     * three point should be:
+     *  (0, coffW), (height / 2, y'), (height, coffW).
+     * here, the y' should be changed according to the peak of the curve.
+     *       the coffW is the dynamic change according the picture view.
+     */
+
+    QVector<QPoint> mappedY(verticalRegion.width() * verticalRegion.height());
+    QVector<double> arcLengthToCenterY(opticalCenterH + 1);
+    int horizontalBase          = (mHorizontalBase == 0) ? maxHorizontalArcLengh / 8 : mHorizontalBase;
+    for (int w = 0; w < maxHorizontalArcLengh / 2; ++w)
+    {
+        const int wFlip         = maxHorizontalArcLengh - 1 - w;
+        const bool column       = (w >= verticalRegion.left() && w <= verticalRegion.right());
+        const bool columnFlip   = (wFlip >= verticalRegion.left() && wFlip <= verticalRegion.right());
+        if (!column && !columnFlip)
+        {
+            continue;
+        }
+
+        /**
+         * the equation should locate these three points.
+         * (0, coffW), (opticalCenterH, w), (2 * opticalCenterH,  coffW)
+         * 1: coffW = a * 0 * 0 + b * 0 + c
+         * 2: w = a * height / 2 * height / 2 + b * height / 2 + c
+         * 3: coffW = a * height * height + b * height + c
+         **/
+        //  coffW / (width / 2 - baseW) = w / (width / 2)
+        int coffW       = w * (maxHorizontalArcLengh / 2 - horizontalBase) / (maxHorizontalArcLengh / 2) + horizontalBase;
+        float a         =  ( coffW - w) / (float) opticalCenterH / (float) opticalCenterH;
+        float b         =  -2 * a * opticalCenterH;
+        float c         = coffW;
+        //qDebug("a = %f, b = %f, c = %f", a, b, c);
+        const double centerY = ParabolaArcPrimitive(a, b, opticalCenterH);
+        for (int arc = 0; arc <= opticalCenterH; arc++)
+        {
+            arcLengthToCenterY[arc] = centerY - ParabolaArcPrimitive(a, b, arc);
+        }
+
+        int start = 0;
+        int curr  = 0;
+        for (int h = 0; h < height; ++h)
+        {
+            int x0                  = h;
+            int y0                  = a * x0 * x0 + b * x0 + c;
+            int x0Flip              = h;
+            int y0Flip              = maxHorizontalArcLengh - 1 - y0;
+            const int arc           = (x0 < opticalCenterH) ? x0 : (2 * opticalCenterH - x0);
+            float arcLengthTotalY   = arcLengthToCenterY[Range(arc, 0, opticalCenterH)];
+            if ( h == 0 && w == 0)
+            {
+                int arcLength = GetArchLens(a, b, c, x0, y0, height / 2, w);
+                qDebug("a = %f, b = %f, c = %f", a, b, c);
+                qDebug("the max arcLengthTotalY= %f, arcLength = %d", arcLengthTotalY, arcLength);
+            }
+
+            if ( x0 < opticalCenterH)
+            {
+                curr = maxVerticalArcLength / 2 - (int)arcLengthTotalY;
+            }
+            else
+            {
+                curr = maxVerticalArcLength / 2 + (int)arcLengthTotalY;
+            }
+
+            curr = Range(curr, 0, maxVerticalArcLength -1);
+            // only the rows of the region are stored.
+            const int first = qMax(start, verticalRegion.top());
+            const int last  = qMin(curr, verticalRegion.bottom() + 1);
+            for ( int k = first; k < last; ++k)
+            {
+                const int offset = (k - verticalRegion.top()) * verticalRegion.width() - verticalRegion.left();
+                if (column)
+                {
+                    mappedY[offset + w] = QPoint(y0, x0);
+                }
+                if (columnFlip)
+                {
+                    mappedY[offset + wFlip] = QPoint(y0Flip, x0Flip);
+                }
+            }
+            start = curr;
+        }
+    }
+
+    // without the hImage view only the hImage pixels the vertical map reads are generated.
+    const QRect horizontalRegion = (hImage != NULL) ? QRect(QPoint(0, 0), hImageSize)
+                                 : VerticalMapSourceRect(mappedY, verticalRegion, vImageSize, hImageSize);
+
+    /**
+     * do horizontal correction, two-order curve.
+     * suspect the opitial pointer: (opticalCenterW, opticalCenterW).
+     * the coordinate system: x aix <---> width; y aix <---> height.
+     * the equation: y = a*x^x + b*x + c.
+     * three point should be:
+     *  (0, coffH), (opticalCenterW, y'), (opticalCenterW * 2, coffH).
+     * here, the y' should be changed according to the peak of the curve.
+     */
+
+    QVector<QPoint> mappedX(horizontalRegion.width() * horizontalRegion.height());
+    // arcLengthToCenterX[arc] : the curve length from arc to opticalCenterW.
+    QVector<double> arcLengthToCenterX(opticalCenterW + 1);
+    const int verticalBase       = (mVerticalBase == 0) ? height / 4: mVerticalBase;
+
+    for (int h = 0; h < opticalCenterH; ++h)
+    {
+        const int hFlip     = height - 1 - h;
+        const bool row      = (h >= horizontalRegion.top() && h <= horizontalRegion.bottom());
+        const bool rowFlip  = (hFlip >= horizontalRegion.top() && hFlip <= horizontalRegion.bottom());
+        if (!row && !rowFlip)
+        {
+            continue;
+        }
+
+        /**
+         * the euqtion should locate on these three points.
+         * (0, coffH), (opticalCenterW, h), (opticalCenterW * 2, coffH)
+         * 1: coffH = a * 0 * 0 + b * 0 + c
+         * 2: h = a * (opticalCenterW) * (opticalCenterW) + b * (opticalCenterW) + c
+         * 3: coffH = a * opticalCenterW * opticalCenterW * 4 + b * opticalCenterW * 2 + c.
+         * then, we can calculate the coff: a , b , c.
+         * here, the coffH is tuneable value according the the h
+         **/
+
+        // h / (height / 2) = (coffH - hBase) / (height/2 - hBase).
+        float coffH    = h * (opticalCenterH - verticalBase) / (opticalCenterH) + verticalBase;
+
+        float a         = (coffH - h) / (float)opticalCenterW / (float) opticalCenterW;
+        float b         = -a * opticalCenterW * 2;
+        float c         = coffH;
+        //qDebug("a = %f, b = %f, c = %f", a, b, c);
+        const double centerX = ParabolaArcPrimitive(a, b, opticalCenterW);
+        for (int arc = 0; arc <= opticalCenterW; arc++)
+        {
+            arcLengthToCenterX[arc] = centerX - ParabolaArcPrimitive(a, b, arc);
+        }
+
+        int start = 0;
+        int curr  = 0;
+        for (int w = 0; w < width; ++w)
+        {
+            int x0                  = w;
+            int y0                  = a * x0 * x0 + b * x0 + c;
+            int x0Flip              = w;
+            int y0Flip              = height - 1 - y0;
+            const int arc           = (w < opticalCenterW) ? w : opticalCenterW * 2 - w;
+            float arcLengthTotalX   = arcLengthToCenterX[Range(arc, 0, opticalCenterW)];
+
+            if (h == 0 && w == 0)
+            {
+                int arcLength = GetArchLens(a, b, c, x0, y0, width / 2, h);
+                qDebug("a = %f, b = %f, c = %f", a, b, c);
+                qDebug("the max arcLengthTotalX= %f, arcLength = %d", arcLengthTotalX, arcLength);
+            }
+            if ( x0 < opticalCenterW ) {
+                curr = maxHorizontalArcLengh / 2 - (int)arcLengthTotalX;
+            }
+            else
+            {
+                curr = maxHorizontalArcLengh / 2 + (int)arcLengthTotalX;
+            }
+            curr = Range(curr, 0, maxHorizontalArcLengh - 1);
+            // only the columns of the region are stored.
+            const int first = qMax(start, horizontalRegion.left());
+            const int last  = qMin(curr, horizontalRegion.right() + 1);
+            for (int k = first; k < last; ++k)
+            {
+                if (row)
+                {
+                    mappedX[(h - horizontalRegion.top()) * horizontalRegion.width() + k - horizontalRegion.left()]
+                        = QPoint(x0, y0);
+                }
+                if (rowFlip)
+                {
+                    mappedX[(hFlip - horizontalRegion.top()) * horizontalRegion.width() + k - horizontalRegion.left()]
+                        = QPoint(x0Flip, y0Flip);
+                }
+            }
+            start = curr;
+        }
+    }
+
+    // mappedX is in the rotated image, the tables read the original one.
+    const ImageRotation rotation(width, height, mRotation);
+    if (!rotation.IsIdentity())
+    {
+        for (int n = 0; n < mappedX.size(); ++n)
+        {
+            mappedX[n] = rotation.MapPixel(mappedX[n]);
+        }
+    }
+
+    RemapTable verticalTable;
+    if (hImage == NULL)
+    {
+        // no view, one pass from oriImage to the crop with the two maps composed.
+        verticalTable.Reset(width, height, crop.width(), crop.height());
+        SetVerticalCropEntries(&verticalTable, mappedY, crop, vImageSize, &mappedX, horizontalRegion);
+        verticalTable.Apply(oriImage, smoothImage);
+    }
+    else
+    {
+        RemapTable horizonTable;
+        horizonTable.Reset(width, height, maxHorizontalArcLengh, height);
+        horizonTable.SetEntries(mappedX.constData());
+        horizonTable.Apply(oriImage, hImage);
+        if (vImage != NULL)
+        {
+            verticalTable.Reset(maxHorizontalArcLengh, height, maxHorizontalArcLengh, maxVerticalArcLength);
+            verticalTable.SetEntries(mappedY.constData());
+            verticalTable.Apply(hImage, vImage);
+            *smoothImage = vImage->copy(crop);
+        }
+        else
+        {
+            verticalTable.Reset(maxHorizontalArcLengh, height, crop.width(), crop.height());
+            SetVerticalCropEntries(&verticalTable, mappedY, crop, vImageSize, NULL, QRect());
+            verticalTable.Apply(hImage, smoothImage);
+        }
+    }
+    *strecthImage = smoothImage->scaled(width, height, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    qDebug("strecth image wxh = %dx%d", strecthImage->width(), strecthImage->height());
+}
+
+/**
+ * the arc length of y = a * x^2 + b * x + c from 0 to x, up to a constant:
+ * with u = 2 * a * x + b the integral of sqrt(1 + u^2) dx is
+ * (u * sqrt(1 + u^2) + asinh(u)) / (4 * a), a flat curve is a line.
+ **/
+double FisheyeDistortionCorrection::ParabolaArcPrimitive(double a, double b, double x)
+{
+    if (qAbs(a) < 1e-12)
+    {
+        return x * qSqrt(1 + b * b);
+    }
+    const double u = 2 * a * x + b;
+    return (u * qSqrt(1 + u * u) + std::asinh(u)) / (4 * a);
+}
+
+float FisheyeDistortionCorrection::GetArchLens(float a, float b, float c, int x0, int x1)
+{
+    Q_UNUSED(c);
+    return ParabolaArcPrimitive(a, b, x1) - ParabolaArcPrimitive(a, b, x0);
+}
+
+int FisheyeDistortionCorrection::GetArchLens(float a, float b, float c, int x0, int y0, int x1, int y1)
+{
+    // the two points are on the curve, only the x matter.
+    Q_UNUSED(c);
+    Q_UNUSED(y0);
+    Q_UNUSED(y1);
+    return qAbs(ParabolaArcPrimitive(a, b, x1) - ParabolaArcPrimitive(a, b, x0));
+}
+
+void FisheyeDistortionCorrection::Process(QImage *ori_image,
+                                            QImage *h_image,
+                                            QImage *v_image,
+                                            QImage *smooth_image,
+                                            QImage *strecth_image)
+{
+    QImage image(mFilePath);
+    if (image.isNull()) {
+        qDebug() << "bad image input";
+        return ;
+    }
+    *ori_image= image.convertToFormat(QImage::Format_RGB888);
+    const int w = ori_image->width();
+    const int h = ori_image->height();
+    qDebug() << "width = " << w;
+    qDebug() << "height = " << h;
+
+    *h_image = *ori_image;
+#ifdef PARABOLIC
+    // the parabolic is: y = a * (x -k) * (x -k) + c;
+    // the parabolic will locate at :
+    // point 1(0, coff_c);
+    // point 2(w-1, coff_c);
+
+    int y_end = h/2;
+    int x_end = w;
+    //suspect the coff_a coff_c changed by linerality by y index.
+    //when y_index = 0; a = coff_a
+    //when y_index = x_end; a = 0;
+
+    // here the coff_a and coff_c is tunable.
+    float coff_a = 0.0015f; //coff_value/ coff_range;
+
+    // here the coff_c should be [0, y_end]
+    float coff_c = 0;
+    float k = w / 2.0f;
+
+    for (int y = 0; y < y_end; y++) {
+        float a = coff_a * ( 1 - y /(float) y_end);
+        float c = y;
+        qDebug() << "a = " << a;
+        qDebug() << "c = " << c;
+        for (int x = 0; x < x_end; x++) {
+            int y1 = a * (x -k)* (x -k) + c;
+            if (y1 > y_end) y1 = y_end;
+            newRgb.setPixel(x,y, rgb.pixel(x, y1));
+        }
+    }
+#elif defined(CIRCEL)
+    // the correction is circle equation.
+    // (x - a)^(x - a)  + (y - b)^(y - b) = r * r.
+    float a = 0.0f;
+    float b = 0.0f;
+    float r = 0.0f;
+    int x_end = 0.0f;
+    int y_end = 0.0f;
+
+    // for horizontal orientation:
+    // the optical point is: (a, b), here the a is fixed value:
+    //          a = w/2.0f;
+    // and then suspect the circel will go through these three point:
+    //          (0, coffH), (w, coffH), (a, y); ( y should be 0~b).
+    // and resove the equation, we can get the b and r.
+
+    a = (w-1) / 2.0f;
+
+    // then:
+    // a^a + (coffH-b)^(coffH-b) = r *r
+    // (y-b) ^ (y -b) = r*r
+
+    // here, the coff range is tuneable according to the eyefish picture.
+    float hBase = 200;
+    x_end = w;
+    y_end = (h-1) / 2.0;
+
+    // suspec the coffH match the function: coff = a_h* x^(gamma) + b_h
+    // will go through this to point(0, hBase/h_end), ( 1, 1)
+    float b_h = hBase/(float)y_end;
+    float gamma_h = 1/1.12;
+    QColor pre;
+    QColor pre1;
+    for (int y = 0; y < y_end; y++) {
+#if 0
+        float coffH = y+ hBase - y * hBase / y_end;
+#else
+        float a_h = 1 - b_h;
+        float coffH = (a_h * pow(y/(float)y_end, gamma_h) + b_h) * y_end;
+#endif
+        b = (y * y - coffH * coffH - a * a) / (float)(2.0 * ( y - coffH));
+        r = sqrt((y-b) * (y-b));
+        qDebug() << "a = " << a << ", b = " << b << ",r = " << r;
+        for (int x = 0; x < x_end; x++) {
+            // y = sqrt(r*r-(x-a)*(x-a));
+            int y1 = (int)(b- sqrt(r * r - (x-a)*(x-a)) + 0.5f) ;
+            if (y1 < 0) y1 = 0;
+            if (y1 > y_end) y1= y_end;
+            QColor color = ori_image->pixelColor(x,y1);
+            if (x == 0) {
+                pre = color;
+                pre1 = color;
+            }
+            color.setRed((color.red() + pre.red() + pre1.red()) / 3 + 0.5f);
+            color.setBlue((color.blue() + pre.blue() + pre1.blue()) / 3 + 0.5f);
+            color.setGreen((color.green() + pre.green() + pre1.green()) / 3 + 0.5f);
+
+            //h_image->setPixel(x, y, ori_image->pixel(x, y1));
+            h_image->setPixelColor(x, y, color);
+            pre1 = pre;
+            pre = ori_image->pixelColor(x, y1);
+
+            // for horizontal orientation, the picture are symmetric.
+            // the symmetric aix is y = y_end;
+            int y_mirror = h - y-1;
+            if (y_mirror > h) y_mirror = h;
+            if (y_mirror < 0) y_mirror = 0;
+            int y_mirror1 = h - y1-1;
+            if (y_mirror1 > h) y_mirror1 = h;
+            if (y_mirror1 < 0) y_mirror1 = 0;
+            h_image->setPixel(x, y_mirror, ori_image->pixel(x, y_mirror1));
+
+        }
+    }
+
+    *v_image = *h_image;
+    // for vertical orientation:
+    // the circle point is: (a, b), here the b is fixed value:
+    //          b = h / 2.0f;
+    // and then suspect the circel will go through these three point:
+    //         (x, b), (coff_v, 0) (coff, h)
+    // and resove the equation, we can get the b and r.
+    b = (h-1) / 2.0f;
+
+    float vBase = -200;
+    x_end = (w-1) / 2.0f;
+    y_end = h;
+
+    // suspec the coff_v match the function: coff = a_v* x^(gamma) + b_v
+    // will go through this to point(0, coff_v/x_end), ( 1, 1)
+    float gamma_v = 1/2.4f;
+    float b_v = vBase/(float)x_end;
+    float a_v = 1 - b_v;
+    for (int x = 0; x < x_end; x++) {
+#if 0
+        float coff_v = vBase - vBase * x / x_end + x;
+        //float coff_v = x + vBase;
+#else
+        float coff_v = (a_v * pow (x/(float)x_end, gamma_v) + b_v) * x_end;
+
+#endif
+        if (coff_v > x_end) coff_v = x_end;
+        float a = (x * x - coff_v * coff_v - b * b) / (2.0f * (x - coff_v));
+        float r2 = (x -a) * (x - a);
+        qDebug() <<"x =" << x << "coff_v = " << coff_v;
+        qDebug() << "a = " << a << ", b = " << b << ",r = " << r;
+        for (int y = 0; y < y_end; y++) {
+            int x1 = int(a - sqrt(r2 - (y-b) * (y-b)) + 0.5f);
+            if (x1 < 0) x1 = 0;
+            if (x1 > x_end) x = x_end;
+            if (coff_v < x) x1 = x;
+            QColor color = h_image->pixelColor(x1, y);
+            if (y == 0) {
+                pre1 = color;
+                pre = color;
+            }
+            color.setRed((color.red() + pre.red() + pre1.red()) / 3 + 0.5f);
+            color.setBlue((color.blue() + pre.blue() + pre1.blue()) / 3 + 0.5f);
+            color.setGreen((color.green() + pre.green() + pre1.green()) / 3 + 0.5f);
+
+            //v_image->setPixel(x, y, h_image->pixel(x1, y));
+            v_image->setPixelColor(x, y, color);
+            pre1 = pre;
+            pre = h_image->pixelColor(x1, y);
+            // for vertical oriention, the picture still are symmetric
+            int x_mirror = w-x-1;
+            int x1_mirror = w-x1-1;
+            v_image->setPixel(x_mirror, y, h_image->pixel(x1_mirror, y));
+        }
+    }
+    v_image->save("v_image.jpg");
+#elif defined(ELLIPSE)
+
+#endif
+
+
+
+    // improve the sawtooth.
+    *smooth_image = *ori_image;
+#if 0
+    QImage gray = v_image->convertToFormat(QImage::Format_Grayscale8);
+    int min_threshold = 60;
+    int max_threshold = 140;
+    int kernel_w = 3;
+    int kernel_h = 3;
+    int pixel[kernel_w][kernel_h];
+    for (int y = 0; y < h-kernel_h; y++) {
+        for (int x = 0; x < w-kernel_w; x++) {
+            for (int y1 = 0; y1 < kernel_h ; y1++) {
+                for (int x1 = 0; x1 < kernel_w; x1++) {
+                    if (gray.pixelColor(x1+x, y1+y).value() > max_threshold) {
+                        pixel[x1][y1] = 1;
+                    } else if (gray.pixelColor(x1+x, y1+y).value() < min_threshold) {
+                        pixel[x1][y1] = 0;
+                    } else {
+                        pixel[x1][y1] = -2;
+                    }
+                }
+            }
+            bool need_filter = false;
+            do {
+                int b0 = pixel[0][0] + pixel[0][1] + pixel[0][2];
+                int b1 = pixel[0][2] + pixel[1][2] + pixel[2][2];
+                int b2 = pixel[2][0] + pixel[2][1] + pixel[2][2];
+                int b3 = pixel[0][0] + pixel[1][0] + pixel[2][0];
+                if (pixel[1][1] == 0) {
+                    if(b0+b1 == 6 || b1+b2 == 6 || b2+b3== 6 || b3+b0 == 6) {
+                        need_filter = true;
+                        break;
+                    }
+
+                }
+                if (pixel[1][1] == 1) {
+                    if (b0+b1 == 0 || b1+b2 == 0 || b2+b3== 0 || b3+b0 == 0){
+                        need_filter = true;
+                        break;
+                    }
+                }
+            } while(0);
+            if (need_filter == true) {
+                QColor color;
+                color.setRed((v_image->pixelColor(x,y).red()
+                             + v_image->pixelColor(x+1, y).red()
+                             + v_image->pixelColor(x+2, y).red()
+                             + v_image->pixelColor(x,y+1).red()
+                             + v_image->pixelColor(x+1,y+1).red()
+                             + v_image->pixelColor(x+2,y+1).red()
+                             + v_image->pixelColor(x, y+2).red()
+                             + v_image->pixelColor(x+1, y+2).red()
+                             + v_image->pixelColor(x+2, y+2).red())/9);
+                color.setGreen((v_image->pixelColor(x,y).green()
+                             + v_image->pixelColor(x+1, y).green()
+                             + v_image->pixelColor(x+2, y).green()
+                             + v_image->pixelColor(x,y+1).green()
+                             + v_image->pixelColor(x+1,y+1).green()
+                             + v_image->pixelColor(x+2,y+1).green()
+                             + v_image->pixelColor(x, y+2).green()
+                             + v_image->pixelColor(x+1, y+2).green()
+                             + v_image->pixelColor(x+2, y+2).green())/9);
+                color.setBlue((v_image->pixelColor(x,y).blue()
+                             + v_image->pixelColor(x+1, y).blue()
+                             + v_image->pixelColor(x+2, y).blue()
+                             + v_image->pixelColor(x,y+1).blue()
+                             + v_image->pixelColor(x+1,y+1).blue()
+                             + v_image->pixelColor(x+2,y+1).blue()
+                             + v_image->pixelColor(x, y+2).blue()
+                             + v_image->pixelColor(x+1, y+2).blue()
+                             + v_image->pixelColor(x+2, y+2).blue())/9);
+#if 0
+                //debug
+                color.setRed(255);
+                color.setGreen(64);
+                color.setBlue(64);
+
+#endif
+                smooth_image->setPixelColor(x+1, y+1, color);
+#if 0
+                for (int y1 = 0; y1 < 3; y1++) {
+                    for (int x1 = 0; x1 < 3; x1++) {
+                        smooth_image->setPixelColor(x+x1, y+y1, color);
+                    }
+                }
+#endif
+            }
+        }
+    }
+//#else
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int x1 = x;
+            int x2= x+1;
+            int y1 = y;
+            int y2 = y+1;
+            int x3 = x-1;
+            int y3 = y-1;
+
+            if (x2 >= w) x2 = w -1;
+            if (y2 >= h) y2 = h -1;
+            if (x3 < 0) x3 = 0;
+            if (y3 < 0) y3 = 0;
+            QColor color;
+            color.setRed((v_image->pixelColor(x1, y1).red()
+                          + v_image->pixelColor(x1,y2).red()
+                          + v_image->pixelColor(x1, y3).red()
+                          + v_image->pixelColor(x2, y1).red()
+                          + v_image->pixelColor(x2, y2).red()
+                          + v_image->pixelColor(x2, y3).red()
+                          + v_image->pixelColor(x3,y1).red()
+                          + v_image->pixelColor(x3, y2).red()
+                          + v_image->pixelColor(x3, y3).red()) / 9);
+            color.setGreen((v_image->pixelColor(x1, y1).green()
+                            + v_image->pixelColor(x1,y2).green()
+                            + v_image->pixelColor(x1, y3).green()
+                            + v_image->pixelColor(x2, y1).green()
+                            + v_image->pixelColor(x2, y2).green()
+                            + v_image->pixelColor(x2, y3).green()
+                            + v_image->pixelColor(x3,y1).green()
+                            + v_image->pixelColor(x3, y2).green()
+                            + v_image->pixelColor(x3, y3).green()) / 9);
+            color.setBlue((v_image->pixelColor(x1, y1).blue()
+                           + v_image->pixelColor(x1,y2).blue()
+                           + v_image->pixelColor(x1, y3).blue()
+                           + v_image->pixelColor(x2, y1).blue()
+                           + v_image->pixelColor(x2, y2).blue()
+                           + v_image->pixelColor(x2, y3).blue()
+                           + v_image->pixelColor(x3,y1).blue()
+                           + v_image->pixelColor(x3, y2).blue()
+                           + v_image->pixelColor(x3, y3).blue()) / 9);
+            smooth_image->setPixelColor(x, y, color);
+        }
+    }
+#endif
+
+    //according to the optical center point. we need do strection.
+    const float strection_w_ratio               = M_PI_2;
+    const float strection_h_ratio               = M_PI_2 * 0.8;
+    const int strection_width                   = AlignTo(w * strection_w_ratio * 2, 2);
+    const int strection_height                  = AlignTo(h * strection_h_ratio * 2, 2);
+    const int ocw                               = w / 2;
+    const int och                               = h / 2;
+    const int ocsw                              = strection_width / 2;
+    const int ocsh                              = strection_height / 2;
+
+    qDebug("wxh=(%d, %d), strech wxh=(%d, %d)", w, h, strection_width, strection_height);
+    QImage strection(strection_width, strection_height, QImage::Format_RGB888);
+    for (int y = ocsh; y > 0; --y)
+    {
+        int y1 = MyMin(h-1, qPow(y / (float)ocsh, 4.0) * och);
+        for (int x = ocsw; x > 0; --x)
+        {
+            int x1 = MyMin(w-1, qPow(x / (float)ocsw, 4.0) * ocw);
+
+            strection.setPixel(x, y, smooth_image->pixel(x1, y1));
+
+            strection.setPixel(2 * ocsw - x, y, smooth_image->pixel(2 * ocw - 1 - x1, y1));
+
+            strection.setPixel(x, 2 * ocsh - y, smooth_image->pixel(x1, 2 * och - 1 - y1));
+
+            strection.setPixel(2 * ocsw - x, 2 * ocsh - y, smooth_image->pixel(2 * ocw - 1 -x1, 2 * och - 1 - y1));
+        }
+    }
+    *strecth_image = strection.scaled(w, h, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+int FisheyeDistortionCorrection::AlignTo(int value, int k)
+{
+    int delat  = value % k;
+    if (delat == 0) return value;
+    return value + k - delat;
+}
+
+QImage FisheyeDistortionCorrection::GenerateSampleImage(int width, int height)
+{
+    QImage sample(width, height, QImage::Format_RGB888);
+
+    const int width_max    = static_cast<int>(pow(2, 12));
+    const int height_max   = static_cast<int>(pow(2, 12));
+    if (width > width_max || height > height_max)
+    {
+        qDebug("image size is too big. current size: %dx%d, max support size:%dx%d",
+               width, height, width_max, height_max);
+        return sample;
+    }
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            /**
+             * @brief rgbValue will store the x, y value for the low 24-bit. 12 bit for x, 12 bit for y.
+             * so, here, if width > 2^12 or height > 2^12, this method will not valid.
+             */
+            QRgb rgbValue = (0xffu << 24) | ((x & 0xfffu) << 12) | (y & 0xfffu);
+            sample.setPixel(x, y, rgbValue);
+        }
+    }
+    return sample;
+}
+
+QDataStream &operator<<(QDataStream &out, const CorrectionBinData_t &binData) {
+    out << binData.magic_number
+        << binData.major_version
+        << binData.minor_version
+        << binData.width_in
+        << binData.height_in
+        << binData.width_out
+        << binData.height_out;
+    return out;
+
+}
+
+QDataStream &operator>>(QDataStream &in, CorrectionBinData_t &binData) {
+    in  >> binData.magic_number
+        >> binData.major_version
+        >> binData.minor_version
+        >> binData.width_in
+        >> binData.height_in
+        >> binData.width_out
+        >> binData.height_out;
+    return in;
+}
+bool FisheyeDistortionCorrection::GenerateMappingFileBin(
+        QString path,
+        QImage *final,
+        int width_in,
+        int height_in,
+        int majorVersion)
+{
+
+    int width_out   = final->width();
+    int height_out  = final->height();
+    RemapTable table;
+    table.Reset(width_in, height_in, width_out, height_out);
+    for (int y = 0; y < height_out; y++)
+    {
+        for (int x = 0; x < width_out; x++)
+        {
+            QRgb rgb = final->pixel(x, y);
+            table.SetEntry(x, y, (rgb >> 12) & 0xfff, rgb & 0xfff);
+        }
+    }
+    return WriteMappingFileBin(path, table, majorVersion);
+}
+
+bool FisheyeDistortionCorrection::GenerateMappingFileBin(QString path, const CorrectionParameters_t &params,
+                                                         int majorVersion)
+{
+    CorrectionParameters_t tableParams = params;
+    if (majorVersion != RemapTableFile::kMajorVersion)
+    {
+        // version 1 only holds whole source pixels.
+        tableParams.interpolation = RemapTable::NearestNeighbour;
+    }
+    RemapTable table;
+    RemapTableCache::getInstance()->CorrectionTable3(tableParams, &table);
+    return WriteMappingFileBin(path, table, majorVersion);
+}
+
+bool FisheyeDistortionCorrection::WriteMappingFileBin(QString path, const RemapTable &table, int majorVersion)
+{
+    if (majorVersion == RemapTableFile::kMajorVersion)
+    {
+        return RemapTableFile::Write(path, table);
+    }
+
+    const int width_out     = table.Width();
+    const int height_out    = table.Height();
+    if (table.IsNull() || table.SourceWidth() > 0x7fff || table.SourceHeight() > 0x7fff)
+    {
+        qDebug("a version 1 mapping file can not hold a %dx%d input", table.SourceWidth(), table.SourceHeight());
+        return false;
+    }
+
+    // the big-endian qint16 pairs QDataStream writes, one block instead of a call per value.
+    // the entries are byte offsets in the pixels of the table format.
+    const int stride        = table.SourceStride();
+    const int pixelBytes    = table.PixelBytes();
+    const qint32 *entries   = table.Entries();
+    QByteArray points(width_out * height_out * 4, 0);
+    uchar *point = reinterpret_cast<uchar *>(points.data());
+    for (int n = 0; n < width_out * height_out; ++n, point += 4)
+    {
+        // a pixel without source is (0, 0), as version 1.0 readers expect it.
+        const qint16 x = (entries[n] < 0) ? 0 : qint16((entries[n] % stride) / pixelBytes);
+        const qint16 y = (entries[n] < 0) ? 0 : qint16(entries[n] / stride);
+        point[0] = uchar(quint16(x) >> 8);
+        point[1] = uchar(x);
+        point[2] = uchar(quint16(y) >> 8);
+        point[3] = uchar(y);
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly|QIODevice::Truncate))
+    {
+        qDebug() << "can not write the mapping file" << path;
+        return false;
+    }
+    QDataStream out(&file);
+
+    CorrectionBinData_t binData;
+    binData.magic_number    = 0x44444;
+    binData.major_version   = 1;
+    binData.minor_version   = 0;
+    binData.width_in        = table.SourceWidth();
+    binData.height_in       = table.SourceHeight();
+    binData.width_out       = width_out;
+    binData.height_out      = height_out;
+    binData.ppMap           = NULL;
+
+    out << binData;
+    out.writeRawData(points.constData(), points.size());
+    file.flush();
+    file.close();
+    return out.status() == QDataStream::Ok;
+}
+
+QImage  FisheyeDistortionCorrection::GetImageByBinData(QString path, QImage *input)
+{
+    RemapTable table;
+    if (!MapMappingFileBin(path, input->width(), input->height(), &table))
+    {
+        return QImage();
+    }
+    QImage output;
+    table.Apply(input, &output);
+    return output;
+}
+
+/**
+ * a version 2 table is kept only for the input size it was made for.
+ **/
+static bool CheckMappingSource(RemapTable *table, int width_in, int height_in)
+{
+    if (table->SourceWidth() != width_in || table->SourceHeight() != height_in)
+    {
+        qDebug("mapping file of a %dx%d input, not %dx%d", table->SourceWidth(), table->SourceHeight(),
+               width_in, height_in);
+        table->Clear();
+        return false;
+    }
+    return true;
+}
+
+bool FisheyeDistortionCorrection::MapMappingFileBin(QString path, int width_in, int height_in, RemapTable *table,
+                                                    int flags)
+{
+    if (!RemapTableFile::IsVersion2(path))
+    {
+        return LoadMappingFileBin(path, width_in, height_in, table);
+    }
+    if (!RemapTableFile::Map(path, table, flags))
+    {
+        return false;
+    }
+    return CheckMappingSource(table, width_in, height_in);
+}
+
+bool FisheyeDistortionCorrection::LoadMappingFileBin(QString path, int width_in, int height_in, RemapTable *table)
+{
+    if (RemapTableFile::IsVersion2(path))
+    {
+        if (!RemapTableFile::Read(path, table))
+        {
+            return false;
+        }
+        return CheckMappingSource(table, width_in, height_in);
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "can not open the mapping file" << path;
+        return false;
+    }
+    QDataStream in(&file);
+    CorrectionBinData_t binData;
+
+    in >> binData;
+
+    qDebug("magic_number = %d, major_version = %d, minor_version = %d, width_in = %d, height_in = %d, width_out = %d, height_out=%d",
+           binData.magic_number,
+           binData.major_version,
+           binData.minor_version,
+           binData.width_in,
+           binData.height_in,
+           binData.width_out,
+           binData.height_out);
+    // check bin file validation.
+    if (binData.magic_number != 0x44444 || binData.major_version != 1 || binData.minor_version != 0)
+    {
+        qDebug() << "bad mapping file" << path;
+        return false;
+    }
+    if (binData.width_out <= 0 || binData.height_out <= 0)
+    {
+        return false;
+    }
+
+    table->Reset(width_in, height_in, binData.width_out, binData.height_out);
+    qint16 x_input = 0, y_input = 0;
+    for (int y = 0; y < binData.height_out; y++)
+    {
+        for (int x = 0; x < binData.width_out; x++)
+        {
+            in >> x_input >> y_input;
+            table->SetEntry(x, y, x_input, y_input);
+        }
+    }
+    return in.status() == QDataStream::Ok;
+}
@@ -0,0 +1,313 @@
+#ifndef FisheyeDistortionCorrection_H
+#define FisheyeDistortionCorrection_H
+
+#include <QAtomicInt>
+#include <QString>
+#include <QImage>
+#include <QVector>
+#include <QPoint>
+#include <QPointF>
+#include <QRect>
+#include "RemapTable.h"
+#include "RemapTableFile.h"
+#include "RemapSpanTable.h"
+#include "RemapSymmetricTable.h"
+
+class Process3Stages;
+
+typedef struct CorrectionBinData
+{
+    qint32 magic_number;
+    qint32 major_version;
+    qint32 minor_version;
+    qint32 width_in;
+    qint32 height_in;
+    qint32 width_out;
+    qint32 height_out;
+    void** ppMap;
+} CorrectionBinData_t;
+
+/**
+ * the full parameter set of one correction.
+ * the remap tables are generated once per parameter set.
+ **/
+typedef struct CorrectionParameters
+{
+    int width;
+    int height;
+    int optical_center_x;
+    int optical_center_y;
+    int rotation;
+    int horizontal_base;
+    int vertical_base;
+    int crop_x;
+    int crop_y;
+    int crop_w;
+    int crop_h;
+    RemapTable::Interpolation interpolation;
+    RemapTable::TraversalOrder traversal_order;
+    bool symmetric_tables;
+
+    bool operator==(const CorrectionParameters &other) const;
+    bool operator!=(const CorrectionParameters &other) const
+    {
+        return !(*this == other);
+    }
+} CorrectionParameters_t;
+
+class FisheyeDistortionCorrection
+{
+public:
+    static  FisheyeDistortionCorrection * getInstance();
+    void    SetPictureSize(int width, int height);
+    void    SetFileLocation(QString path);
+    void    SetOpticalCenterPoint(int x, int y);
+    void    Set2rdCurveCoff(int hBase, int vBase);
+    void    SetRotation(int rotation);
+    void    SetCrop(int x, int y, int w, int h);
+    void    SetInterpolation(RemapTable::Interpolation mode);
+    void    SetTraversalOrder(RemapTable::TraversalOrder order);
+    /*
+     * SetSymmetricTables() : keep only the mirrored part of the Process3
+     * tables when the correction is symmetric (a centered optical center
+     * and crop), 1/2 or 1/4 of the table memory and bandwidth.
+     **/
+    void    SetSymmetricTables(bool enable);
+    CorrectionParameters_t GetParameters() const;
+    void    Process(QImage *ori_image, QImage *h_image,
+            QImage *v_image, QImage *smooth_image, QImage *strecth_image);
+    /*
+     * Process1(), Process2() : vImage can be NULL, then only the crop of
+     * the vertical map is generated and remapped into smoothImage.
+     * hImage can be NULL too, then only the hImage pixels the crop reads
+     * are generated, and the two maps are composed into one pass from
+     * oriImage to smoothImage.
+     * rotateImage can be NULL, the horizontal pass reads oriImage with
+     * the rotation composed into its table.
+     **/
+    void    Process1(QImage *oriImage, QImage *hImage,
+            QImage *rotateImage, QImage *vImage, QImage *smoothImage, QImage *strecthImage);
+    void    Process2(QImage *oriImage, QImage *hImage,
+            QImage *rotateImage, QImage *vImage, QImage *smoothImage, QImage *strecthImage);
+    /*
+     * Process3() : the circle model correction.
+     * rotateImage, hImage, vImage and smoothImage are the debug views, they
+     * can be NULL, then each frame is only one remap pass from oriImage to
+     * strecthImage, the rotation is composed into the table.
+     **/
+    void    Process3(QImage *oriImage, QImage *rotateImage,
+            QImage *hImage, QImage *vImage, QImage *smoothImage, QImage *strecthImage);
+
+    void    Process4(QImage *oriImage, QImage *hImage);
+    
+    void    Process5(QImage *oriImage, QImage *output);
+
+
+    /*
+     * GetMapWidth3() : the width of the Process3 hImage.
+     **/
+    int     GetMapWidth3(const CorrectionParameters_t &params);
+
+    /*
+     * GenerateHorizontalMap3() : the Process3 horizontal correction (circle model).
+     * only the rows [firstRow, firstRow + rowCount) are generated and stored,
+     * rowCount -1 means down to the last row.
+     * mappedX[(y - firstRow) * mapWidth + x] is the rotated image point of hImage(x, y).
+     * subPixelX (optional) gets the same map with sub-pixel points,
+     * (-1, -1) for the points which are not mapped.
+     * the rows are generated on the WorkerPool with the CircleKernel.
+     * return the mapWidth.
+     **/
+    int     GenerateHorizontalMap3(const CorrectionParameters_t &params, QVector<QPoint> *mappedX,
+            QVector<QPointF> *subPixelX = NULL, int firstRow = 0, int rowCount = -1);
+
+    /*
+     * GenerateCorrectionTable3() : compose the horizontal map with the
+     * Process3 vertical correction (parabola model).
+     * the table maps the region of vImage to the original image (the
+     * rotation is composed), the pixels out of the region are not computed.
+     * mapFirstRow is the firstRow of the horizontal map, it must hold
+     * the rows of the region.
+     * with a subPixelX map the table is generated in Bilinear mode.
+     **/
+    void    GenerateCorrectionTable3(const CorrectionParameters_t &params, const QVector<QPoint> &mappedX,
+            int mapWidth, const QRect &region, RemapTable *table, const QVector<QPointF> *subPixelX = NULL,
+            int mapFirstRow = 0);
+
+    /*
+     * GenerateVerticalMap3(), ComposeCorrectionTable3() : the two halves of
+     * GenerateCorrectionTable3(). the vertical map does not depend on the
+     * horizontal one, mappedW[y * region.width() + x] is the hImage column
+     * of vImage(region.x() + x, region.y() + y), -1 for none, subPixelW
+     * (optional) the same at sub-pixel position. the table is Bilinear
+     * when both sub-pixel maps are given.
+     **/
+    void    GenerateVerticalMap3(const CorrectionParameters_t &params, int mapWidth, const QRect &region,
+            QVector<int> *mappedW, QVector<double> *subPixelW = NULL);
+    void    ComposeCorrectionTable3(const CorrectionParameters_t &params, const QVector<QPoint> &mappedX,
+            int mapWidth, const QRect &region, const QVector<int> &mappedW, RemapTable *table,
+            const QVector<QPointF> *subPixelX = NULL, const QVector<double> *subPixelW = NULL,
+            int mapFirstRow = 0);
+
+    /*
+     * GenerateHorizontalTable3() : the hImage table of a whole horizontal
+     * map (mapWidth x params.height), the rotation is composed.
+     **/
+    void    GenerateHorizontalTable3(const CorrectionParameters_t &params, const QVector<QPoint> &mappedX,
+            const QVector<QPointF> *subPixelX, int mapWidth, RemapTable *table);
+    /*
+     * GenerateCorrectionTable3() : the whole Process3 correction of params,
+     * the table Process3 applies to oriImage to get strecthImage.
+     * it only reads params, so the tables of several parameter sets can be
+     * kept by the callers and generated from any thread.
+     * cancelled (optional) is checked between the stages, once it is set the
+     * table is cleared and false is returned.
+     **/
+    bool    GenerateCorrectionTable3(const CorrectionParameters_t &params, RemapTable *table,
+            const QAtomicInt *cancelled = NULL);
+
+    QRect   GetCropRect3(const CorrectionParameters_t &params, int mapWidth);
+
+    QImage  GetDefaultImage();
+    /*
+     * DoImageRotate() : rotate the image by angleValue degrees and stretch
+     * its bounding box back to the image size. the Process tables compose
+     * the same rotation, so it is only needed for the rotateImage view.
+     **/
+    QImage  DoImageRotate(QImage *image, int angleValue);
+
+    QImage  GenerateSampleImage(int width, int height);
+    /*
+     * GenerateMappingFileBin() : the mapping file of final, a Process output
+     * of GenerateSampleImage(width_in, height_in), up to 4096x4096.
+     * major version 1 is the big-endian point list, 2 the RemapTableFile
+     * which loads without parsing. false when the file is not written.
+     **/
+    bool    GenerateMappingFileBin(QString path, QImage *final, int width_in, int height_in, int majorVersion = 1);
+    /*
+     * GenerateMappingFileBin() : the mapping file of the Process3 table of
+     * params, taken from the model (or the RemapTableCache) without any
+     * image, for any input size. version 1 is always nearest neighbour.
+     * false when the file is not written.
+     **/
+    bool    GenerateMappingFileBin(QString path, const CorrectionParameters_t &params, int majorVersion = 1);
+
+    QImage  GetImageByBinData(QString path, QImage *input);
+    /*
+     * LoadMappingFileBin() : the table of a GenerateMappingFileBin() file,
+     * reading an input of width_in x height_in. return false when the file
+     * can not be read, is not a version 1.0 or 2 mapping file, or is a
+     * version 2 file of another input size.
+     **/
+    bool    LoadMappingFileBin(QString path, int width_in, int height_in, RemapTable *table);
+    /*
+     * MapMappingFileBin() : LoadMappingFileBin() which maps a version 2
+     * file in place instead of reading it. load the table once and Apply()
+     * it to every frame. flags are the RemapTableFile::Map() ones: keep
+     * MapVerify for a file from anywhere else, a stream which starts from
+     * a file of its own pipeline passes MapPopulate alone, it starts
+     * without the pass over the table and its first frames do not fault
+     * the pages in. a version 1 file is always read and checked.
+     **/
+    bool    MapMappingFileBin(QString path, int width_in, int height_in, RemapTable *table,
+            int flags = RemapTableFile::MapVerify);
+
+    /*
+     * GetArchLens() : get the arc length between the (x0, y0) and (x1, y1).
+     * a, b, c are the two-order curve cofficients.
+     * the first point : x0, y0.
+     * the second point: x1, y1.
+     * both are closed forms on ParabolaArcPrimitive().
+     **/
+    int     GetArchLens(float a, float b, float c, int x0, int y0, int x1, int y1);
+
+    float   GetArchLens(float a, float  b, float c, int x0, int x1);
+
+    /*
+     * ParabolaArcPrimitive() : an antiderivative of the arc length of the
+     * curve a * x^2 + b * x + c, the length from x0 to x1 is
+     * ParabolaArcPrimitive(a, b, x1) - ParabolaArcPrimitive(a, b, x0).
+     **/
+    static double ParabolaArcPrimitive(double a, double b, double x);
+
+    double  GetArchLensOfCircel(double a, double b, double r, int x);
+
+    double  GetAngelOfTwoLines(double k1, double k2);
+
+    int     AlignTo(int value, int k);
+
+    template<typename T>
+    void    Create2DArray(T **&array, int height, int width);
+
+    template<typename T>
+    void    Destroy2DArray(T **&array, int height);
+
+    int     GetDistance(int x, int y, int x1, int y1);
+
+    int     GetDistance2(int x, int y, int x1, int y1);
+
+    int     MyMin(int a, int b)
+    {
+        return (a > b) ? b : a;
+    }
+
+    int     MyMax(int a, int b)
+    {
+        return (a > b) ? a : b;
+    }
+
+    int     Range(int value, int min, int max)
+    {
+        if ( value < min) return min;
+        if ( value > max) return max;
+        return value;
+    }
+private:
+    FisheyeDistortionCorrection();
+    ~FisheyeDistortionCorrection();
+    void Initialize();
+
+    QString     mFilePath;
+    int         mWidth;
+    int         mHeight;
+    int         mOpticalCenterX;
+    int         mOpticalCenterY;
+    int         mRotation;
+    int         mHorizontalBase;
+    int         mVerticalBase;
+    int         mCropX;
+    int         mCropY;
+    int         mCropW;
+    int         mCropH;
+    RemapTable::Interpolation mInterpolation;
+    RemapTable::TraversalOrder mTraversalOrder;
+    bool        mSymmetricTables;
+
+    /*
+     * GenerateTables3() : the Process3 tables of params from the
+     * RemapTableCache, generated when they are not cached.
+     **/
+    void GenerateTables3(const CorrectionParameters_t &params, bool diagnostics);
+    /*
+     * WriteMappingFileBin() : the file of table in the major version, the
+     * points of version 1 are in pixels of any table format, version 2
+     * only holds RGB888 tables.
+     **/
+    bool WriteMappingFileBin(QString path, const RemapTable &table, int majorVersion);
+
+    // the DoImageRotate() table of the last size and angle.
+    RemapTable              mRotationTable;
+    int                     mRotationAngle;
+
+    RemapTable              mCorrectionTable3;
+    RemapSymmetricTable     mCorrectionSymmetric3;
+    RemapTable              mHorizontalTable3;
+    RemapSpanTable          mHorizontalSpans3;
+    RemapTable              mVerticalTable3;
+    RemapSymmetricTable     mVerticalSymmetric3;
+    CorrectionParameters_t  mTable3Params;
+    // the stages of the diagnostic tables, a parameter change only generates the stages it reaches.
+    Process3Stages         *mStages3;
+};
+
+#endif // FisheyeDistortionCorrection_H
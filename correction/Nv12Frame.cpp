@@ -0,0 +1,94 @@
+#include "Nv12Frame.h"
+
+const uchar Nv12Frame::kBlackLuma;
+const uchar Nv12Frame::kNeutralChroma;
+
+static inline uchar ClampByte(int value)
+{
+    return static_cast<uchar>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+Nv12Frame::Nv12Frame()
+    : mWidth(0),
+      mHeight(0)
+{
+}
+
+Nv12Frame::Nv12Frame(int width, int height)
+    : mWidth(qMax(width, 0)),
+      mHeight(qMax(height, 0))
+{
+    mY.resize(YStride() * mHeight);
+    mUv.resize(UvStride() * ChromaHeight());
+}
+
+Nv12Frame Nv12Frame::FromImage(const QImage &image)
+{
+    const QImage rgb = (image.format() == QImage::Format_RGB888) ? image
+                                                                  : image.convertToFormat(QImage::Format_RGB888);
+    Nv12Frame frame(rgb.width(), rgb.height());
+    if (frame.IsNull())
+    {
+        return frame;
+    }
+
+    for (int y = 0; y < frame.mHeight; ++y)
+    {
+        const uchar *line   = rgb.constScanLine(y);
+        uchar *luma         = frame.YPlane() + y * frame.YStride();
+        for (int x = 0; x < frame.mWidth; ++x, line += 3)
+        {
+            luma[x] = static_cast<uchar>(((66 * line[0] + 129 * line[1] + 25 * line[2] + 128) >> 8) + 16);
+        }
+    }
+
+    for (int cy = 0; cy < frame.ChromaHeight(); ++cy)
+    {
+        const int y0    = 2 * cy;
+        const int y1    = qMin(y0 + 1, frame.mHeight - 1);
+        uchar *chroma   = frame.UvPlane() + cy * frame.UvStride();
+        for (int cx = 0; cx < frame.ChromaWidth(); ++cx)
+        {
+            const int x0 = 2 * cx;
+            const int x1 = qMin(x0 + 1, frame.mWidth - 1);
+            int sum[3] = { 0, 0, 0 };
+            for (int c = 0; c < 3; ++c)
+            {
+                sum[c] = rgb.constScanLine(y0)[x0 * 3 + c] + rgb.constScanLine(y0)[x1 * 3 + c]
+                       + rgb.constScanLine(y1)[x0 * 3 + c] + rgb.constScanLine(y1)[x1 * 3 + c];
+            }
+            const int r = (sum[0] + 2) >> 2;
+            const int g = (sum[1] + 2) >> 2;
+            const int b = (sum[2] + 2) >> 2;
+            chroma[2 * cx]      = ClampByte(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            chroma[2 * cx + 1]  = ClampByte(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+    return frame;
+}
+
+QImage Nv12Frame::ToImage() const
+{
+    if (IsNull())
+    {
+        return QImage();
+    }
+
+    QImage image(mWidth, mHeight, QImage::Format_RGB888);
+    for (int y = 0; y < mHeight; ++y)
+    {
+        const uchar *luma   = YPlane() + y * YStride();
+        const uchar *chroma = UvPlane() + (y / 2) * UvStride();
+        uchar *line         = image.scanLine(y);
+        for (int x = 0; x < mWidth; ++x, line += 3)
+        {
+            const int c = 298 * (luma[x] - 16);
+            const int d = chroma[(x / 2) * 2] - 128;
+            const int e = chroma[(x / 2) * 2 + 1] - 128;
+            line[0] = ClampByte((c + 409 * e + 128) >> 8);
+            line[1] = ClampByte((c - 100 * d - 208 * e + 128) >> 8);
+            line[2] = ClampByte((c + 516 * d + 128) >> 8);
+        }
+    }
+    return image;
+}
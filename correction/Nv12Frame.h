@@ -0,0 +1,55 @@
+#ifndef Nv12Frame_H
+#define Nv12Frame_H
+
+#include <QByteArray>
+#include <QImage>
+
+/**
+ * Nv12Frame : a YUV 4:2:0 frame as the cameras deliver it, a full
+ * resolution luma plane and a half resolution plane of interleaved
+ * U, V samples. the planes are packed, YStride() is the width and
+ * UvStride() is two bytes per chroma sample.
+ * the samples are BT.601 limited range, black is (16, 128, 128).
+ * an odd width or height gets the chroma of the last column or row
+ * rounded up.
+ **/
+class Nv12Frame
+{
+public:
+    static const uchar kBlackLuma       = 16;
+    static const uchar kNeutralChroma   = 128;
+
+    Nv12Frame();
+    Nv12Frame(int width, int height);
+
+    bool    IsNull() const              { return mWidth <= 0 || mHeight <= 0; }
+    int     Width() const               { return mWidth; }
+    int     Height() const              { return mHeight; }
+    int     ChromaWidth() const         { return (mWidth + 1) / 2; }
+    int     ChromaHeight() const        { return (mHeight + 1) / 2; }
+    int     YStride() const             { return mWidth; }
+    int     UvStride() const            { return ChromaWidth() * 2; }
+    // the bytes of both planes, half of a RGB888 frame.
+    int     ByteSize() const            { return mY.size() + mUv.size(); }
+
+    const uchar *YPlane() const         { return reinterpret_cast<const uchar *>(mY.constData()); }
+    const uchar *UvPlane() const        { return reinterpret_cast<const uchar *>(mUv.constData()); }
+    uchar  *YPlane()                    { return reinterpret_cast<uchar *>(mY.data()); }
+    uchar  *UvPlane()                   { return reinterpret_cast<uchar *>(mUv.data()); }
+
+    /*
+     * FromImage(), ToImage() : the BT.601 conversions, for the views and
+     * the comparisons, the NV12 path itself never converts a frame.
+     * FromImage() averages the chroma of every 2x2 block.
+     **/
+    static Nv12Frame FromImage(const QImage &image);
+    QImage  ToImage() const;
+
+private:
+    int         mWidth;
+    int         mHeight;
+    QByteArray  mY;
+    QByteArray  mUv;
+};
+
+#endif // Nv12Frame_H
@@ -0,0 +1,134 @@
+#include "Process3Stages.h"
+
+#include <QDebug>
+
+Process3Stages::Process3Stages(bool diagnostics)
+    : mDiagnostics(diagnostics)
+{
+    Clear();
+}
+
+void Process3Stages::Clear()
+{
+    mValid          = false;
+    mParams         = CorrectionParameters_t();
+    mPending        = 0;
+    mOrderPending   = false;
+    mMapWidth       = 0;
+    mMappedX.clear();
+    mSubPixelX.clear();
+    mMappedW.clear();
+    mSubPixelW.clear();
+    mHorizontalTable.Clear();
+    mVerticalTable.Clear();
+    mCorrectionTable.Clear();
+}
+
+static bool IsCancelled(const QAtomicInt *cancelled)
+{
+    return cancelled != NULL && cancelled->loadAcquire() != 0;
+}
+
+int Process3Stages::Update(const CorrectionParameters_t &params, const QAtomicInt *cancelled)
+{
+    const CorrectionParameters_t &last = mParams;
+    const bool bilinear = (params.interpolation == RemapTable::Bilinear);
+
+    // the inputs of every stage, a stage is generated again with the stages it reads.
+    // mPending holds the stages a cancelled Update() did not reach.
+    const bool frame            = !mValid || params.width != last.width || params.height != last.height
+                                  || params.optical_center_x != last.optical_center_x
+                                  || params.interpolation != last.interpolation;
+    const bool horizontalMap    = frame || params.optical_center_y != last.optical_center_y
+                                  || params.vertical_base != last.vertical_base
+                                  || (mPending & HorizontalMapStage);
+    const bool verticalMap      = frame || params.horizontal_base != last.horizontal_base
+                                  || (mPending & VerticalMapStage);
+    const bool rotation         = horizontalMap || params.rotation != last.rotation;
+    const bool horizontalTable  = mDiagnostics && (rotation || (mPending & HorizontalTableStage));
+    const bool verticalTable    = rotation || verticalMap || (mPending & VerticalTableStage);
+    const bool correctionTable  = verticalTable || params.crop_x != last.crop_x || params.crop_y != last.crop_y
+                                  || params.crop_w != last.crop_w || params.crop_h != last.crop_h
+                                  || (mPending & CorrectionTableStage);
+    const bool order            = !mValid || mOrderPending || params.traversal_order != last.traversal_order;
+
+    // from here the tables follow params, a stage clears its bit once it is generated.
+    mPending        = (horizontalMap ? HorizontalMapStage : 0) | (verticalMap ? VerticalMapStage : 0)
+                    | (horizontalTable ? HorizontalTableStage : 0) | (verticalTable ? VerticalTableStage : 0)
+                    | (correctionTable ? CorrectionTableStage : 0);
+    mOrderPending   = order;
+    mParams         = params;
+    mValid          = true;
+
+    FisheyeDistortionCorrection *correction = FisheyeDistortionCorrection::getInstance();
+    const QVector<QPointF> *subPixelX = bilinear ? &mSubPixelX : NULL;
+    const QVector<double> *subPixelW  = bilinear ? &mSubPixelW : NULL;
+    int stages = 0;
+    if (horizontalMap && !IsCancelled(cancelled))
+    {
+        mMapWidth = correction->GenerateHorizontalMap3(params, &mMappedX, bilinear ? &mSubPixelX : NULL);
+        if (!bilinear)
+        {
+            mSubPixelX.clear();
+        }
+        stages |= HorizontalMapStage;
+    }
+
+    const QRect mapRect(0, 0, mMapWidth, params.height);
+    if (verticalMap && !IsCancelled(cancelled))
+    {
+        correction->GenerateVerticalMap3(params, mMapWidth, mapRect, &mMappedW, bilinear ? &mSubPixelW : NULL);
+        if (!bilinear)
+        {
+            mSubPixelW.clear();
+        }
+        stages |= VerticalMapStage;
+    }
+    // Reset() goes back to the row major order.
+    if (horizontalTable && !IsCancelled(cancelled))
+    {
+        correction->GenerateHorizontalTable3(params, mMappedX, subPixelX, mMapWidth, &mHorizontalTable);
+        mHorizontalTable.SetTraversalOrder(params.traversal_order);
+        stages |= HorizontalTableStage;
+    }
+    if (verticalTable && !IsCancelled(cancelled))
+    {
+        correction->ComposeCorrectionTable3(params, mMappedX, mMapWidth, mapRect, mMappedW, &mVerticalTable,
+                                            subPixelX, subPixelW);
+        mVerticalTable.SetTraversalOrder(params.traversal_order);
+        stages |= VerticalTableStage;
+    }
+    if (correctionTable && !IsCancelled(cancelled))
+    {
+        const QRect crop = correction->GetCropRect3(params, mMapWidth);
+        mCorrectionTable.Reset(params.width, params.height, crop.width(), crop.height(), params.interpolation);
+        mCorrectionTable.SetEntries(mVerticalTable, crop);
+        mCorrectionTable.SetTraversalOrder(params.traversal_order);
+        stages |= CorrectionTableStage;
+    }
+
+    // a stage runs only after the stages it reads, the first cancelled one leaves the rest pending.
+    mPending &= ~stages;
+    if (mPending != 0)
+    {
+        qDebug("process3 stages: cancelled, generated 0x%02x, pending 0x%02x", stages, mPending);
+        return stages;
+    }
+
+    // the tables which were not generated again only take the new order.
+    if (order && !(stages & HorizontalTableStage))
+    {
+        mHorizontalTable.SetTraversalOrder(params.traversal_order);
+    }
+    if (order && !(stages & VerticalTableStage))
+    {
+        mVerticalTable.SetTraversalOrder(params.traversal_order);
+    }
+    if (order && !(stages & CorrectionTableStage))
+    {
+        mCorrectionTable.SetTraversalOrder(params.traversal_order);
+    }
+    mOrderPending = false;
+    qDebug("process3 stages: generated 0x%02x", stages);
+    return stages;
+}
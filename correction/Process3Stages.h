@@ -0,0 +1,71 @@
+#ifndef Process3Stages_H
+#define Process3Stages_H
+
+#include <QAtomicInt>
+#include <QPoint>
+#include <QPointF>
+#include <QVector>
+#include "FisheyeDistortionCorrection.h"
+#include "RemapTable.h"
+
+/**
+ * Process3Stages : the Process3 tables of the diagnostic views (and of the
+ * full resolution preview, see CorrectionPreview) as a chain of stages. every stage keeps its output with the parameters it was
+ * generated from, and Update() only generates the stages one of whose
+ * inputs changed:
+ *   horizontal map     : size, optical center, vertical_base, interpolation.
+ *   vertical map       : size, optical center x, horizontal_base, interpolation.
+ *   horizontal table   : horizontal map, rotation.
+ *   vertical table     : horizontal map, vertical map, rotation.
+ *   correction table   : vertical table, crop (the crop of the vertical table).
+ * the traversal order is set again on the tables when it changes.
+ * the maps stay in memory, about 30 bytes per hImage pixel in Bilinear mode.
+ * without diagnostics the horizontal table (only the hImage view reads
+ * it) is not generated, the other stages are the same.
+ **/
+class Process3Stages
+{
+public:
+    enum Stage
+    {
+        HorizontalMapStage      = 0x01,
+        VerticalMapStage        = 0x02,
+        HorizontalTableStage    = 0x04,
+        VerticalTableStage      = 0x08,
+        CorrectionTableStage    = 0x10
+    };
+
+    explicit Process3Stages(bool diagnostics = true);
+
+    /*
+     * Update() : bring the tables up to params, return the Stage bits of
+     * the stages which were generated again (0 when nothing changed).
+     * cancelled (optional) is checked before every stage, once it is set
+     * Update() returns and the tables are not up to params, the next
+     * Update() generates the stages which are left.
+     **/
+    int     Update(const CorrectionParameters_t &params, const QAtomicInt *cancelled = NULL);
+    void    Clear();
+
+    const RemapTable &HorizontalTable() const   { return mHorizontalTable; }
+    const RemapTable &VerticalTable() const     { return mVerticalTable; }
+    const RemapTable &CorrectionTable() const   { return mCorrectionTable; }
+
+private:
+    bool                    mDiagnostics;
+    bool                    mValid;
+    CorrectionParameters_t  mParams;
+    // the Stage bits a cancelled Update() left behind mParams, and its order.
+    int                     mPending;
+    bool                    mOrderPending;
+    int                     mMapWidth;
+    QVector<QPoint>         mMappedX;
+    QVector<QPointF>        mSubPixelX;
+    QVector<int>            mMappedW;
+    QVector<double>         mSubPixelW;
+    RemapTable              mHorizontalTable;
+    RemapTable              mVerticalTable;
+    RemapTable              mCorrectionTable;
+};
+
+#endif // Process3Stages_H
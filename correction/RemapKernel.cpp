@@ -0,0 +1,787 @@
+#include "RemapKernel.h"
+
+#include <cstring>
+
+// 32-bit MinGW does not keep the stack 32-byte aligned for AVX spills,
+// so the AVX2 kernel is only built where that is safe.
+#if defined(Q_PROCESSOR_X86) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG) || defined(Q_CC_MSVC))
+#  define REMAP_KERNEL_X86
+#  if !(defined(Q_OS_WIN) && !defined(Q_PROCESSOR_X86_64) && defined(Q_CC_GNU))
+#    define REMAP_KERNEL_AVX2
+#  endif
+#endif
+
+#ifdef REMAP_KERNEL_X86
+#  include <immintrin.h>
+#  ifdef Q_CC_MSVC
+#    include <intrin.h>
+#  endif
+#  if defined(Q_CC_GNU) || defined(Q_CC_CLANG)
+#    define REMAP_TARGET(isa) __attribute__((target(isa)))
+#  else
+#    define REMAP_TARGET(isa)
+#  endif
+#endif
+
+template <typename Sample>
+static inline int LoadSample(const uchar *pixel, int channel)
+{
+    Sample sample;
+    memcpy(&sample, pixel + channel * sizeof(Sample), sizeof(Sample));
+    return sample;
+}
+
+template <typename Sample>
+static inline void StoreSample(uchar *pixel, int channel, int value)
+{
+    const Sample sample = static_cast<Sample>(value);
+    memcpy(pixel + channel * sizeof(Sample), &sample, sizeof(Sample));
+}
+
+template <class Pixel>
+void RemapKernel::RowScalar(uchar *dst, const uchar *src, const qint32 *entries, int count, qint32 safeLimit,
+                            uchar fill)
+{
+    Q_UNUSED(safeLimit);
+    for (int x = 0; x < count; ++x, dst += Pixel::kBytes)
+    {
+        const qint32 offset = entries[x];
+        if (offset < 0)
+        {
+            memset(dst, fill, Pixel::kBytes);
+            continue;
+        }
+        memcpy(dst, src + offset, Pixel::kBytes);
+    }
+}
+
+template <class Pixel>
+void RemapKernel::BilinearRowScalar(uchar *dst, const uchar *src, const qint32 *entries, const quint8 *fractions,
+                                    int count, int srcStride, qint32 safeLimit, uchar fill)
+{
+    typedef typename Pixel::Sample Sample;
+    Q_UNUSED(safeLimit);
+    for (int x = 0; x < count; ++x, dst += Pixel::kBytes)
+    {
+        const qint32 offset = entries[x];
+        if (offset < 0)
+        {
+            memset(dst, fill, Pixel::kBytes);
+            continue;
+        }
+        const int fx        = fractions[x] >> kFractionBits;
+        const int fy        = fractions[x] & (kFractionOne - 1);
+        const int w00       = (kFractionOne - fx) * (kFractionOne - fy);
+        const int w10       = fx * (kFractionOne - fy);
+        const int w01       = (kFractionOne - fx) * fy;
+        const int w11       = fx * fy;
+        const uchar *p00    = src + offset;
+        const uchar *p10    = p00 + (fx ? Pixel::kBytes : 0);
+        const uchar *p01    = p00 + (fy ? srcStride : 0);
+        const uchar *p11    = p01 + (fx ? Pixel::kBytes : 0);
+        for (int c = 0; c < Pixel::kChannels; ++c)
+        {
+            // a 16-bit sample times the weights (256 at most) still fits an int.
+            StoreSample<Sample>(dst, c, (LoadSample<Sample>(p00, c) * w00 + LoadSample<Sample>(p10, c) * w10
+                                         + LoadSample<Sample>(p01, c) * w01 + LoadSample<Sample>(p11, c) * w11
+                                         + (1 << (2 * kFractionBits - 1))) >> (2 * kFractionBits));
+        }
+    }
+}
+
+void RemapKernel::SpanRowScalar(uchar *dst, const uchar *src, const RemapSpan_t *spans, int count, qint32 safeLimit)
+{
+    Q_UNUSED(safeLimit);
+    for (int n = 0; n < count; ++n)
+    {
+        const RemapSpan_t &span = spans[n];
+        uchar *out = dst + span.start * 3;
+        if (span.source < 0)
+        {
+            memset(out, 0, span.length * 3);
+            continue;
+        }
+        const uchar *pixel = src + span.source;
+        for (int x = 0; x < span.length; ++x, out += 3)
+        {
+            if (x < kSpanAdvanceBits && ((span.advance >> x) & 1))
+            {
+                pixel += 3;
+            }
+            out[0] = pixel[0];
+            out[1] = pixel[1];
+            out[2] = pixel[2];
+        }
+    }
+}
+
+void RemapKernel::ReflectScalar(qint32 *entries, const quint32 *points, int count, bool reverse,
+                                const RemapReflection_t &reflection)
+{
+    const int step = reverse ? -1 : 1;
+    for (int n = 0; n < count; ++n, points += step)
+    {
+        const int x = reflection.baseX + reflection.signX * static_cast<int>(*points & 0xffff);
+        const int y = reflection.baseY + reflection.signY * static_cast<int>(*points >> 16);
+        if (x < 0 || x >= reflection.srcWidth || y < 0 || y >= reflection.srcHeight)
+        {
+            entries[n] = -1;
+            continue;
+        }
+        entries[n] = y * reflection.srcStride + x * 3;
+    }
+}
+
+#ifdef REMAP_KERNEL_X86
+static inline quint32 LoadPixel32(const uchar *src, qint32 offset)
+{
+    quint32 value;
+    memcpy(&value, src + offset, sizeof(value));
+    return value;
+}
+
+/**
+ * the pshufb mask which keeps the first bytes of every 32-bit word,
+ * the 4 pixels of a step packed at the start of the register.
+ **/
+static inline char PackByte(int bytes, int n)
+{
+    return (n < 4 * bytes) ? static_cast<char>((n / bytes) * 4 + n % bytes) : static_cast<char>(-1);
+}
+
+REMAP_TARGET("sse4.1")
+static inline __m128i PackMask(int bytes)
+{
+    return _mm_setr_epi8(PackByte(bytes, 0), PackByte(bytes, 1), PackByte(bytes, 2), PackByte(bytes, 3),
+                         PackByte(bytes, 4), PackByte(bytes, 5), PackByte(bytes, 6), PackByte(bytes, 7),
+                         PackByte(bytes, 8), PackByte(bytes, 9), PackByte(bytes, 10), PackByte(bytes, 11),
+                         PackByte(bytes, 12), PackByte(bytes, 13), PackByte(bytes, 14), PackByte(bytes, 15));
+}
+
+/**
+ * store the 4 packed pixels of a step. the RGB888 pixels are stored with a
+ * 16-byte store which spills 4 bytes into the next step, so a RGB888 step
+ * needs SpillPixels() more pixels of room in the row.
+ **/
+template <int Bytes>
+REMAP_TARGET("sse4.1")
+static inline void Store4(uchar *dst, __m128i packed)
+{
+    if (Bytes == 1)
+    {
+        const int value = _mm_cvtsi128_si32(packed);
+        memcpy(dst, &value, sizeof(value));
+    }
+    else if (Bytes == 2)
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), packed);
+    }
+    else
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), packed);
+    }
+}
+
+static inline int SpillPixels(int bytes)
+{
+    return (bytes == 3) ? 2 : 0;
+}
+
+/**
+ * SSE4.1 : 4 pixels per step.
+ * the 4 source pixels are loaded as 32-bit words (a RGB888 pixel and the
+ * next byte), then one pshufb keeps the pixel bytes and they are stored
+ * at once.
+ **/
+template <class Pixel>
+REMAP_TARGET("sse4.1")
+static void RowSSE41(uchar *dst, const uchar *src, const qint32 *entries, int count, qint32 safeLimit, uchar fill)
+{
+    const __m128i shuffle = PackMask(Pixel::kBytes);
+    int x = 0;
+    for (; x + 4 + SpillPixels(Pixel::kBytes) <= count; x += 4, dst += 4 * Pixel::kBytes)
+    {
+        const qint32 o0 = entries[x];
+        const qint32 o1 = entries[x + 1];
+        const qint32 o2 = entries[x + 2];
+        const qint32 o3 = entries[x + 3];
+        if (quint32(o0) > quint32(safeLimit) || quint32(o1) > quint32(safeLimit)
+                || quint32(o2) > quint32(safeLimit) || quint32(o3) > quint32(safeLimit))
+        {
+            // invalid entries (negative) and the last bytes of src take the scalar way.
+            RemapKernel::RowScalar<Pixel>(dst, src, entries + x, 4, safeLimit, fill);
+            continue;
+        }
+        const __m128i pixels = _mm_setr_epi32(LoadPixel32(src, o0), LoadPixel32(src, o1),
+                                              LoadPixel32(src, o2), LoadPixel32(src, o3));
+        Store4<Pixel::kBytes>(dst, _mm_shuffle_epi8(pixels, shuffle));
+    }
+    RemapKernel::RowScalar<Pixel>(dst, src, entries + x, count - x, safeLimit, fill);
+}
+
+/**
+ * SSE4.1 : 4 points per step, a backward step loads the 4 points below
+ * points[0] and reverses them.
+ **/
+REMAP_TARGET("sse4.1")
+static void ReflectSSE41(qint32 *entries, const quint32 *points, int count, bool reverse,
+                         const RemapReflection_t &reflection)
+{
+    const __m128i lowMask   = _mm_set1_epi32(0xffff);
+    const __m128i allOnes   = _mm_set1_epi32(-1);
+    const __m128i baseX     = _mm_set1_epi32(reflection.baseX);
+    // v * sign is (v ^ mask) - mask, the mask is -1 for a negative sign.
+    const __m128i signX     = _mm_set1_epi32(reflection.signX < 0 ? -1 : 0);
+    const __m128i baseY     = _mm_set1_epi32(reflection.baseY);
+    const __m128i signY     = _mm_set1_epi32(reflection.signY < 0 ? -1 : 0);
+    const __m128i width     = _mm_set1_epi32(reflection.srcWidth);
+    const __m128i height    = _mm_set1_epi32(reflection.srcHeight);
+    const __m128i stride    = _mm_set1_epi32(reflection.srcStride);
+    int n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        __m128i p;
+        if (reverse)
+        {
+            p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(points - n - 3));
+            p = _mm_shuffle_epi32(p, _MM_SHUFFLE(0, 1, 2, 3));
+        }
+        else
+        {
+            p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(points + n));
+        }
+        const __m128i x = _mm_add_epi32(baseX, _mm_sub_epi32(_mm_xor_si128(_mm_and_si128(p, lowMask), signX), signX));
+        const __m128i y = _mm_add_epi32(baseY, _mm_sub_epi32(_mm_xor_si128(_mm_srli_epi32(p, 16), signY), signY));
+        const __m128i inside = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(x, allOnes), _mm_cmpgt_epi32(width, x)),
+                                             _mm_and_si128(_mm_cmpgt_epi32(y, allOnes), _mm_cmpgt_epi32(height, y)));
+        const __m128i entry = _mm_add_epi32(_mm_mullo_epi32(y, stride), _mm_add_epi32(x, _mm_add_epi32(x, x)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(entries + n),
+                         _mm_or_si128(entry, _mm_andnot_si128(inside, allOnes)));
+    }
+    RemapKernel::ReflectScalar(entries + n, reverse ? points - n : points + n, count - n, reverse, reflection);
+}
+
+/**
+ * the pshufb masks of 4 stepping pixels, indexed by their 3 advance bits.
+ * pixel j takes the source pixel (advance bits 1..j) of the 16-byte load.
+ **/
+static const qint8 kStepShuffle[8][16] =
+{
+    { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2,  -1, -1, -1, -1 },
+    { 0, 1, 2, 3, 4, 5, 3, 4, 5, 3, 4, 5,  -1, -1, -1, -1 },
+    { 0, 1, 2, 0, 1, 2, 3, 4, 5, 3, 4, 5,  -1, -1, -1, -1 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 6, 7, 8,  -1, -1, -1, -1 },
+    { 0, 1, 2, 0, 1, 2, 0, 1, 2, 3, 4, 5,  -1, -1, -1, -1 },
+    { 0, 1, 2, 3, 4, 5, 3, 4, 5, 6, 7, 8,  -1, -1, -1, -1 },
+    { 0, 1, 2, 0, 1, 2, 3, 4, 5, 6, 7, 8,  -1, -1, -1, -1 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, -1, -1, -1, -1 }
+};
+
+// the number of set bits of a 4-bit value.
+static const int kBitCount4[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+// the advance bits [first, first + 4) of a span.
+static inline int AdvanceBits4(quint32 advance, int first)
+{
+    return (first < RemapKernel::kSpanAdvanceBits) ? static_cast<int>((advance >> first) & 15) : 0;
+}
+
+/**
+ * the pixels [x, length) of a stepping span, the pixel x reads offset.
+ **/
+static inline void StepTail(uchar *out, const uchar *src, qint32 offset, quint32 advance, int x, int length)
+{
+    const uchar *pixel = src + offset;
+    for (int n = x; n < length; ++n, out += 3)
+    {
+        if (n > x && n < RemapKernel::kSpanAdvanceBits && ((advance >> n) & 1))
+        {
+            pixel += 3;
+        }
+        out[0] = pixel[0];
+        out[1] = pixel[1];
+        out[2] = pixel[2];
+    }
+}
+
+/**
+ * SSE4.1 span kernel.
+ * a plain run repeats its pixel into a 48-byte pattern (16 pixels) by
+ * three pshufb and stores it 16 pixels per step.
+ * a stepping run reads at most 4 source pixels for 4 output pixels, so
+ * one 16-byte load and one pshufb picked by the advance bits give 4 pixels.
+ * the spans are stored from left to right, so the 16-byte stores may run
+ * past the end of a span, the next spans overwrite those bytes. they only
+ * have to stay inside the row.
+ * the kernel is store bound, so the AVX2 dispatch uses it too.
+ **/
+REMAP_TARGET("sse4.1")
+static void SpanRowSSE41(uchar *dst, const uchar *src, const RemapSpan_t *spans, int count, qint32 safeLimit)
+{
+    const __m128i shuffle0  = _mm_setr_epi8(0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0);
+    const __m128i shuffle1  = _mm_setr_epi8(1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1);
+    const __m128i shuffle2  = _mm_setr_epi8(2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2);
+    // the last offset where a 16-byte load stays inside src.
+    const qint32 loadLimit  = safeLimit - 12;
+    // the last byte offset where a 16-byte store stays inside the row.
+    const int storeLimit    = (count > 0) ? (spans[count - 1].start + spans[count - 1].length) * 3 - 16 : 0;
+    for (int n = 0; n < count; ++n)
+    {
+        const RemapSpan_t &span = spans[n];
+        uchar *out              = dst + span.start * 3;
+        if (span.source < 0)
+        {
+            memset(out, 0, span.length * 3);
+            continue;
+        }
+
+        if (span.advance != 0)
+        {
+            qint32 offset   = span.source;
+            int x           = 0;
+            for (; x < span.length && out - dst <= storeLimit && offset <= loadLimit; x += 4, out += 12)
+            {
+                const int bits          = AdvanceBits4(span.advance, x + 1);
+                const __m128i pixels    = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + offset));
+                const __m128i shuffle   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kStepShuffle[bits & 7]));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(pixels, shuffle));
+                offset += 3 * kBitCount4[bits];
+            }
+            if (x < span.length)
+            {
+                StepTail(out, src, offset, span.advance, x, span.length);
+            }
+            continue;
+        }
+
+        if (span.length < 16 || span.source > safeLimit)
+        {
+            // the short runs and the last bytes of src.
+            RemapKernel::SpanRowScalar(dst, src, &span, 1, safeLimit);
+            continue;
+        }
+        const __m128i pixel = _mm_cvtsi32_si128(static_cast<int>(LoadPixel32(src, span.source)));
+        const __m128i v0    = _mm_shuffle_epi8(pixel, shuffle0);
+        const __m128i v1    = _mm_shuffle_epi8(pixel, shuffle1);
+        const __m128i v2    = _mm_shuffle_epi8(pixel, shuffle2);
+        int length          = span.length;
+        for (; length >= 16; length -= 16, out += 48)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v0);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), v1);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 32), v2);
+        }
+        if (length > 0)
+        {
+            // the pattern restarts every 48 bytes, so the tail is its head.
+            uchar tail[48];
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(tail), v0);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(tail + 16), v1);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(tail + 32), v2);
+            memcpy(out, tail, length * 3);
+        }
+    }
+}
+
+/**
+ * the bilinear weights of 4 pixels as 32-bit lanes.
+ * the 4 taps of each pixel are (offset, +dx, +dy, +dx+dy), with dx = bytes
+ * and dy = srcStride only for a non-zero fraction.
+ **/
+REMAP_TARGET("sse4.1")
+static inline void BilinearSetup4(__m128i fractions, __m128i stride, int bytes, __m128i *w00, __m128i *w10,
+                                  __m128i *w01, __m128i *w11, __m128i *dx, __m128i *dy)
+{
+    const __m128i one   = _mm_set1_epi32(RemapKernel::kFractionOne);
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i fx    = _mm_srli_epi32(fractions, RemapKernel::kFractionBits);
+    const __m128i fy    = _mm_and_si128(fractions, _mm_set1_epi32(RemapKernel::kFractionOne - 1));
+    const __m128i ifx   = _mm_sub_epi32(one, fx);
+    const __m128i ify   = _mm_sub_epi32(one, fy);
+    *w00 = _mm_mullo_epi32(ifx, ify);
+    *w10 = _mm_mullo_epi32(fx, ify);
+    *w01 = _mm_mullo_epi32(ifx, fy);
+    *w11 = _mm_mullo_epi32(fx, fy);
+    *dx  = _mm_and_si128(_mm_cmpgt_epi32(fx, zero), _mm_set1_epi32(bytes));
+    *dy  = _mm_and_si128(_mm_cmpgt_epi32(fy, zero), stride);
+}
+
+/**
+ * widen one 32-bit weight per pixel to the 16-bit layout of unpacked
+ * pixels: (w0, w0, w0, w0, w1, w1, w1, w1) for the low half.
+ **/
+REMAP_TARGET("sse4.1")
+static inline __m128i WeightsLo(__m128i w)
+{
+    const __m128i w2 = _mm_or_si128(w, _mm_slli_epi32(w, 16));
+    return _mm_unpacklo_epi32(w2, w2);
+}
+
+REMAP_TARGET("sse4.1")
+static inline __m128i WeightsHi(__m128i w)
+{
+    const __m128i w2 = _mm_or_si128(w, _mm_slli_epi32(w, 16));
+    return _mm_unpackhi_epi32(w2, w2);
+}
+
+/**
+ * blend 4 pixels (32-bit lanes, 4 8-bit samples) of each tap in 16-bit fixed point.
+ * every product fits 16 bits (255 * 256) and so does the rounded sum.
+ **/
+REMAP_TARGET("sse4.1")
+static inline __m128i Blend4(__m128i p00, __m128i p10, __m128i p01, __m128i p11,
+                             __m128i w00, __m128i w10, __m128i w01, __m128i w11)
+{
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(1 << (2 * RemapKernel::kFractionBits - 1));
+    __m128i lo = round;
+    __m128i hi = round;
+    lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(p00, zero), WeightsLo(w00)));
+    hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(p00, zero), WeightsHi(w00)));
+    lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(p10, zero), WeightsLo(w10)));
+    hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(p10, zero), WeightsHi(w10)));
+    lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(p01, zero), WeightsLo(w01)));
+    hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(p01, zero), WeightsHi(w01)));
+    lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(p11, zero), WeightsLo(w11)));
+    hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(p11, zero), WeightsHi(w11)));
+    lo = _mm_srli_epi16(lo, 2 * RemapKernel::kFractionBits);
+    hi = _mm_srli_epi16(hi, 2 * RemapKernel::kFractionBits);
+    return _mm_packus_epi16(lo, hi);
+}
+
+REMAP_TARGET("sse4.1")
+static inline __m128i Load4(const uchar *src, __m128i offsets)
+{
+    return _mm_setr_epi32(LoadPixel32(src, _mm_extract_epi32(offsets, 0)),
+                          LoadPixel32(src, _mm_extract_epi32(offsets, 1)),
+                          LoadPixel32(src, _mm_extract_epi32(offsets, 2)),
+                          LoadPixel32(src, _mm_extract_epi32(offsets, 3)));
+}
+
+template <class Pixel>
+REMAP_TARGET("sse4.1")
+static void BilinearRowSSE41(uchar *dst, const uchar *src, const qint32 *entries, const quint8 *fractions,
+                             int count, int srcStride, qint32 safeLimit, uchar fill)
+{
+    const __m128i shuffle   = PackMask(Pixel::kBytes);
+    const __m128i stride    = _mm_set1_epi32(srcStride);
+    const __m128i limit     = _mm_set1_epi32(safeLimit);
+    const __m128i invalid   = _mm_set1_epi32(-1);
+    int x = 0;
+    for (; x + 4 + SpillPixels(Pixel::kBytes) <= count; x += 4, dst += 4 * Pixel::kBytes)
+    {
+        const __m128i o00 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(entries + x));
+        qint32 packed;
+        memcpy(&packed, fractions + x, sizeof(packed));
+        __m128i w00, w10, w01, w11, dx, dy;
+        BilinearSetup4(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)), stride, Pixel::kBytes, &w00, &w10, &w01, &w11, &dx, &dy);
+        const __m128i o10 = _mm_add_epi32(o00, dx);
+        const __m128i o01 = _mm_add_epi32(o00, dy);
+        const __m128i o11 = _mm_add_epi32(o01, dx);
+        const __m128i bad = _mm_or_si128(_mm_cmpeq_epi32(o00, invalid), _mm_cmpgt_epi32(o11, limit));
+        if (!_mm_testz_si128(bad, bad))
+        {
+            RemapKernel::BilinearRowScalar<Pixel>(dst, src, entries + x, fractions + x, 4, srcStride, safeLimit, fill);
+            continue;
+        }
+        const __m128i pixels = Blend4(Load4(src, o00), Load4(src, o10), Load4(src, o01), Load4(src, o11),
+                                      w00, w10, w01, w11);
+        Store4<Pixel::kBytes>(dst, _mm_shuffle_epi8(pixels, shuffle));
+    }
+    RemapKernel::BilinearRowScalar<Pixel>(dst, src, entries + x, fractions + x, count - x, srcStride, safeLimit,
+                                          fill);
+}
+
+#ifdef REMAP_KERNEL_AVX2
+/**
+ * AVX2 : 8 pixels per step with one masked 32-bit gather.
+ * invalid entries are masked out of the gather and keep the fill bytes.
+ * each 128-bit lane is packed and stored as a step of Store4().
+ **/
+template <class Pixel>
+REMAP_TARGET("avx2")
+static void RowAVX2(uchar *dst, const uchar *src, const qint32 *entries, int count, qint32 safeLimit, uchar fill)
+{
+    const __m128i mask    = PackMask(Pixel::kBytes);
+    const __m256i shuffle = _mm256_inserti128_si256(_mm256_castsi128_si256(mask), mask, 1);
+    const __m256i filled  = _mm256_set1_epi8(static_cast<char>(fill));
+    const __m256i invalid = _mm256_set1_epi32(-1);
+    const __m256i limit   = _mm256_set1_epi32(safeLimit);
+    int x = 0;
+    for (; x + 8 + SpillPixels(Pixel::kBytes) <= count; x += 8, dst += 8 * Pixel::kBytes)
+    {
+        const __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(entries + x));
+        const __m256i unsafe  = _mm256_cmpgt_epi32(offsets, limit);
+        if (!_mm256_testz_si256(unsafe, unsafe))
+        {
+            RemapKernel::RowScalar<Pixel>(dst, src, entries + x, 8, safeLimit, fill);
+            continue;
+        }
+        const __m256i valid   = _mm256_cmpgt_epi32(offsets, invalid);
+        const __m256i pixels  = _mm256_mask_i32gather_epi32(filled, reinterpret_cast<const int *>(src),
+                                                            offsets, valid, 1);
+        const __m256i packed  = _mm256_shuffle_epi8(pixels, shuffle);
+        Store4<Pixel::kBytes>(dst, _mm256_castsi256_si128(packed));
+        Store4<Pixel::kBytes>(dst + 4 * Pixel::kBytes, _mm256_extracti128_si256(packed, 1));
+    }
+    RemapKernel::RowScalar<Pixel>(dst, src, entries + x, count - x, safeLimit, fill);
+}
+
+REMAP_TARGET("avx2")
+static inline __m256i WeightsLo(__m256i w)
+{
+    const __m256i w2 = _mm256_or_si256(w, _mm256_slli_epi32(w, 16));
+    return _mm256_unpacklo_epi32(w2, w2);
+}
+
+REMAP_TARGET("avx2")
+static inline __m256i WeightsHi(__m256i w)
+{
+    const __m256i w2 = _mm256_or_si256(w, _mm256_slli_epi32(w, 16));
+    return _mm256_unpackhi_epi32(w2, w2);
+}
+
+REMAP_TARGET("avx2")
+static inline void Accumulate(__m256i *lo, __m256i *hi, __m256i pixels, __m256i weights)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    *lo = _mm256_add_epi16(*lo, _mm256_mullo_epi16(_mm256_unpacklo_epi8(pixels, zero), WeightsLo(weights)));
+    *hi = _mm256_add_epi16(*hi, _mm256_mullo_epi16(_mm256_unpackhi_epi8(pixels, zero), WeightsHi(weights)));
+}
+
+/**
+ * AVX2 bilinear : 8 pixels per step, one gather for each of the 4 taps,
+ * the same 16-bit fixed-point blend as the SSE4.1 kernel.
+ **/
+template <class Pixel>
+REMAP_TARGET("avx2")
+static void BilinearRowAVX2(uchar *dst, const uchar *src, const qint32 *entries, const quint8 *fractions,
+                            int count, int srcStride, qint32 safeLimit, uchar fill)
+{
+    const __m128i pack      = PackMask(Pixel::kBytes);
+    const __m256i shuffle   = _mm256_inserti128_si256(_mm256_castsi128_si256(pack), pack, 1);
+    const __m256i one       = _mm256_set1_epi32(RemapKernel::kFractionOne);
+    const __m256i mask      = _mm256_set1_epi32(RemapKernel::kFractionOne - 1);
+    const __m256i dx        = _mm256_set1_epi32(Pixel::kBytes);
+    const __m256i stride    = _mm256_set1_epi32(srcStride);
+    const __m256i limit     = _mm256_set1_epi32(safeLimit);
+    const __m256i invalid   = _mm256_set1_epi32(-1);
+    const __m256i zero      = _mm256_setzero_si256();
+    const __m256i round     = _mm256_set1_epi16(1 << (2 * RemapKernel::kFractionBits - 1));
+    const int *base         = reinterpret_cast<const int *>(src);
+    int x = 0;
+    for (; x + 8 + SpillPixels(Pixel::kBytes) <= count; x += 8, dst += 8 * Pixel::kBytes)
+    {
+        const __m256i o00 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(entries + x));
+        const __m256i f   = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(fractions + x)));
+        const __m256i fx  = _mm256_srli_epi32(f, RemapKernel::kFractionBits);
+        const __m256i fy  = _mm256_and_si256(f, mask);
+        const __m256i o10 = _mm256_add_epi32(o00, _mm256_and_si256(_mm256_cmpgt_epi32(fx, zero), dx));
+        const __m256i dy  = _mm256_and_si256(_mm256_cmpgt_epi32(fy, zero), stride);
+        const __m256i o01 = _mm256_add_epi32(o00, dy);
+        const __m256i o11 = _mm256_add_epi32(o10, dy);
+        const __m256i bad = _mm256_or_si256(_mm256_cmpeq_epi32(o00, invalid), _mm256_cmpgt_epi32(o11, limit));
+        if (!_mm256_testz_si256(bad, bad))
+        {
+            RemapKernel::BilinearRowScalar<Pixel>(dst, src, entries + x, fractions + x, 8, srcStride, safeLimit, fill);
+            continue;
+        }
+        const __m256i ifx = _mm256_sub_epi32(one, fx);
+        const __m256i ify = _mm256_sub_epi32(one, fy);
+        __m256i lo = round;
+        __m256i hi = round;
+        Accumulate(&lo, &hi, _mm256_i32gather_epi32(base, o00, 1), _mm256_mullo_epi32(ifx, ify));
+        Accumulate(&lo, &hi, _mm256_i32gather_epi32(base, o10, 1), _mm256_mullo_epi32(fx, ify));
+        Accumulate(&lo, &hi, _mm256_i32gather_epi32(base, o01, 1), _mm256_mullo_epi32(ifx, fy));
+        Accumulate(&lo, &hi, _mm256_i32gather_epi32(base, o11, 1), _mm256_mullo_epi32(fx, fy));
+        lo = _mm256_srli_epi16(lo, 2 * RemapKernel::kFractionBits);
+        hi = _mm256_srli_epi16(hi, 2 * RemapKernel::kFractionBits);
+        const __m256i packed = _mm256_shuffle_epi8(_mm256_packus_epi16(lo, hi), shuffle);
+        Store4<Pixel::kBytes>(dst, _mm256_castsi256_si128(packed));
+        Store4<Pixel::kBytes>(dst + 4 * Pixel::kBytes, _mm256_extracti128_si256(packed, 1));
+    }
+    RemapKernel::BilinearRowScalar<Pixel>(dst, src, entries + x, fractions + x, count - x, srcStride, safeLimit,
+                                          fill);
+}
+#endif // REMAP_KERNEL_AVX2
+
+#ifdef Q_CC_MSVC
+static bool CpuHasAVX2()
+{
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx     = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    // the OS must save the YMM registers.
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+static bool CpuHasSSE41()
+{
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+}
+#else
+static bool CpuHasAVX2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static bool CpuHasSSE41()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+}
+#endif
+#endif // REMAP_KERNEL_X86
+
+static RemapKernel::Isa DetectIsa()
+{
+#ifdef REMAP_KERNEL_X86
+#ifdef REMAP_KERNEL_AVX2
+    if (CpuHasAVX2()) return RemapKernel::AVX2;
+#endif
+    if (CpuHasSSE41()) return RemapKernel::SSE41;
+#endif
+    return RemapKernel::Scalar;
+}
+
+static RemapKernel::Isa sSupportedIsa   = DetectIsa();
+static RemapKernel::Isa sActiveIsa      = sSupportedIsa;
+
+RemapKernel::Isa RemapKernel::SupportedIsa()
+{
+    return sSupportedIsa;
+}
+
+RemapKernel::Isa RemapKernel::ActiveIsa()
+{
+    return sActiveIsa;
+}
+
+void RemapKernel::SetIsa(Isa isa)
+{
+    sActiveIsa = (isa > sSupportedIsa) ? sSupportedIsa : isa;
+}
+
+const char *RemapKernel::IsaName(Isa isa)
+{
+    switch (isa)
+    {
+    case AVX2:  return "avx2";
+    case SSE41: return "sse4.1";
+    default:    return "scalar";
+    }
+}
+
+/**
+ * the bilinear kernels of a pixel type, the SIMD blend keeps 8-bit samples
+ * in 16-bit lanes, so the wider samples only get the scalar kernel.
+ **/
+template <class Pixel, bool EightBit = (sizeof(typename Pixel::Sample) == 1)>
+struct BilinearKernels
+{
+    static RemapKernel::BilinearRowFunc Select(RemapKernel::Isa isa)
+    {
+        switch (isa)
+        {
+#ifdef REMAP_KERNEL_X86
+#ifdef REMAP_KERNEL_AVX2
+        case RemapKernel::AVX2:  return BilinearRowAVX2<Pixel>;
+#endif
+        case RemapKernel::SSE41: return BilinearRowSSE41<Pixel>;
+#endif
+        default:                 return RemapKernel::BilinearRowScalar<Pixel>;
+        }
+    }
+};
+
+template <class Pixel>
+struct BilinearKernels<Pixel, false>
+{
+    static RemapKernel::BilinearRowFunc Select(RemapKernel::Isa isa)
+    {
+        Q_UNUSED(isa);
+        return RemapKernel::BilinearRowScalar<Pixel>;
+    }
+};
+
+template <class Pixel>
+RemapKernel::BilinearRowFunc RemapKernel::BilinearRow(Isa isa)
+{
+    if (isa > sSupportedIsa) isa = sSupportedIsa;
+    return BilinearKernels<Pixel>::Select(isa);
+}
+
+RemapKernel::SpanRowFunc RemapKernel::SpanRow()
+{
+    return SpanRow(sActiveIsa);
+}
+
+RemapKernel::SpanRowFunc RemapKernel::SpanRow(Isa isa)
+{
+    if (isa > sSupportedIsa) isa = sSupportedIsa;
+    switch (isa)
+    {
+#ifdef REMAP_KERNEL_X86
+    case AVX2:
+    case SSE41: return SpanRowSSE41;
+#endif
+    default:    return SpanRowScalar;
+    }
+}
+
+RemapKernel::ReflectFunc RemapKernel::Reflect()
+{
+    return Reflect(sActiveIsa);
+}
+
+RemapKernel::ReflectFunc RemapKernel::Reflect(Isa isa)
+{
+    if (isa > sSupportedIsa) isa = sSupportedIsa;
+    switch (isa)
+    {
+#ifdef REMAP_KERNEL_X86
+    case AVX2:
+    case SSE41: return ReflectSSE41;
+#endif
+    default:    return ReflectScalar;
+    }
+}
+
+template <class Pixel>
+RemapKernel::RowFunc RemapKernel::Row(Isa isa)
+{
+    if (isa > sSupportedIsa) isa = sSupportedIsa;
+    switch (isa)
+    {
+#ifdef REMAP_KERNEL_X86
+#ifdef REMAP_KERNEL_AVX2
+    case AVX2:  return RowAVX2<Pixel>;
+#endif
+    case SSE41: return RowSSE41<Pixel>;
+#endif
+    default:    return RowScalar<Pixel>;
+    }
+}
+
+// the kernels of every RemapPixel type, generated here once.
+#define REMAP_KERNEL_INSTANTIATE(Pixel) \
+    template RemapKernel::RowFunc RemapKernel::Row<Pixel>(RemapKernel::Isa); \
+    template RemapKernel::BilinearRowFunc RemapKernel::BilinearRow<Pixel>(RemapKernel::Isa); \
+    template void RemapKernel::RowScalar<Pixel>(uchar *, const uchar *, const qint32 *, int, qint32, uchar); \
+    template void RemapKernel::BilinearRowScalar<Pixel>(uchar *, const uchar *, const qint32 *, const quint8 *, \
+                                                        int, int, qint32, uchar);
+
+REMAP_KERNEL_INSTANTIATE(RemapGray8)
+REMAP_KERNEL_INSTANTIATE(RemapUv88)
+REMAP_KERNEL_INSTANTIATE(RemapRgb888)
+REMAP_KERNEL_INSTANTIATE(RemapRgba32)
+REMAP_KERNEL_INSTANTIATE(RemapMono16)
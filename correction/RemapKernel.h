@@ -0,0 +1,147 @@
+#ifndef RemapKernel_H
+#define RemapKernel_H
+
+#include <QtGlobal>
+
+/**
+ * RemapSpan : a run of output pixels in one row which read one source row.
+ * the horizontal stages stretch the source rows, so every output pixel
+ * copies the same source pixel as its left neighbour or the next one.
+ * the bit i of advance (i < kSpanAdvanceBits) moves the pixel i one source
+ * pixel right of the pixel i - 1. a run without advance is a plain splat.
+ **/
+typedef struct RemapSpan
+{
+    qint32  source;     // source byte offset of the first pixel, or RemapTable::kInvalidEntry.
+    quint32 advance;
+    quint16 start;      // the first output pixel of the run in the row.
+    quint16 length;
+} RemapSpan_t;
+
+/**
+ * RemapReflection : the reflection of the points of a RemapSymmetricTable.
+ * the point (x, y) reads the source pixel (baseX + signX * x, baseY + signY * y),
+ * the signs are 1 or -1.
+ **/
+typedef struct RemapReflection
+{
+    int baseX;
+    int signX;
+    int baseY;
+    int signY;
+    int srcWidth;
+    int srcHeight;
+    int srcStride;
+} RemapReflection_t;
+
+/**
+ * RemapPixel : the pixel types of the row kernels, the sample type and the
+ * number of channels of one pixel. the kernels are generated for every
+ * type at compile time, RemapTable picks the ones of its QImage format
+ * once per frame.
+ **/
+template <typename SampleType, int Channels>
+struct RemapPixel
+{
+    typedef SampleType Sample;
+    static const int kChannels  = Channels;
+    static const int kBytes     = Channels * static_cast<int>(sizeof(SampleType));
+};
+
+typedef RemapPixel<quint8, 1>   RemapGray8;     // Format_Grayscale8, the NV12 luma.
+typedef RemapPixel<quint8, 2>   RemapUv88;      // the interleaved NV12 chroma.
+typedef RemapPixel<quint8, 3>   RemapRgb888;    // Format_RGB888.
+typedef RemapPixel<quint8, 4>   RemapRgba32;    // Format_RGBA8888, RGBX8888, RGB32 and ARGB32.
+typedef RemapPixel<quint16, 1>  RemapMono16;    // Format_Grayscale16, the raw sensor dumps.
+
+/**
+ * RemapKernel : the per-row gather kernels of RemapTable.
+ * the AVX2 (gather) and SSE4.1 (shuffle) kernels produce exactly the same
+ * bytes as the scalar one, the best one is picked at startup by CPUID.
+ * Row() and BilinearRow() are instantiated for the RemapPixel types above,
+ * the bilinear SIMD kernels only blend 8-bit samples, RemapMono16 blends
+ * with the scalar one. the span and reflection kernels are RGB888 only.
+ **/
+class RemapKernel
+{
+public:
+    enum Isa
+    {
+        Scalar  = 0,
+        SSE41   = 1,
+        AVX2    = 2
+    };
+
+    /*
+     * RowFunc : remap count pixels into dst.
+     * entries are source byte offsets (or RemapTable::kInvalidEntry),
+     * safeLimit is the last offset where a 4-byte load stays inside src.
+     * every byte of a pixel without source is fill (0, black, for RGB).
+     **/
+    typedef void (*RowFunc)(uchar *dst, const uchar *src, const qint32 *entries, int count, qint32 safeLimit,
+                            uchar fill);
+
+    /*
+     * BilinearRowFunc : the fixed-point bilinear version of RowFunc.
+     * every entry is the top-left source pixel, fractions holds the 4-bit
+     * sub-pixel weights as (fx << 4) | fy. a zero fraction never reads the
+     * right (or lower) neighbour, so the border pixels stay inside src.
+     **/
+    typedef void (*BilinearRowFunc)(uchar *dst, const uchar *src, const qint32 *entries, const quint8 *fractions,
+                                    int count, int srcStride, qint32 safeLimit, uchar fill);
+
+    /*
+     * SpanRowFunc : fill one output row from its count spans.
+     * dst is the start of the row, every run is splatted with wide stores.
+     **/
+    typedef void (*SpanRowFunc)(uchar *dst, const uchar *src, const RemapSpan_t *spans, int count, qint32 safeLimit);
+
+    /*
+     * ReflectFunc : the entries of count points, (srcY << 16) | srcX each.
+     * with reverse the points are read backward from points[0], for the
+     * mirrored half of a row. the points which leave the source (the invalid
+     * point 0xffffffff too) give RemapTable::kInvalidEntry.
+     **/
+    typedef void (*ReflectFunc)(qint32 *entries, const quint32 *points, int count, bool reverse,
+                                const RemapReflection_t &reflection);
+
+    static const int kSpanAdvanceBits = 32;
+
+    static const int kFractionBits  = 4;
+    static const int kFractionOne   = 1 << kFractionBits;
+
+    static Isa          SupportedIsa();
+    static Isa          ActiveIsa();
+    // select a kernel by hand (benchmarks and comparisons), clamped to SupportedIsa().
+    static void         SetIsa(Isa isa);
+    static const char  *IsaName(Isa isa);
+
+    template <class Pixel>
+    static RowFunc      Row()           { return Row<Pixel>(ActiveIsa()); }
+    template <class Pixel>
+    static RowFunc      Row(Isa isa);
+
+    template <class Pixel>
+    static BilinearRowFunc BilinearRow() { return BilinearRow<Pixel>(ActiveIsa()); }
+    template <class Pixel>
+    static BilinearRowFunc BilinearRow(Isa isa);
+
+    static SpanRowFunc  SpanRow();
+    static SpanRowFunc  SpanRow(Isa isa);
+
+    static ReflectFunc  Reflect();
+    static ReflectFunc  Reflect(Isa isa);
+
+    template <class Pixel>
+    static void         RowScalar(uchar *dst, const uchar *src, const qint32 *entries, int count, qint32 safeLimit,
+                                  uchar fill);
+    template <class Pixel>
+    static void         BilinearRowScalar(uchar *dst, const uchar *src, const qint32 *entries, const quint8 *fractions,
+                                          int count, int srcStride, qint32 safeLimit, uchar fill);
+    static void         SpanRowScalar(uchar *dst, const uchar *src, const RemapSpan_t *spans, int count,
+                                      qint32 safeLimit);
+    static void         ReflectScalar(qint32 *entries, const quint32 *points, int count, bool reverse,
+                                      const RemapReflection_t &reflection);
+};
+
+#endif // RemapKernel_H
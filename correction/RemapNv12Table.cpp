@@ -0,0 +1,253 @@
+#include "RemapNv12Table.h"
+#include "RemapKernel.h"
+#include "WorkerPool.h"
+
+#include <QDebug>
+#include <qmath.h>
+#include <string.h>
+
+const qint32 RemapNv12Table::kInvalidEntry;
+const int RemapNv12Table::kBandHeight;
+
+class RemapNv12Job : public WorkerPool::Job
+{
+public:
+    RemapNv12Job(const RemapNv12Table *table, const Nv12Frame *input, uchar *dstY, uchar *dstUv)
+        : mTable(table),
+          mSrcY(input->YPlane()),
+          mSrcUv(input->UvPlane()),
+          mDstY(dstY),
+          mDstUv(dstUv)
+    {
+    }
+
+    void Run(int index)
+    {
+        mTable->ApplyBand(mSrcY, mSrcUv, mDstY, mDstUv, index);
+    }
+
+private:
+    const RemapNv12Table   *mTable;
+    const uchar            *mSrcY;
+    const uchar            *mSrcUv;
+    uchar                  *mDstY;
+    uchar                  *mDstUv;
+};
+
+RemapNv12Table::RemapNv12Table()
+{
+    Clear();
+}
+
+void RemapNv12Table::Clear()
+{
+    mSrcWidth       = 0;
+    mSrcHeight      = 0;
+    mDstWidth       = 0;
+    mDstHeight      = 0;
+    mChromaWidth    = 0;
+    mChromaHeight   = 0;
+    mMode           = RemapTable::NearestNeighbour;
+    mLuma.clear();
+    mLumaFractions.clear();
+    mChroma.clear();
+    mChromaFractions.clear();
+}
+
+bool RemapNv12Table::IsNull() const
+{
+    return mLuma.isEmpty();
+}
+
+int RemapNv12Table::ByteSize() const
+{
+    return static_cast<int>((mLuma.size() + mChroma.size()) * sizeof(qint32)
+                            + mLumaFractions.size() + mChromaFractions.size());
+}
+
+bool RemapNv12Table::Build(const RemapTable &table)
+{
+    Clear();
+    if (table.IsNull())
+    {
+        return false;
+    }
+
+    mSrcWidth       = table.SourceWidth();
+    mSrcHeight      = table.SourceHeight();
+    mDstWidth       = table.Width();
+    mDstHeight      = table.Height();
+    mChromaWidth    = (mDstWidth + 1) / 2;
+    mChromaHeight   = (mDstHeight + 1) / 2;
+    mMode           = table.Mode();
+
+    const bool bilinear     = (mMode == RemapTable::Bilinear);
+    const int srcStride     = table.SourceStride();
+    const int pixelBytes    = table.PixelBytes();
+    const int srcChromaW    = (mSrcWidth + 1) / 2;
+    const int srcChromaH    = (mSrcHeight + 1) / 2;
+    const int srcUvStride   = srcChromaW * 2;
+    const qint32 *entries   = table.Entries();
+    const quint8 *fractions = table.Fractions();
+
+    // the luma entries, the same pixels with the Y plane stride.
+    const int count = mDstWidth * mDstHeight;
+    mLuma.resize(count);
+    for (int n = 0; n < count; ++n)
+    {
+        const qint32 entry = entries[n];
+        mLuma[n] = (entry < 0) ? kInvalidEntry : (entry / srcStride) * mSrcWidth + (entry % srcStride) / pixelBytes;
+    }
+    if (bilinear)
+    {
+        mLumaFractions = QVector<quint8>(count);
+        memcpy(mLumaFractions.data(), fractions, count);
+    }
+
+    // the chroma entries, the source chroma sample i is centered on the luma 2 * i + 0.5.
+    mChroma.resize(mChromaWidth * mChromaHeight);
+    if (bilinear)
+    {
+        mChromaFractions = QVector<quint8>(mChroma.size(), 0);
+    }
+    const qreal one = RemapKernel::kFractionOne;
+    for (int cy = 0; cy < mChromaHeight; ++cy)
+    {
+        for (int cx = 0; cx < mChromaWidth; ++cx)
+        {
+            qreal sumX  = 0;
+            qreal sumY  = 0;
+            int valid   = 0;
+            for (int y = 2 * cy; y < qMin(2 * cy + 2, mDstHeight); ++y)
+            {
+                for (int x = 2 * cx; x < qMin(2 * cx + 2, mDstWidth); ++x)
+                {
+                    const int index     = y * mDstWidth + x;
+                    const qint32 entry  = entries[index];
+                    if (entry < 0)
+                    {
+                        continue;
+                    }
+                    sumX += (entry % srcStride) / pixelBytes + (bilinear ? (fractions[index] >> 4) / one : 0);
+                    sumY += entry / srcStride + (bilinear ? (fractions[index] & 0xf) / one : 0);
+                    valid++;
+                }
+            }
+
+            const int index = cy * mChromaWidth + cx;
+            if (valid == 0)
+            {
+                mChroma[index] = kInvalidEntry;
+                continue;
+            }
+            const qreal srcX = qBound(qreal(0), (sumX / valid - 0.5) / 2, qreal(srcChromaW - 1));
+            const qreal srcY = qBound(qreal(0), (sumY / valid - 0.5) / 2, qreal(srcChromaH - 1));
+            if (!bilinear)
+            {
+                mChroma[index] = qRound(srcY) * srcUvStride + qRound(srcX) * 2;
+                continue;
+            }
+
+            // the fractions as RemapTable::SetSubPixelEntry(), no neighbour past the last sample.
+            int x0 = qFloor(srcX);
+            int y0 = qFloor(srcY);
+            int fx = qRound((srcX - x0) * one);
+            int fy = qRound((srcY - y0) * one);
+            if (fx == RemapKernel::kFractionOne)
+            {
+                x0 += 1;
+                fx  = 0;
+            }
+            if (fy == RemapKernel::kFractionOne)
+            {
+                y0 += 1;
+                fy  = 0;
+            }
+            if (x0 >= srcChromaW - 1)
+            {
+                x0 = srcChromaW - 1;
+                fx = 0;
+            }
+            if (y0 >= srcChromaH - 1)
+            {
+                y0 = srcChromaH - 1;
+                fy = 0;
+            }
+            mChroma[index]          = y0 * srcUvStride + x0 * 2;
+            mChromaFractions[index] = static_cast<quint8>((fx << RemapKernel::kFractionBits) | fy);
+        }
+    }
+
+    qDebug("nv12 table: %dx%d -> %dx%d, %d bytes", mSrcWidth, mSrcHeight, mDstWidth, mDstHeight, ByteSize());
+    return true;
+}
+
+bool RemapNv12Table::Apply(const Nv12Frame *input, Nv12Frame *output) const
+{
+    if (IsNull() || input->Width() != mSrcWidth || input->Height() != mSrcHeight)
+    {
+        qDebug("nv12 table mismatch: table source %dx%d, frame %dx%d",
+               mSrcWidth, mSrcHeight, input->Width(), input->Height());
+        return false;
+    }
+    if (output->Width() != mDstWidth || output->Height() != mDstHeight)
+    {
+        *output = Nv12Frame(mDstWidth, mDstHeight);
+    }
+
+    // detach the output planes here, the bands only write to the raw bytes.
+    RemapNv12Job job(this, input, output->YPlane(), output->UvPlane());
+    WorkerPool::getInstance()->Run(&job, BandCount());
+    return true;
+}
+
+int RemapNv12Table::BandCount() const
+{
+    return (mDstHeight + kBandHeight - 1) / kBandHeight;
+}
+
+void RemapNv12Table::ApplyBand(const uchar *srcY, const uchar *srcUv, uchar *dstY, uchar *dstUv, int band) const
+{
+    // the planes are packed as Nv12Frame.
+    const int y0            = band * kBandHeight;
+    const int y1            = qMin(y0 + kBandHeight, mDstHeight);
+    const int srcUvStride   = ((mSrcWidth + 1) / 2) * 2;
+    const int dstUvStride   = mChromaWidth * 2;
+    const qint32 lumaLimit      = mSrcWidth * mSrcHeight - 4;
+    const qint32 chromaLimit    = srcUvStride * ((mSrcHeight + 1) / 2) - 4;
+    const RemapKernel::Isa lumaIsa      = (lumaLimit < 0) ? RemapKernel::Scalar : RemapKernel::ActiveIsa();
+    const RemapKernel::Isa chromaIsa    = (chromaLimit < 0) ? RemapKernel::Scalar : RemapKernel::ActiveIsa();
+
+    if (mMode == RemapTable::Bilinear)
+    {
+        const RemapKernel::BilinearRowFunc luma     = RemapKernel::BilinearRow<RemapGray8>(lumaIsa);
+        const RemapKernel::BilinearRowFunc chroma   = RemapKernel::BilinearRow<RemapUv88>(chromaIsa);
+        for (int y = y0; y < y1; ++y)
+        {
+            const int index = y * mDstWidth;
+            luma(dstY + index, srcY, mLuma.constData() + index, mLumaFractions.constData() + index,
+                 mDstWidth, mSrcWidth, lumaLimit, Nv12Frame::kBlackLuma);
+        }
+        for (int cy = y0 / 2; cy < (y1 + 1) / 2; ++cy)
+        {
+            const int index = cy * mChromaWidth;
+            chroma(dstUv + cy * dstUvStride, srcUv, mChroma.constData() + index, mChromaFractions.constData() + index,
+                   mChromaWidth, srcUvStride, chromaLimit, Nv12Frame::kNeutralChroma);
+        }
+        return;
+    }
+
+    const RemapKernel::RowFunc luma     = RemapKernel::Row<RemapGray8>(lumaIsa);
+    const RemapKernel::RowFunc chroma   = RemapKernel::Row<RemapUv88>(chromaIsa);
+    for (int y = y0; y < y1; ++y)
+    {
+        const int index = y * mDstWidth;
+        luma(dstY + index, srcY, mLuma.constData() + index, mDstWidth, lumaLimit, Nv12Frame::kBlackLuma);
+    }
+    for (int cy = y0 / 2; cy < (y1 + 1) / 2; ++cy)
+    {
+        const int index = cy * mChromaWidth;
+        chroma(dstUv + cy * dstUvStride, srcUv, mChroma.constData() + index, mChromaWidth, chromaLimit,
+               Nv12Frame::kNeutralChroma);
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef RemapNv12Table_H
+#define RemapNv12Table_H
+
+#include <QVector>
+#include "Nv12Frame.h"
+#include "RemapTable.h"
+
+/**
+ * RemapNv12Table : a RemapTable for Nv12Frame sources, the frames are
+ * remapped plane by plane without any RGB conversion.
+ * the luma entries are the RemapTable entries as offsets into the Y plane.
+ * the chroma entries are one per output chroma sample, from the mean
+ * source position of its 2x2 output pixels, as offsets of the U byte in
+ * the UV plane. a frame moves 1.5 bytes per pixel instead of 3.
+ * the Bilinear tables blend the chroma from the 2x2 chroma neighbourhood
+ * with the same 4-bit fractions.
+ **/
+class RemapNv12Table
+{
+public:
+    static const qint32 kInvalidEntry = -1;
+    // Apply() splits the output into bands of this many luma rows (even) for the WorkerPool.
+    static const int    kBandHeight   = 16;
+
+    RemapNv12Table();
+
+    /*
+     * Build() : the planar form of table, false for a NULL table.
+     **/
+    bool    Build(const RemapTable &table);
+    void    Clear();
+    bool    IsNull() const;
+
+    int     SourceWidth() const     { return mSrcWidth; }
+    int     SourceHeight() const    { return mSrcHeight; }
+    int     Width() const           { return mDstWidth; }
+    int     Height() const          { return mDstHeight; }
+    RemapTable::Interpolation Mode() const { return mMode; }
+    int     ByteSize() const;
+
+    /*
+     * Apply() : remap the input frame into output, the output is
+     * (re)allocated as Width() x Height(). the pixels without a source
+     * are black. the bands are remapped on the shared WorkerPool.
+     **/
+    bool    Apply(const Nv12Frame *input, Nv12Frame *output) const;
+
+private:
+    friend class RemapNv12Job;
+
+    void    ApplyBand(const uchar *srcY, const uchar *srcUv, uchar *dstY, uchar *dstUv, int band) const;
+    int     BandCount() const;
+
+    int             mSrcWidth;
+    int             mSrcHeight;
+    int             mDstWidth;
+    int             mDstHeight;
+    int             mChromaWidth;
+    int             mChromaHeight;
+    RemapTable::Interpolation mMode;
+    QVector<qint32> mLuma;
+    QVector<quint8> mLumaFractions;
+    QVector<qint32> mChroma;
+    QVector<quint8> mChromaFractions;
+};
+
+#endif // RemapNv12Table_H
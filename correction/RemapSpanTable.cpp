@@ -0,0 +1,167 @@
+#include "RemapSpanTable.h"
+#include "WorkerPool.h"
+
+#include <QDebug>
+
+class RemapSpanJob : public WorkerPool::Job
+{
+public:
+    RemapSpanJob(const RemapSpanTable *table, const uchar *src, uchar *dst, int dstStride, qint32 safeLimit)
+        : mTable(table),
+          mSrc(src),
+          mDst(dst),
+          mDstStride(dstStride),
+          mSafeLimit(safeLimit)
+    {
+    }
+
+    void Run(int index)
+    {
+        mTable->ApplyRows(mSrc, mDst, mDstStride, mSafeLimit, index);
+    }
+
+private:
+    const RemapSpanTable   *mTable;
+    const uchar            *mSrc;
+    uchar                  *mDst;
+    int                     mDstStride;
+    qint32                  mSafeLimit;
+};
+
+RemapSpanTable::RemapSpanTable()
+    : mSrcWidth(0),
+      mSrcHeight(0),
+      mSrcStride(0),
+      mDstWidth(0),
+      mDstHeight(0)
+{
+}
+
+bool RemapSpanTable::Build(const RemapTable &table)
+{
+    Clear();
+    // RemapSpan_t keeps the start and the length in 16 bits.
+    if (table.IsNull() || table.Mode() != RemapTable::NearestNeighbour || table.Format() != QImage::Format_RGB888
+            || table.Width() > 0xffff)
+    {
+        return false;
+    }
+
+    mSrcWidth   = table.SourceWidth();
+    mSrcHeight  = table.SourceHeight();
+    mSrcStride  = table.SourceStride();
+    mDstWidth   = table.Width();
+    mDstHeight  = table.Height();
+    mRows.resize(mDstHeight + 1);
+
+    const qint32 *entries = table.Entries();
+    for (int y = 0; y < mDstHeight; ++y, entries += mDstWidth)
+    {
+        mRows[y] = mSpans.size();
+        int start = 0;
+        while (start < mDstWidth)
+        {
+            RemapSpan_t span;
+            span.source     = entries[start];
+            span.advance    = 0;
+            span.start      = static_cast<quint16>(start);
+
+            int end = start + 1;
+            for (; end < mDstWidth && end - start < 0xffff; ++end)
+            {
+                const qint32 previous   = entries[end - 1];
+                const qint32 current    = entries[end];
+                if (current == previous)
+                {
+                    continue;
+                }
+                // one source pixel right, in the same source row.
+                if (previous >= 0 && current == previous + 3
+                        && (previous % mSrcStride) / 3 < mSrcWidth - 1
+                        && end - start < RemapKernel::kSpanAdvanceBits)
+                {
+                    span.advance |= 1u << (end - start);
+                    continue;
+                }
+                break;
+            }
+            span.length = static_cast<quint16>(end - start);
+            mSpans.append(span);
+            start = end;
+        }
+    }
+    mRows[mDstHeight] = mSpans.size();
+
+    qDebug("span table: %d spans for %dx%d pixels, %d bytes (table %d bytes)",
+           mSpans.size(), mDstWidth, mDstHeight, ByteSize(),
+           static_cast<int>(mDstWidth * mDstHeight * sizeof(qint32)));
+    return true;
+}
+
+void RemapSpanTable::Clear()
+{
+    mSrcWidth   = 0;
+    mSrcHeight  = 0;
+    mSrcStride  = 0;
+    mDstWidth   = 0;
+    mDstHeight  = 0;
+    mSpans.clear();
+    mRows.clear();
+}
+
+bool RemapSpanTable::IsNull() const
+{
+    return mRows.isEmpty();
+}
+
+int RemapSpanTable::ByteSize() const
+{
+    return static_cast<int>(mSpans.size() * sizeof(RemapSpan_t) + mRows.size() * sizeof(int));
+}
+
+bool RemapSpanTable::Apply(const QImage *input, QImage *output) const
+{
+    if (IsNull() || input->width() != mSrcWidth || input->height() != mSrcHeight)
+    {
+        qDebug("span table mismatch: table source %dx%d, image %dx%d",
+               mSrcWidth, mSrcHeight, input->width(), input->height());
+        return false;
+    }
+
+    QImage converted;
+    const QImage *source = input;
+    if (input->format() != QImage::Format_RGB888)
+    {
+        converted   = input->convertToFormat(QImage::Format_RGB888);
+        source      = &converted;
+    }
+    if (source->bytesPerLine() != mSrcStride)
+    {
+        converted   = source->copy();
+        source      = &converted;
+    }
+
+    if (output->width() != mDstWidth || output->height() != mDstHeight
+            || output->format() != QImage::Format_RGB888)
+    {
+        *output = QImage(mDstWidth, mDstHeight, QImage::Format_RGB888);
+    }
+
+    uchar *dst                  = output->bits();
+    const qint32 safeLimit      = mSrcStride * mSrcHeight - 4;
+    const int bands             = (mDstHeight + RemapTable::kTileHeight - 1) / RemapTable::kTileHeight;
+    RemapSpanJob job(this, source->constBits(), dst, output->bytesPerLine(), safeLimit);
+    WorkerPool::getInstance()->Run(&job, bands);
+    return true;
+}
+
+void RemapSpanTable::ApplyRows(const uchar *src, uchar *dst, int dstStride, qint32 safeLimit, int band) const
+{
+    const RemapKernel::SpanRowFunc row = (safeLimit < 0) ? RemapKernel::SpanRowScalar : RemapKernel::SpanRow();
+    const int y0 = band * RemapTable::kTileHeight;
+    const int y1 = qMin(y0 + RemapTable::kTileHeight, mDstHeight);
+    for (int y = y0; y < y1; ++y)
+    {
+        row(dst + y * dstStride, src, mSpans.constData() + mRows[y], mRows[y + 1] - mRows[y], safeLimit);
+    }
+}
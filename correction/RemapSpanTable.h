@@ -0,0 +1,59 @@
+#ifndef RemapSpanTable_H
+#define RemapSpanTable_H
+
+#include <QImage>
+#include <QVector>
+#include "RemapKernel.h"
+#include "RemapTable.h"
+
+/**
+ * RemapSpanTable : the run length form of a RemapTable.
+ * the horizontal stages fill runs of output pixels from one source pixel,
+ * column after column of the same source row. so every row is stored as
+ * RemapSpan_t runs (12 bytes for about a dozen pixels instead of 4 bytes
+ * per pixel), the plain runs are splatted with wide stores and the others
+ * read the source row in order instead of gathering it pixel by pixel.
+ * only the NearestNeighbour RGB888 tables can be compressed.
+ **/
+class RemapSpanTable
+{
+public:
+    RemapSpanTable();
+
+    /*
+     * Build() : compress the table, return false for a Bilinear table,
+     * a table which is not RGB888 or wider than 65535 pixels.
+     **/
+    bool    Build(const RemapTable &table);
+    void    Clear();
+    bool    IsNull() const;
+
+    int     SourceWidth() const     { return mSrcWidth; }
+    int     SourceHeight() const    { return mSrcHeight; }
+    int     Width() const           { return mDstWidth; }
+    int     Height() const          { return mDstHeight; }
+    int     SpanCount() const       { return mSpans.size(); }
+    // the bytes of the spans and the row index.
+    int     ByteSize() const;
+
+    /*
+     * Apply() : the same output as RemapTable::Apply() of the source table.
+     **/
+    bool    Apply(const QImage *input, QImage *output) const;
+
+private:
+    friend class RemapSpanJob;
+
+    void    ApplyRows(const uchar *src, uchar *dst, int dstStride, qint32 safeLimit, int band) const;
+
+    int                     mSrcWidth;
+    int                     mSrcHeight;
+    int                     mSrcStride;
+    int                     mDstWidth;
+    int                     mDstHeight;
+    QVector<RemapSpan_t>    mSpans;
+    // the spans of the row y are [mRows[y], mRows[y + 1]).
+    QVector<int>            mRows;
+};
+
+#endif // RemapSpanTable_H
@@ -0,0 +1,313 @@
+#include "RemapSymmetricTable.h"
+#include "RemapKernel.h"
+#include "WorkerPool.h"
+
+#include <QDebug>
+#include <QHash>
+
+const quint32 RemapSymmetricTable::kInvalidPoint;
+
+class RemapSymmetricJob : public WorkerPool::Job
+{
+public:
+    RemapSymmetricJob(const RemapSymmetricTable *table, const uchar *src, uchar *dst, int dstStride, qint32 safeLimit)
+        : mTable(table),
+          mSrc(src),
+          mDst(dst),
+          mDstStride(dstStride),
+          mSafeLimit(safeLimit)
+    {
+    }
+
+    void Run(int index)
+    {
+        mTable->ApplyRows(mSrc, mDst, mDstStride, mSafeLimit, index);
+    }
+
+private:
+    const RemapSymmetricTable  *mTable;
+    const uchar                *mSrc;
+    uchar                      *mDst;
+    int                         mDstStride;
+    qint32                      mSafeLimit;
+};
+
+/**
+ * the most common sum of the source coordinates of the mirrored output pixels,
+ * along x (mirrorX) or y. -1 when no mirrored pair reads the same source line.
+ **/
+static int MostCommonSum(const QVector<quint32> &points, int width, int height, bool mirrorX)
+{
+    QHash<int, int> counts;
+    const int pairsX = mirrorX ? width / 2 : width;
+    const int pairsY = mirrorX ? height : height / 2;
+    for (int y = 0; y < pairsY; ++y)
+    {
+        for (int x = 0; x < pairsX; ++x)
+        {
+            const quint32 a = points[y * width + x];
+            const quint32 b = mirrorX ? points[y * width + width - 1 - x] : points[(height - 1 - y) * width + x];
+            if (a == 0xffffffff || b == 0xffffffff)
+            {
+                continue;
+            }
+            if (mirrorX && (a >> 16) == (b >> 16))
+            {
+                counts[(a & 0xffff) + (b & 0xffff)]++;
+            }
+            else if (!mirrorX && (a & 0xffff) == (b & 0xffff))
+            {
+                counts[(a >> 16) + (b >> 16)]++;
+            }
+        }
+    }
+
+    int sum     = -1;
+    int most    = 0;
+    for (QHash<int, int>::const_iterator it = counts.constBegin(); it != counts.constEnd(); ++it)
+    {
+        if (it.value() > most)
+        {
+            most    = it.value();
+            sum     = it.key();
+        }
+    }
+    return sum;
+}
+
+RemapSymmetricTable::RemapSymmetricTable()
+{
+    Clear();
+}
+
+bool RemapSymmetricTable::Build(const RemapTable &table)
+{
+    Clear();
+    // the points keep the source coordinates in 16 bits, and the sum of two of them too.
+    if (table.IsNull() || table.Mode() != RemapTable::NearestNeighbour || table.Format() != QImage::Format_RGB888
+            || table.SourceWidth() > 0x7fff || table.SourceHeight() > 0x7fff)
+    {
+        return false;
+    }
+
+    mSrcWidth   = table.SourceWidth();
+    mSrcHeight  = table.SourceHeight();
+    mSrcStride  = table.SourceStride();
+    mDstWidth   = table.Width();
+    mDstHeight  = table.Height();
+
+    const qint32 *entries = table.Entries();
+    QVector<quint32> points(mDstWidth * mDstHeight);
+    for (int n = 0; n < points.size(); ++n)
+    {
+        const qint32 entry = entries[n];
+        points[n] = (entry < 0) ? kInvalidPoint
+                                : (static_cast<quint32>(entry / mSrcStride) << 16) | ((entry % mSrcStride) / 3);
+    }
+    mSumX = MostCommonSum(points, mDstWidth, mDstHeight, true);
+    mSumY = MostCommonSum(points, mDstWidth, mDstHeight, false);
+
+    // keep the smallest form, a mirror with too many exceptions is not worth it.
+    const int limit = mDstWidth * mDstHeight / 64;
+    const bool axes[3][2] = { { true, true }, { true, false }, { false, true } };
+    int best        = -1;
+    int bestBytes   = mDstWidth * mDstHeight * static_cast<int>(sizeof(qint32));
+    for (int n = 0; n < 3; ++n)
+    {
+        if ((axes[n][0] && mSumX < 0) || (axes[n][1] && mSumY < 0))
+        {
+            continue;
+        }
+        mMirrorX    = axes[n][0];
+        mMirrorY    = axes[n][1];
+        mPartWidth  = mMirrorX ? (mDstWidth + 1) / 2 : mDstWidth;
+        mPartHeight = mMirrorY ? (mDstHeight + 1) / 2 : mDstHeight;
+        const int exceptions = CountExceptions(points, entries, limit);
+        if (exceptions > limit)
+        {
+            continue;
+        }
+        const int bytes = mPartWidth * mPartHeight * static_cast<int>(sizeof(quint32))
+                        + exceptions * static_cast<int>(sizeof(RemapException_t));
+        if (bytes < bestBytes)
+        {
+            best        = n;
+            bestBytes   = bytes;
+        }
+    }
+    if (best < 0)
+    {
+        qDebug("symmetric table: %dx%d is not mirrored", mDstWidth, mDstHeight);
+        Clear();
+        return false;
+    }
+
+    mMirrorX    = axes[best][0];
+    mMirrorY    = axes[best][1];
+    mPartWidth  = mMirrorX ? (mDstWidth + 1) / 2 : mDstWidth;
+    mPartHeight = mMirrorY ? (mDstHeight + 1) / 2 : mDstHeight;
+    mPoints.resize(mPartWidth * mPartHeight);
+    for (int y = 0; y < mPartHeight; ++y)
+    {
+        for (int x = 0; x < mPartWidth; ++x)
+        {
+            mPoints[y * mPartWidth + x] = points[y * mDstWidth + x];
+        }
+    }
+
+    mExceptionRows.resize(mDstHeight + 1);
+    QVector<qint32> reflected(mDstWidth);
+    for (int y = 0; y < mDstHeight; ++y)
+    {
+        mExceptionRows[y] = mExceptions.size();
+        ReflectRow(mPoints.constData(), mPartWidth, y, reflected.data());
+        for (int x = 0; x < mDstWidth; ++x)
+        {
+            if (reflected[x] != entries[y * mDstWidth + x])
+            {
+                RemapException_t exception;
+                exception.x     = x;
+                exception.entry = entries[y * mDstWidth + x];
+                mExceptions.append(exception);
+            }
+        }
+    }
+    mExceptionRows[mDstHeight] = mExceptions.size();
+
+    qDebug("symmetric table: mirror x %d (sum %d), mirror y %d (sum %d), %d exceptions, %d bytes (table %d bytes)",
+           mMirrorX, mSumX, mMirrorY, mSumY, mExceptions.size(), ByteSize(),
+           static_cast<int>(mDstWidth * mDstHeight * sizeof(qint32)));
+    return true;
+}
+
+int RemapSymmetricTable::CountExceptions(const QVector<quint32> &points, const qint32 *entries, int limit) const
+{
+    int count = 0;
+    QVector<qint32> reflected(mDstWidth);
+    for (int y = 0; y < mDstHeight; ++y, entries += mDstWidth)
+    {
+        ReflectRow(points.constData(), mDstWidth, y, reflected.data());
+        for (int x = 0; x < mDstWidth; ++x)
+        {
+            if (reflected[x] != entries[x] && ++count > limit)
+            {
+                return count;
+            }
+        }
+    }
+    return count;
+}
+
+void RemapSymmetricTable::Clear()
+{
+    mSrcWidth   = 0;
+    mSrcHeight  = 0;
+    mSrcStride  = 0;
+    mDstWidth   = 0;
+    mDstHeight  = 0;
+    mMirrorX    = false;
+    mMirrorY    = false;
+    mSumX       = -1;
+    mSumY       = -1;
+    mPartWidth  = 0;
+    mPartHeight = 0;
+    mPoints.clear();
+    mExceptions.clear();
+    mExceptionRows.clear();
+}
+
+bool RemapSymmetricTable::IsNull() const
+{
+    return mPoints.isEmpty();
+}
+
+int RemapSymmetricTable::ByteSize() const
+{
+    return static_cast<int>(mPoints.size() * sizeof(quint32) + mExceptions.size() * sizeof(RemapException_t)
+                            + mExceptionRows.size() * sizeof(int));
+}
+
+void RemapSymmetricTable::ReflectRow(const quint32 *points, int pointStride, int y, qint32 *entries) const
+{
+    const RemapKernel::ReflectFunc reflect = RemapKernel::Reflect();
+    const bool flipY = (y >= mPartHeight);
+    RemapReflection_t reflection;
+    reflection.baseX        = 0;
+    reflection.signX        = 1;
+    reflection.baseY        = flipY ? mSumY : 0;
+    reflection.signY        = flipY ? -1 : 1;
+    reflection.srcWidth     = mSrcWidth;
+    reflection.srcHeight    = mSrcHeight;
+    reflection.srcStride    = mSrcStride;
+    points += (flipY ? mDstHeight - 1 - y : y) * pointStride;
+    reflect(entries, points, mPartWidth, false, reflection);
+
+    // the right half reads the left half backward, there is none without the x mirror.
+    if (mPartWidth < mDstWidth)
+    {
+        reflection.baseX    = mSumX;
+        reflection.signX    = -1;
+        reflect(entries + mPartWidth, points + mDstWidth - 1 - mPartWidth, mDstWidth - mPartWidth, true, reflection);
+    }
+}
+
+bool RemapSymmetricTable::Apply(const QImage *input, QImage *output) const
+{
+    if (IsNull() || input->width() != mSrcWidth || input->height() != mSrcHeight)
+    {
+        qDebug("symmetric table mismatch: table source %dx%d, image %dx%d",
+               mSrcWidth, mSrcHeight, input->width(), input->height());
+        return false;
+    }
+
+    QImage converted;
+    const QImage *source = input;
+    if (input->format() != QImage::Format_RGB888)
+    {
+        converted   = input->convertToFormat(QImage::Format_RGB888);
+        source      = &converted;
+    }
+    if (source->bytesPerLine() != mSrcStride)
+    {
+        converted   = source->copy();
+        source      = &converted;
+    }
+
+    if (output->width() != mDstWidth || output->height() != mDstHeight
+            || output->format() != QImage::Format_RGB888)
+    {
+        *output = QImage(mDstWidth, mDstHeight, QImage::Format_RGB888);
+    }
+
+    uchar *dst                  = output->bits();
+    const qint32 safeLimit      = mSrcStride * mSrcHeight - 4;
+    const int bands             = (mDstHeight + RemapTable::kTileHeight - 1) / RemapTable::kTileHeight;
+    RemapSymmetricJob job(this, source->constBits(), dst, output->bytesPerLine(), safeLimit);
+    WorkerPool::getInstance()->Run(&job, bands);
+    return true;
+}
+
+void RemapSymmetricTable::ApplyRows(const uchar *src, uchar *dst, int dstStride, qint32 safeLimit, int band) const
+{
+    const RemapKernel::RowFunc row = (safeLimit < 0) ? RemapKernel::RowScalar<RemapRgb888>
+                                                     : RemapKernel::Row<RemapRgb888>();
+    const int y0 = band * RemapTable::kTileHeight;
+    const int y1 = qMin(y0 + RemapTable::kTileHeight, mDstHeight);
+
+    // one reflected row of entries per thread, it stays in the L1 cache and
+    // is only allocated again for a wider table.
+    static thread_local QVector<qint32> entries;
+    if (entries.size() < mDstWidth)
+    {
+        entries.resize(mDstWidth);
+    }
+    for (int y = y0; y < y1; ++y)
+    {
+        ReflectRow(mPoints.constData(), mPartWidth, y, entries.data());
+        for (int n = mExceptionRows[y]; n < mExceptionRows[y + 1]; ++n)
+        {
+            entries[mExceptions[n].x] = mExceptions[n].entry;
+        }
+        row(dst + y * dstStride, src, entries.constData(), mDstWidth, safeLimit, 0);
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef RemapSymmetricTable_H
+#define RemapSymmetricTable_H
+
+#include <QImage>
+#include <QVector>
+#include "RemapTable.h"
+
+/**
+ * the output pixels of a symmetric table which do not match the reflection.
+ * entry is a RemapTable entry (a byte offset or kInvalidEntry).
+ **/
+typedef struct RemapException
+{
+    qint32 x;
+    qint32 entry;
+} RemapException_t;
+
+/**
+ * RemapSymmetricTable : the mirrored form of a RemapTable.
+ * with a centered optical center the correction is mirrored around the
+ * center, the output pixel (width - 1 - x, y) reads the source pixel
+ * (sumX - srcX, srcY) and (x, height - 1 - y) reads (srcX, sumY - srcY).
+ * Build() finds the axes the table is mirrored on, then only the left half,
+ * the upper half or the upper left quadrant is stored, and every row of
+ * the other parts is reflected from it when the frame is remapped.
+ * the few pixels which do not follow the reflection (the borders, the
+ * rounding of the maps) are kept as exceptions.
+ * only the NearestNeighbour RGB888 tables can be mirrored.
+ **/
+class RemapSymmetricTable
+{
+public:
+    RemapSymmetricTable();
+
+    /*
+     * Build() : mirror the table, return false when it is not symmetric
+     * on any axis, it is a Bilinear or not a RGB888 table or the source
+     * is wider or higher than 32767 pixels.
+     **/
+    bool    Build(const RemapTable &table);
+    void    Clear();
+    bool    IsNull() const;
+
+    int     SourceWidth() const     { return mSrcWidth; }
+    int     SourceHeight() const    { return mSrcHeight; }
+    int     Width() const           { return mDstWidth; }
+    int     Height() const          { return mDstHeight; }
+    bool    MirrorX() const         { return mMirrorX; }
+    bool    MirrorY() const         { return mMirrorY; }
+    int     ExceptionCount() const  { return mExceptions.size(); }
+    // the bytes of the stored part, the exceptions and their row index.
+    int     ByteSize() const;
+
+    /*
+     * Apply() : the same output as RemapTable::Apply() of the source table.
+     **/
+    bool    Apply(const QImage *input, QImage *output) const;
+
+private:
+    friend class RemapSymmetricJob;
+
+    static const quint32 kInvalidPoint = 0xffffffff;
+
+    /*
+     * ReflectRow() : the entries of the output row y, without the exceptions.
+     * points is the stored part, or the points of the whole table.
+     **/
+    void    ReflectRow(const quint32 *points, int pointStride, int y, qint32 *entries) const;
+    int     CountExceptions(const QVector<quint32> &points, const qint32 *entries, int limit) const;
+    void    ApplyRows(const uchar *src, uchar *dst, int dstStride, qint32 safeLimit, int band) const;
+
+    int                         mSrcWidth;
+    int                         mSrcHeight;
+    int                         mSrcStride;
+    int                         mDstWidth;
+    int                         mDstHeight;
+    bool                        mMirrorX;
+    bool                        mMirrorY;
+    int                         mSumX;
+    int                         mSumY;
+    // the stored part is mPartWidth x mPartHeight, (srcY << 16) | srcX per pixel.
+    int                         mPartWidth;
+    int                         mPartHeight;
+    QVector<quint32>            mPoints;
+    // the exceptions of the row y are [mExceptionRows[y], mExceptionRows[y + 1]).
+    QVector<RemapException_t>   mExceptions;
+    QVector<int>                mExceptionRows;
+};
+
+#endif // RemapSymmetricTable_H
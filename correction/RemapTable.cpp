@@ -0,0 +1,516 @@
+#include "RemapTable.h"
+#include "WorkerPool.h"
+
+#include <QDebug>
+#include <QPair>
+#include <qmath.h>
+#include <algorithm>
+#include <string.h>
+
+const qint32 RemapTable::kInvalidEntry;
+const int RemapTable::kTileWidth;
+const int RemapTable::kTileHeight;
+
+class RemapTileJob : public WorkerPool::Job
+{
+public:
+    RemapTileJob(const RemapTable *table, const uchar *src, uchar *dst, int dstStride, qint32 safeLimit,
+                 RemapKernel::RowFunc row, RemapKernel::BilinearRowFunc bilinearRow)
+        : mTable(table),
+          mSrc(src),
+          mDst(dst),
+          mDstStride(dstStride),
+          mSafeLimit(safeLimit),
+          mRow(row),
+          mBilinearRow(bilinearRow)
+    {
+    }
+
+    void Run(int index)
+    {
+        mTable->ApplyTile(mSrc, mDst, mDstStride, mSafeLimit, mRow, mBilinearRow, index);
+    }
+
+private:
+    const RemapTable               *mTable;
+    const uchar                    *mSrc;
+    uchar                          *mDst;
+    int                             mDstStride;
+    qint32                          mSafeLimit;
+    RemapKernel::RowFunc            mRow;
+    RemapKernel::BilinearRowFunc    mBilinearRow;
+};
+
+template <class Pixel>
+static void PixelKernels(RemapKernel::Isa isa, RemapKernel::RowFunc *row, RemapKernel::BilinearRowFunc *bilinearRow)
+{
+    *row            = RemapKernel::Row<Pixel>(isa);
+    *bilinearRow    = RemapKernel::BilinearRow<Pixel>(isa);
+}
+
+/**
+ * the kernels of the pixel type of format, picked once per frame.
+ **/
+static void FormatKernels(QImage::Format format, RemapKernel::Isa isa, RemapKernel::RowFunc *row,
+                          RemapKernel::BilinearRowFunc *bilinearRow)
+{
+    switch (format)
+    {
+    case QImage::Format_Grayscale8:
+        PixelKernels<RemapGray8>(isa, row, bilinearRow);
+        break;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    case QImage::Format_Grayscale16:
+        PixelKernels<RemapMono16>(isa, row, bilinearRow);
+        break;
+#endif
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+        PixelKernels<RemapRgba32>(isa, row, bilinearRow);
+        break;
+    default:
+        PixelKernels<RemapRgb888>(isa, row, bilinearRow);
+        break;
+    }
+}
+
+RemapTable::RemapTable()
+    : mSrcWidth(0),
+      mSrcHeight(0),
+      mSrcStride(0),
+      mFormat(QImage::Format_RGB888),
+      mPixelBytes(3),
+      mDstWidth(0),
+      mDstHeight(0),
+      mMode(NearestNeighbour),
+      mOrder(RowMajorOrder),
+      mMappedEntries(NULL),
+      mMappedFractions(NULL),
+      mMappedOrder(NULL)
+{
+}
+
+int RemapTable::RowStride(int width, QImage::Format format)
+{
+    // QImage aligns every scanline to 32 bits.
+    return ((width * PixelBytes(format) * 8 + 31) / 32) * 4;
+}
+
+int RemapTable::PixelBytes(QImage::Format format)
+{
+    switch (format)
+    {
+    case QImage::Format_Grayscale8:
+        return 1;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    case QImage::Format_Grayscale16:
+        return 2;
+#endif
+    case QImage::Format_RGB888:
+        return 3;
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+void RemapTable::Reset(int srcWidth, int srcHeight, int dstWidth, int dstHeight, Interpolation mode,
+                       QImage::Format format)
+{
+    if (PixelBytes(format) == 0)
+    {
+        qDebug("remap table: no kernel for the image format %d, RGB888 is used", static_cast<int>(format));
+        format = QImage::Format_RGB888;
+    }
+    mSrcWidth   = srcWidth;
+    mSrcHeight  = srcHeight;
+    mFormat     = format;
+    mPixelBytes = PixelBytes(format);
+    mSrcStride  = RowStride(srcWidth, format);
+    mDstWidth   = dstWidth;
+    mDstHeight  = dstHeight;
+    mMode       = mode;
+    mOrder      = RowMajorOrder;
+    mTileOrder.clear();
+    mMapping.clear();
+    mMappedEntries      = NULL;
+    mMappedFractions    = NULL;
+    mMappedOrder        = NULL;
+    mEntries.fill(kInvalidEntry, dstWidth * dstHeight);
+    if (mode == Bilinear)
+    {
+        mFractions.fill(0, dstWidth * dstHeight);
+    }
+    else
+    {
+        mFractions.clear();
+    }
+}
+
+void RemapTable::Clear()
+{
+    Reset(0, 0, 0, 0);
+    mEntries.squeeze();
+    mFractions.squeeze();
+    mTileOrder.squeeze();
+}
+
+bool RemapTable::IsNull() const
+{
+    return mEntries.isEmpty() && !IsMapped();
+}
+
+void RemapTable::SetEntry(int x, int y, int srcX, int srcY)
+{
+    if (srcX < 0 || srcX >= mSrcWidth || srcY < 0 || srcY >= mSrcHeight)
+    {
+        SetInvalid(x, y);
+        return;
+    }
+    mEntries[y * mDstWidth + x] = srcY * mSrcStride + srcX * mPixelBytes;
+    if (mMode == Bilinear)
+    {
+        mFractions[y * mDstWidth + x] = 0;
+    }
+}
+
+void RemapTable::SetSubPixelEntry(int x, int y, qreal srcX, qreal srcY)
+{
+    // the pixel centers span [0, size - 1], allow half a pixel outside it.
+    if (srcX < -0.5 || srcX > mSrcWidth - 0.5 || srcY < -0.5 || srcY > mSrcHeight - 0.5)
+    {
+        SetInvalid(x, y);
+        return;
+    }
+    if (mMode != Bilinear)
+    {
+        SetEntry(x, y, qRound(srcX), qRound(srcY));
+        return;
+    }
+
+    srcX = qBound(qreal(0), srcX, qreal(mSrcWidth - 1));
+    srcY = qBound(qreal(0), srcY, qreal(mSrcHeight - 1));
+    int x0 = qFloor(srcX);
+    int y0 = qFloor(srcY);
+    int fx = qRound((srcX - x0) * RemapKernel::kFractionOne);
+    int fy = qRound((srcY - y0) * RemapKernel::kFractionOne);
+    if (fx == RemapKernel::kFractionOne)
+    {
+        x0 += 1;
+        fx  = 0;
+    }
+    if (fy == RemapKernel::kFractionOne)
+    {
+        y0 += 1;
+        fy  = 0;
+    }
+    // the right and lower neighbours are only read for a non-zero fraction.
+    if (x0 >= mSrcWidth - 1)
+    {
+        x0 = mSrcWidth - 1;
+        fx = 0;
+    }
+    if (y0 >= mSrcHeight - 1)
+    {
+        y0 = mSrcHeight - 1;
+        fy = 0;
+    }
+    mEntries[y * mDstWidth + x]     = y0 * mSrcStride + x0 * mPixelBytes;
+    mFractions[y * mDstWidth + x]   = static_cast<quint8>((fx << RemapKernel::kFractionBits) | fy);
+}
+
+void RemapTable::SetEntries(const QPoint *points)
+{
+    // points are stored row by row, one for each output pixel.
+    for (int y = 0; y < mDstHeight; ++y)
+    {
+        for (int x = 0; x < mDstWidth; ++x, ++points)
+        {
+            SetEntry(x, y, points->x(), points->y());
+        }
+    }
+}
+
+void RemapTable::SetEntries(const QPoint *points, const QSize &mapSize, const QRect &region)
+{
+    for (int y = 0; y < mDstHeight; ++y)
+    {
+        const int mapY = region.y() + y;
+        for (int x = 0; x < mDstWidth; ++x)
+        {
+            const int mapX = region.x() + x;
+            if (mapX < 0 || mapX >= mapSize.width() || mapY < 0 || mapY >= mapSize.height())
+            {
+                SetInvalid(x, y);
+                continue;
+            }
+            const QPoint &point = points[mapY * mapSize.width() + mapX];
+            SetEntry(x, y, point.x(), point.y());
+        }
+    }
+}
+
+void RemapTable::SetEntries(const RemapTable &table, const QRect &region)
+{
+    const qint32 *entries   = table.Entries();
+    const quint8 *fractions = table.Fractions();
+    // the columns of the region inside table, the other ones are invalid.
+    const int x0 = qBound(0, -region.x(), mDstWidth);
+    const int x1 = qBound(x0, table.Width() - region.x(), mDstWidth);
+    for (int y = 0; y < mDstHeight; ++y)
+    {
+        const int tableY = region.y() + y;
+        if (tableY < 0 || tableY >= table.Height() || x0 == x1)
+        {
+            for (int x = 0; x < mDstWidth; ++x)
+            {
+                SetInvalid(x, y);
+            }
+            continue;
+        }
+        for (int x = 0; x < x0; ++x)
+        {
+            SetInvalid(x, y);
+        }
+        for (int x = x1; x < mDstWidth; ++x)
+        {
+            SetInvalid(x, y);
+        }
+        const int index = tableY * table.Width() + region.x();
+        memcpy(mEntries.data() + y * mDstWidth + x0, entries + index + x0, (x1 - x0) * sizeof(qint32));
+        if (mMode == Bilinear && fractions != NULL)
+        {
+            memcpy(mFractions.data() + y * mDstWidth + x0, fractions + index + x0, x1 - x0);
+        }
+    }
+}
+
+void RemapTable::SetSubPixelEntries(const QPointF *points)
+{
+    for (int y = 0; y < mDstHeight; ++y)
+    {
+        for (int x = 0; x < mDstWidth; ++x, ++points)
+        {
+            SetSubPixelEntry(x, y, points->x(), points->y());
+        }
+    }
+}
+
+void RemapTable::SetInvalid(int x, int y)
+{
+    mEntries[y * mDstWidth + x] = kInvalidEntry;
+    if (mMode == Bilinear)
+    {
+        mFractions[y * mDstWidth + x] = 0;
+    }
+}
+
+bool RemapTable::ConvertFormat(QImage::Format format)
+{
+    const int bytes = PixelBytes(format);
+    if (bytes == 0)
+    {
+        qDebug("remap table: no kernel for the image format %d", static_cast<int>(format));
+        return false;
+    }
+    if (format == mFormat)
+    {
+        return true;
+    }
+
+    const int stride    = RowStride(mSrcWidth, format);
+    const int count     = mDstWidth * mDstHeight;
+    QVector<qint32> entries(count);
+    const qint32 *source = Entries();
+    for (int n = 0; n < count; ++n)
+    {
+        entries[n] = (source[n] < 0) ? kInvalidEntry
+                                     : (source[n] / mSrcStride) * stride + ((source[n] % mSrcStride) / mPixelBytes) * bytes;
+    }
+    if (IsMapped())
+    {
+        // the fractions and the order leave the file with the entries.
+        if (mMappedFractions != NULL)
+        {
+            mFractions = QVector<quint8>(count);
+            memcpy(mFractions.data(), mMappedFractions, count);
+        }
+        if (mMappedOrder != NULL)
+        {
+            mTileOrder = QVector<int>(TileCount());
+            memcpy(mTileOrder.data(), mMappedOrder, mTileOrder.size() * sizeof(int));
+        }
+        mMapping.clear();
+        mMappedEntries      = NULL;
+        mMappedFractions    = NULL;
+        mMappedOrder        = NULL;
+    }
+    mEntries    = entries;
+    mSrcStride  = stride;
+    mFormat     = format;
+    mPixelBytes = bytes;
+    return true;
+}
+
+bool RemapTable::Apply(const QImage *input, QImage *output) const
+{
+    if (IsNull() || input->width() != mSrcWidth || input->height() != mSrcHeight)
+    {
+        qDebug("remap table mismatch: table source %dx%d, image %dx%d",
+               mSrcWidth, mSrcHeight, input->width(), input->height());
+        return false;
+    }
+
+    QImage converted;
+    const QImage *source = input;
+    if (input->format() != mFormat)
+    {
+        converted   = input->convertToFormat(mFormat);
+        source      = &converted;
+    }
+    if (source->bytesPerLine() != mSrcStride)
+    {
+        // the entries are byte offsets, so the scanlines must be packed as RowStride().
+        converted   = source->copy();
+        source      = &converted;
+    }
+
+    if (output->width() != mDstWidth || output->height() != mDstHeight || output->format() != mFormat)
+    {
+        *output = QImage(mDstWidth, mDstHeight, mFormat);
+    }
+
+    // detach the output here, the tiles only write to the raw scanlines.
+    uchar *dst                  = output->bits();
+    const qint32 safeLimit      = mSrcStride * mSrcHeight - 4;
+    // a source smaller than one 4-byte load only takes the scalar kernels.
+    RemapKernel::RowFunc row;
+    RemapKernel::BilinearRowFunc bilinearRow;
+    FormatKernels(mFormat, (safeLimit < 0) ? RemapKernel::Scalar : RemapKernel::ActiveIsa(), &row, &bilinearRow);
+    RemapTileJob job(this, source->constBits(), dst, output->bytesPerLine(), safeLimit, row, bilinearRow);
+    WorkerPool::getInstance()->Run(&job, TileCount());
+    return true;
+}
+
+/**
+ * spread the low 16 bits of value to the even bits, for the Morton order.
+ **/
+static quint32 SpreadBits(quint32 value)
+{
+    value &= 0xffff;
+    value = (value | (value << 8)) & 0x00ff00ff;
+    value = (value | (value << 4)) & 0x0f0f0f0f;
+    value = (value | (value << 2)) & 0x33333333;
+    value = (value | (value << 1)) & 0x55555555;
+    return value;
+}
+
+void RemapTable::SetTraversalOrder(TraversalOrder order)
+{
+    mOrder = order;
+    mTileOrder.clear();
+    mMappedOrder = NULL;
+    if (order == RowMajorOrder || IsNull())
+    {
+        return;
+    }
+
+    const int count     = TileCount();
+    const int columns   = TileColumns();
+    QVector<QPair<quint64, int> > keys(count);
+    for (int tile = 0; tile < count; ++tile)
+    {
+        quint64 key = 0;
+        if (order == MortonOrder)
+        {
+            key = SpreadBits(tile % columns) | (SpreadBits(tile / columns) << 1);
+        }
+        else
+        {
+            // the top-left corner of the source bounding box, the empty tiles go last.
+            int x0, y0, x1, y1;
+            TileRect(tile, &x0, &y0, &x1, &y1);
+            int minX = mSrcWidth;
+            int minY = mSrcHeight;
+            for (int y = y0; y < y1; ++y)
+            {
+                const qint32 *entries = Entries() + y * mDstWidth;
+                for (int x = x0; x < x1; ++x)
+                {
+                    if (entries[x] < 0) continue;
+                    minY = qMin(minY, entries[x] / mSrcStride);
+                    minX = qMin(minX, (entries[x] % mSrcStride) / mPixelBytes);
+                }
+            }
+            key = (static_cast<quint64>(minY) << 32) | static_cast<quint32>(minX);
+        }
+        keys[tile] = qMakePair(key, tile);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    mTileOrder.resize(count);
+    for (int n = 0; n < count; ++n)
+    {
+        mTileOrder[n] = keys[n].second;
+    }
+}
+
+const qint32 *RemapTable::TileOrder() const
+{
+    if (!mTileOrder.isEmpty())
+    {
+        return mTileOrder.constData();
+    }
+    return mMappedOrder;
+}
+
+int RemapTable::TileColumns() const
+{
+    return (mDstWidth + kTileWidth - 1) / kTileWidth;
+}
+
+int RemapTable::TileCount() const
+{
+    const int tilesY = (mDstHeight + kTileHeight - 1) / kTileHeight;
+    return TileColumns() * tilesY;
+}
+
+void RemapTable::TileRect(int tile, int *x0, int *y0, int *x1, int *y1) const
+{
+    const int columns = TileColumns();
+    *x0 = (tile % columns) * kTileWidth;
+    *y0 = (tile / columns) * kTileHeight;
+    *x1 = qMin(*x0 + kTileWidth, mDstWidth);
+    *y1 = qMin(*y0 + kTileHeight, mDstHeight);
+}
+
+void RemapTable::ApplyTile(const uchar *src, uchar *dst, int dstStride, qint32 safeLimit, RemapKernel::RowFunc row,
+                           RemapKernel::BilinearRowFunc bilinearRow, int index) const
+{
+    int x0, y0, x1, y1;
+    const qint32 *order = TileOrder();
+    TileRect((order == NULL) ? index : order[index], &x0, &y0, &x1, &y1);
+    const int count = x1 - x0;
+
+    if (mMode == Bilinear)
+    {
+        for (int y = y0; y < y1; ++y)
+        {
+            const int entry = y * mDstWidth + x0;
+            bilinearRow(dst + y * dstStride + x0 * mPixelBytes, src, Entries() + entry, Fractions() + entry,
+                        count, mSrcStride, safeLimit, 0);
+        }
+        return;
+    }
+
+    for (int y = y0; y < y1; ++y)
+    {
+        row(dst + y * dstStride + x0 * mPixelBytes, src, Entries() + y * mDstWidth + x0, count, safeLimit, 0);
+    }
+}
@@ -0,0 +1,168 @@
+#ifndef RemapTable_H
+#define RemapTable_H
+
+#include <QImage>
+#include <QVector>
+#include <QPoint>
+#include <QPointF>
+#include <QRect>
+#include <QSharedPointer>
+#include <QSize>
+#include "RemapKernel.h"
+
+class RemapTableMapping;
+
+/**
+ * RemapTable : a flat output -> source lookup table.
+ * every entry stores the byte offset of the source pixel inside a source
+ * of Format() (QImage::Format_RGB888 unless it is reset or converted to
+ * another one), so one frame is corrected by a single gather pass over
+ * the raw scanlines.
+ * the entry kInvalidEntry means the output pixel has no source (black).
+ * in Bilinear mode every entry also carries 4-bit sub-pixel fractions,
+ * and the output is blended from the 2x2 source neighbourhood.
+ * a table mapped by RemapTableFile::Map() reads its arrays in place from
+ * the file, it is read only until the next Reset(), and its copies keep
+ * the file mapped.
+ **/
+class RemapTable
+{
+public:
+    static const qint32 kInvalidEntry = -1;
+    // Apply() splits the output into tiles of this size for the WorkerPool.
+    static const int    kTileWidth    = 256;
+    static const int    kTileHeight   = 16;
+
+    enum Interpolation
+    {
+        NearestNeighbour    = 0,
+        Bilinear            = 1
+    };
+
+    /*
+     * TraversalOrder : the order the output tiles are remapped in.
+     * SourceSortedOrder sorts the tiles by the top-left corner of their source
+     * bounding box, MortonOrder walks the tile grid on a Z curve. both keep the
+     * tiles reading the same source rows next to each other, so they share
+     * the cached source lines (and the same worker, which runs a contiguous
+     * range of the order).
+     **/
+    enum TraversalOrder
+    {
+        RowMajorOrder       = 0,
+        SourceSortedOrder   = 1,
+        MortonOrder         = 2
+    };
+
+    RemapTable();
+
+    void    Reset(int srcWidth, int srcHeight, int dstWidth, int dstHeight,
+                  Interpolation mode = NearestNeighbour, QImage::Format format = QImage::Format_RGB888);
+    void    Clear();
+    bool    IsNull() const;
+    bool    IsMapped() const        { return !mMapping.isNull(); }
+
+    void    SetEntry(int x, int y, int srcX, int srcY);
+    void    SetEntries(const QPoint *points);
+    /*
+     * SetEntries() : the entries from the region of a mapSize map of points,
+     * stored row by row. the region is Width() x Height(), the pixels out
+     * of the map are invalid.
+     **/
+    void    SetEntries(const QPoint *points, const QSize &mapSize, const QRect &region);
+    /*
+     * SetEntries() : the entries of the region of table, which has the
+     * source, the format and the mode of this one. the region is Width() x
+     * Height(), the pixels out of table are invalid.
+     **/
+    void    SetEntries(const RemapTable &table, const QRect &region);
+    void    SetSubPixelEntry(int x, int y, qreal srcX, qreal srcY);
+    void    SetSubPixelEntries(const QPointF *points);
+    void    SetInvalid(int x, int y);
+
+    /*
+     * SetTraversalOrder() : call it after the entries are set,
+     * the source sorted order depends on them.
+     **/
+    void    SetTraversalOrder(TraversalOrder order);
+    TraversalOrder Order() const    { return mOrder; }
+    int     TileCount() const;
+    // the tiles in the traversal order, NULL for RowMajorOrder.
+    const qint32 *TileOrder() const;
+
+    int     SourceWidth() const     { return mSrcWidth; }
+    int     SourceHeight() const    { return mSrcHeight; }
+    int     SourceStride() const    { return mSrcStride; }
+    QImage::Format Format() const   { return mFormat; }
+    int     PixelBytes() const      { return mPixelBytes; }
+    int     Width() const           { return mDstWidth; }
+    int     Height() const          { return mDstHeight; }
+    Interpolation Mode() const      { return mMode; }
+    const qint32 *Entries() const   { return IsMapped() ? mMappedEntries : mEntries.constData(); }
+    // (fx << 4) | fy for every entry, NULL in NearestNeighbour mode.
+    const quint8 *Fractions() const
+    {
+        if (IsMapped())
+        {
+            return mMappedFractions;
+        }
+        return mFractions.isEmpty() ? NULL : mFractions.constData();
+    }
+
+    /*
+     * ConvertFormat() : the same table for a source of format, the
+     * entries are encoded again with its pixel size and stride. a gray or
+     * 16-bit camera converts its table once instead of every frame.
+     * false (and the table is unchanged) for a format PixelBytes() does
+     * not know. a mapped table gets its own arrays.
+     **/
+    bool    ConvertFormat(QImage::Format format);
+
+    /*
+     * Apply() : remap the input frame into output.
+     * the input is converted to Format() when needed, the output is
+     * (re)allocated as Width() x Height() of Format().
+     * the tiles are remapped on the shared WorkerPool.
+     **/
+    bool    Apply(const QImage *input, QImage *output) const;
+
+    /*
+     * RowStride() : the bytesPerLine of a QImage of format with the given width.
+     **/
+    static int RowStride(int width, QImage::Format format = QImage::Format_RGB888);
+    /*
+     * PixelBytes() : the pixel size of the formats the kernels are
+     * generated for (Grayscale8, RGB888, RGBA8888, RGBX8888, RGB32,
+     * ARGB32 and Grayscale16), 0 for the other ones.
+     **/
+    static int PixelBytes(QImage::Format format);
+
+private:
+    friend class RemapTileJob;
+    friend class RemapTableFile;
+
+    int     TileColumns() const;
+    void    TileRect(int tile, int *x0, int *y0, int *x1, int *y1) const;
+    void    ApplyTile(const uchar *src, uchar *dst, int dstStride, qint32 safeLimit, RemapKernel::RowFunc row,
+                      RemapKernel::BilinearRowFunc bilinearRow, int index) const;
+
+    int             mSrcWidth;
+    int             mSrcHeight;
+    int             mSrcStride;
+    QImage::Format  mFormat;
+    int             mPixelBytes;
+    int             mDstWidth;
+    int             mDstHeight;
+    Interpolation   mMode;
+    TraversalOrder  mOrder;
+    QVector<int>    mTileOrder;
+    QVector<qint32> mEntries;
+    QVector<quint8> mFractions;
+    // the file the mapped arrays point into, NULL when the table owns them.
+    QSharedPointer<RemapTableMapping> mMapping;
+    const qint32   *mMappedEntries;
+    const quint8   *mMappedFractions;
+    const qint32   *mMappedOrder;
+};
+
+#endif // RemapTable_H
@@ -0,0 +1,292 @@
+#include "RemapTableCache.h"
+#include "RemapTableFile.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+#include <QThread>
+
+const int RemapTableCache::kModelVersion;
+const int RemapTableCache::kMaxPendingWrites;
+
+class RemapTableCacheWriter : public QThread
+{
+public:
+    explicit RemapTableCacheWriter(RemapTableCache *cache)
+        : mCache(cache)
+    {
+    }
+
+protected:
+    void run()
+    {
+        mCache->WriterLoop();
+    }
+
+private:
+    RemapTableCache *mCache;
+};
+
+RemapTableCache *RemapTableCache::getInstance()
+{
+    static RemapTableCache cache;
+    return &cache;
+}
+
+RemapTableCache::RemapTableCache()
+    : mTables(256 * 1024),
+      mDiskLimit(512LL * 1024 * 1024),
+      mWriter(NULL),
+      mWriting(false),
+      mQuit(false)
+{
+    const QString location = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!location.isEmpty())
+    {
+        mDirectory = QDir(location).filePath("remap_tables");
+    }
+    mWriter = new RemapTableCacheWriter(this);
+    mWriter->start();
+}
+
+RemapTableCache::~RemapTableCache()
+{
+    // the queued files are written before the thread ends.
+    {
+        QMutexLocker locker(&mMutex);
+        mQuit = true;
+        mWakeUp.wakeAll();
+    }
+    mWriter->wait();
+    delete mWriter;
+}
+
+void RemapTableCache::SetDirectory(const QString &path)
+{
+    QMutexLocker locker(&mMutex);
+    mDirectory = path;
+}
+
+QString RemapTableCache::Directory() const
+{
+    QMutexLocker locker(&mMutex);
+    return mDirectory;
+}
+
+void RemapTableCache::SetMemoryLimit(int kilobytes)
+{
+    QMutexLocker locker(&mMutex);
+    mTables.setMaxCost(kilobytes);
+}
+
+void RemapTableCache::ClearMemory()
+{
+    QMutexLocker locker(&mMutex);
+    mTables.clear();
+}
+
+void RemapTableCache::SetDiskLimit(int megabytes)
+{
+    QMutexLocker locker(&mMutex);
+    mDiskLimit = static_cast<qint64>(qMax(0, megabytes)) * 1024 * 1024;
+}
+
+void RemapTableCache::WaitForWrites()
+{
+    QMutexLocker locker(&mMutex);
+    while (!mWrites.isEmpty() || mWriting)
+    {
+        mWritten.wait(&mMutex);
+    }
+}
+
+QByteArray RemapTableCache::Key(const CorrectionParameters_t &params, TableKind kind)
+{
+    // symmetric_tables is left out, it only changes the form the table is applied in.
+    const qint32 fields[] =
+    {
+        kModelVersion,
+        kind,
+        params.width,
+        params.height,
+        params.optical_center_x,
+        params.optical_center_y,
+        params.rotation,
+        params.horizontal_base,
+        params.vertical_base,
+        params.crop_x,
+        params.crop_y,
+        params.crop_w,
+        params.crop_h,
+        params.interpolation,
+        params.traversal_order
+    };
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(reinterpret_cast<const char *>(fields), sizeof(fields));
+    return hash.result().toHex();
+}
+
+QString RemapTableCache::FilePath(const QString &directory, const QByteArray &key)
+{
+    return QDir(directory).filePath(QString::fromLatin1(key) + ".bin");
+}
+
+/**
+ * the memory a table keeps, in KB, a mapped table counts as much.
+ **/
+static int TableCost(const RemapTable &table)
+{
+    const qint64 count = static_cast<qint64>(table.Width()) * table.Height();
+    const qint64 bytes = count * sizeof(qint32) + (table.Fractions() != NULL ? count : 0)
+                       + (table.TileOrder() != NULL ? table.TileCount() * sizeof(qint32) : 0);
+    return static_cast<int>(qMax<qint64>(1, bytes / 1024));
+}
+
+bool RemapTableCache::Find(const CorrectionParameters_t &params, TableKind kind, RemapTable *table)
+{
+    const QByteArray key = Key(params, kind);
+    QString path;
+    {
+        QMutexLocker locker(&mMutex);
+        const RemapTable *cached = mTables.object(key);
+        if (cached != NULL)
+        {
+            *table = *cached;
+            return true;
+        }
+        // a table evicted from memory before its file is written.
+        for (int i = 0; i < mWrites.size(); ++i)
+        {
+            if (mWrites.at(i).key == key)
+            {
+                *table = mWrites.at(i).table;
+                return true;
+            }
+        }
+        if (kind != CorrectionTable || mDirectory.isEmpty())
+        {
+            return false;
+        }
+        path = FilePath(mDirectory, key);
+    }
+
+    // another process may have written the file, it is verified.
+    if (!QFile::exists(path) || !RemapTableFile::Map(path, table))
+    {
+        return false;
+    }
+    qDebug("remap table cache: %s from %s", key.constData(), qPrintable(path));
+    // the modification time is the last use Evict() orders the files by.
+    QFile file(path);
+    if (file.open(QIODevice::ReadWrite))
+    {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+    QMutexLocker locker(&mMutex);
+    mTables.insert(key, new RemapTable(*table), TableCost(*table));
+    return true;
+}
+
+void RemapTableCache::Insert(const CorrectionParameters_t &params, TableKind kind, const RemapTable &table)
+{
+    if (table.IsNull())
+    {
+        return;
+    }
+    const QByteArray key = Key(params, kind);
+    QMutexLocker locker(&mMutex);
+    mTables.insert(key, new RemapTable(table), TableCost(table));
+    if (kind != CorrectionTable || mDirectory.isEmpty())
+    {
+        return;
+    }
+    for (int i = 0; i < mWrites.size(); ++i)
+    {
+        if (mWrites.at(i).key == key)
+        {
+            return;
+        }
+    }
+    if (mWrites.size() >= kMaxPendingWrites)
+    {
+        qDebug("remap table cache: %s is not written, the writer is behind", mWrites.first().key.constData());
+        mWrites.removeFirst();
+    }
+    PendingWrite_t write;
+    write.key       = key;
+    write.directory = mDirectory;
+    write.table     = table;
+    mWrites.append(write);
+    mWakeUp.wakeAll();
+}
+
+void RemapTableCache::WriterLoop()
+{
+    QMutexLocker locker(&mMutex);
+    while (true)
+    {
+        if (mWrites.isEmpty())
+        {
+            if (mQuit)
+            {
+                break;
+            }
+            mWakeUp.wait(&mMutex);
+            continue;
+        }
+        const PendingWrite_t write  = mWrites.takeFirst();
+        const qint64 limit          = mDiskLimit;
+        mWriting = true;
+        locker.unlock();
+
+        if (!QDir(write.directory).mkpath(".") || !RemapTableFile::Write(FilePath(write.directory, write.key), write.table))
+        {
+            qDebug() << "remap table cache: can not write to" << write.directory;
+        }
+        else
+        {
+            Evict(write.directory, limit);
+        }
+
+        locker.relock();
+        mWriting = false;
+        mWritten.wakeAll();
+    }
+}
+
+/**
+ * remove the least recently used files until the directory fits in limit,
+ * the newest file stays even when it alone is larger.
+ **/
+void RemapTableCache::Evict(const QString &directory, qint64 limit)
+{
+    const QFileInfoList files = QDir(directory).entryInfoList(QStringList("*.bin"), QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (int i = 0; i < files.size(); ++i)
+    {
+        total += files.at(i).size();
+        if (i > 0 && total > limit)
+        {
+            qDebug("remap table cache: %s is removed", qPrintable(files.at(i).fileName()));
+            QFile::remove(files.at(i).filePath());
+        }
+    }
+}
+
+bool RemapTableCache::CorrectionTable3(const CorrectionParameters_t &params, RemapTable *table,
+                                       const QAtomicInt *cancelled)
+{
+    if (Find(params, CorrectionTable, table))
+    {
+        return true;
+    }
+    // generated unlocked, two threads missing the same key both generate it.
+    if (!FisheyeDistortionCorrection::getInstance()->GenerateCorrectionTable3(params, table, cancelled))
+    {
+        return false;
+    }
+    Insert(params, CorrectionTable, *table);
+    return true;
+}
@@ -0,0 +1,109 @@
+#ifndef RemapTableCache_H
+#define RemapTableCache_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include "FisheyeDistortionCorrection.h"
+#include "RemapTable.h"
+
+class RemapTableCacheWriter;
+
+/**
+ * RemapTableCache : the Process3 tables by parameter set, the most recently
+ * used ones in memory and the correction tables as version 2 mapping files
+ * in a directory, so a configuration seen before (in this run or an earlier
+ * one) is a lookup, not a generation.
+ * the files are written on the writer thread and the directory is bounded,
+ * the least recently used files are removed past the disk limit. the
+ * diagnostic tables are only kept in memory.
+ * the key is a hash of the parameters the table depends on and of
+ * kModelVersion. the symmetric form is built from the cached flat table.
+ * the tables are handed out as copies, they share the cached arrays.
+ **/
+class RemapTableCache
+{
+public:
+    // bump it when the tables of the same parameters change.
+    static const int kModelVersion = 2;
+
+    enum TableKind
+    {
+        CorrectionTable = 0,    // the composed table of Process3.
+        HorizontalTable = 1,    // the diagnostic views.
+        VerticalTable   = 2
+    };
+
+    static  RemapTableCache *getInstance();
+
+    /*
+     * SetDirectory() : the persistent store, empty to keep the tables in
+     * memory only. the default is "remap_tables" in the cache location.
+     **/
+    void    SetDirectory(const QString &path);
+    QString Directory() const;
+    // the memory kept for the tables, in KB.
+    void    SetMemoryLimit(int kilobytes);
+    // forget the tables in memory, the directory stays.
+    void    ClearMemory();
+    // the size of the directory, in MB, the default is 512.
+    void    SetDiskLimit(int megabytes);
+    // wait until the queued files are written.
+    void    WaitForWrites();
+
+    static QByteArray Key(const CorrectionParameters_t &params, TableKind kind);
+
+    /*
+     * Find() : the table from memory or from the directory (the correction
+     * table only). Insert() keeps it in memory and queues its file.
+     **/
+    bool    Find(const CorrectionParameters_t &params, TableKind kind, RemapTable *table);
+    void    Insert(const CorrectionParameters_t &params, TableKind kind, const RemapTable &table);
+
+    /*
+     * CorrectionTable3() : the Process3 table of params, generated by
+     * GenerateCorrectionTable3() and cached when it is not found. false
+     * when the generation is cancelled, nothing is cached then.
+     **/
+    bool    CorrectionTable3(const CorrectionParameters_t &params, RemapTable *table,
+            const QAtomicInt *cancelled = NULL);
+
+private:
+    friend class RemapTableCacheWriter;
+
+    // the files waiting for the writer thread, the oldest is dropped past it.
+    static const int kMaxPendingWrites = 4;
+
+    typedef struct
+    {
+        QByteArray  key;
+        QString     directory;
+        RemapTable  table;
+    } PendingWrite_t;
+
+    RemapTableCache();
+    ~RemapTableCache();
+
+    static QString FilePath(const QString &directory, const QByteArray &key);
+    static void    Evict(const QString &directory, qint64 limit);
+
+    void    WriterLoop();
+
+    mutable QMutex                      mMutex;
+    QCache<QByteArray, RemapTable>      mTables;
+    QString                             mDirectory;
+    qint64                              mDiskLimit;     // bytes
+
+    // the files for the writer thread.
+    QWaitCondition                      mWakeUp;
+    QWaitCondition                      mWritten;
+    RemapTableCacheWriter              *mWriter;
+    QList<PendingWrite_t>               mWrites;
+    bool                                mWriting;
+    bool                                mQuit;
+};
+
+#endif // RemapTableCache_H
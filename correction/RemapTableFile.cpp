@@ -0,0 +1,575 @@
+#include "RemapTableFile.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QVector>
+#include <QtEndian>
+
+#include <string.h>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const quint32 RemapTableFile::kMagicNumber;
+const int RemapTableFile::kMajorVersion;
+const int RemapTableFile::kMinorVersion;
+const int RemapTableFile::kAlignment;
+
+/**
+ * RemapTableMapping : a read only map of a whole mapping file, unmapped
+ * when the last table using it goes away.
+ * mmap() on unix, with MAP_POPULATE on linux, QFile::map() elsewhere.
+ **/
+class RemapTableMapping
+{
+public:
+    RemapTableMapping()
+        : mData(NULL),
+          mSize(0)
+    {
+    }
+
+    ~RemapTableMapping()
+    {
+#ifdef Q_OS_UNIX
+        if (mData != NULL)
+        {
+            munmap(mData, mSize);
+        }
+#endif
+    }
+
+    bool Map(const QString &path, bool populate)
+    {
+#ifdef Q_OS_UNIX
+        const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        if (populate)
+        {
+            flags |= MAP_POPULATE;
+        }
+#endif
+        void *data = mmap(NULL, info.st_size, PROT_READ, flags, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+#ifndef MAP_POPULATE
+        if (populate)
+        {
+            madvise(data, info.st_size, MADV_WILLNEED);
+        }
+#endif
+        mData   = static_cast<uchar *>(data);
+        mSize   = info.st_size;
+        return true;
+#else
+        Q_UNUSED(populate);
+        mFile.setFileName(path);
+        if (!mFile.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+        mSize = mFile.size();
+        mData = (mSize > 0) ? mFile.map(0, mSize) : NULL;
+        return mData != NULL;
+#endif
+    }
+
+    const uchar *Data() const   { return mData; }
+    qint64  Size() const        { return mSize; }
+
+private:
+    Q_DISABLE_COPY(RemapTableMapping)
+
+    uchar  *mData;
+    qint64  mSize;
+#ifndef Q_OS_UNIX
+    QFile   mFile;
+#endif
+};
+
+static quint32 AlignUp(quint64 value)
+{
+    const quint64 alignment = RemapTableFile::kAlignment;
+    return static_cast<quint32>((value + alignment - 1) / alignment * alignment);
+}
+
+/**
+ * the header fields between the file order (little-endian) and the host one,
+ * the same swap both ways.
+ **/
+static void SwapHeader(RemapTableFileHeader_t *header)
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    header->magic_number        = qbswap(header->magic_number);
+    header->major_version       = qbswap(header->major_version);
+    header->minor_version       = qbswap(header->minor_version);
+    header->header_size         = qbswap(header->header_size);
+    header->file_size           = qbswap(header->file_size);
+    header->entry_type          = qbswap(header->entry_type);
+    header->width_in            = qbswap(header->width_in);
+    header->height_in           = qbswap(header->height_in);
+    header->src_stride          = qbswap(header->src_stride);
+    header->width_out           = qbswap(header->width_out);
+    header->height_out          = qbswap(header->height_out);
+    header->traversal_order     = qbswap(header->traversal_order);
+    header->entries_offset      = qbswap(header->entries_offset);
+    header->fractions_offset    = qbswap(header->fractions_offset);
+    header->order_offset        = qbswap(header->order_offset);
+    header->tile_count          = qbswap(header->tile_count);
+    header->crc32               = qbswap(header->crc32);
+#else
+    Q_UNUSED(header);
+#endif
+}
+
+static void SwapWords(qint32 *words, int count)
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    for (int n = 0; n < count; ++n)
+    {
+        words[n] = qbswap(words[n]);
+    }
+#else
+    Q_UNUSED(words);
+    Q_UNUSED(count);
+#endif
+}
+
+/**
+ * the words in the file order, a swapped copy on a big-endian host.
+ **/
+static const qint32 *LittleEndianWords(const qint32 *words, int count, QVector<qint32> *swapped)
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    swapped->resize(count);
+    for (int n = 0; n < count; ++n)
+    {
+        (*swapped)[n] = qbswap(words[n]);
+    }
+    return swapped->constData();
+#else
+    Q_UNUSED(count);
+    Q_UNUSED(swapped);
+    return words;
+#endif
+}
+
+/**
+ * the slicing by 4 tables of the crc, table[k][b] is the crc of the byte b
+ * followed by k zero bytes.
+ **/
+typedef struct Crc32Table
+{
+    quint32 table[4][256];
+
+    Crc32Table()
+    {
+        for (quint32 b = 0; b < 256; ++b)
+        {
+            quint32 value = b;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                value = (value & 1) ? (0xedb88320u ^ (value >> 1)) : (value >> 1);
+            }
+            table[0][b] = value;
+        }
+        for (quint32 b = 0; b < 256; ++b)
+        {
+            for (int k = 1; k < 4; ++k)
+            {
+                table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xff];
+            }
+        }
+    }
+} Crc32Table_t;
+
+quint32 RemapTableFile::Crc32(const void *data, qint64 size, quint32 crc)
+{
+    static const Crc32Table_t tables;
+    const quint32 (&table)[4][256] = tables.table;
+
+    const uchar *bytes = static_cast<const uchar *>(data);
+    crc = ~crc;
+    for (; size >= 4; size -= 4, bytes += 4)
+    {
+        crc ^= bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<quint32>(bytes[3]) << 24);
+        crc = table[3][crc & 0xff] ^ table[2][(crc >> 8) & 0xff]
+            ^ table[1][(crc >> 16) & 0xff] ^ table[0][crc >> 24];
+    }
+    for (; size > 0; --size, ++bytes)
+    {
+        crc = table[0][(crc ^ *bytes) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * one payload section: the zero padding up to offset, then the data.
+ **/
+static bool WriteSection(QIODevice *file, quint32 *position, quint32 offset,
+                         const void *data, quint32 size, quint32 *crc)
+{
+    static const char zeros[RemapTableFile::kAlignment] = { 0 };
+    const quint32 padding = offset - *position;
+    *crc = RemapTableFile::Crc32(zeros, padding, *crc);
+    *crc = RemapTableFile::Crc32(data, size, *crc);
+    *position = offset + size;
+    return file->write(zeros, padding) == padding && file->write(static_cast<const char *>(data), size) == size;
+}
+
+static bool ReadSection(QFile *file, quint32 *position, quint32 offset,
+                        void *data, quint32 size, quint32 *crc)
+{
+    char padding[RemapTableFile::kAlignment];
+    while (*position < offset)
+    {
+        const quint32 count = qMin<quint32>(offset - *position, sizeof(padding));
+        if (file->read(padding, count) != count)
+        {
+            return false;
+        }
+        *crc        = RemapTableFile::Crc32(padding, count, *crc);
+        *position  += count;
+    }
+    if (file->read(static_cast<char *>(data), size) != size)
+    {
+        return false;
+    }
+    *crc        = RemapTableFile::Crc32(data, size, *crc);
+    *position  += size;
+    return true;
+}
+
+bool RemapTableFile::Write(const QString &path, const RemapTable &table)
+{
+    if (table.IsNull() || table.Format() != QImage::Format_RGB888)
+    {
+        return false;
+    }
+
+    const quint32 count = static_cast<quint32>(table.Width()) * table.Height();
+    RemapTableFileHeader_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic_number     = kMagicNumber;
+    header.major_version    = kMajorVersion;
+    header.minor_version    = kMinorVersion;
+    header.header_size      = sizeof(header);
+    header.entry_type       = (table.Mode() == RemapTable::Bilinear) ? BilinearEntries : NearestEntries;
+    header.width_in         = table.SourceWidth();
+    header.height_in        = table.SourceHeight();
+    header.src_stride       = table.SourceStride();
+    header.width_out        = table.Width();
+    header.height_out       = table.Height();
+    header.traversal_order  = table.Order();
+    header.entries_offset   = AlignUp(sizeof(header));
+    quint32 end             = header.entries_offset + count * sizeof(qint32);
+    if (header.entry_type == BilinearEntries)
+    {
+        header.fractions_offset = AlignUp(end);
+        end                     = header.fractions_offset + count;
+    }
+    if (table.TileOrder() != NULL)
+    {
+        header.order_offset     = AlignUp(end);
+        header.tile_count       = table.TileCount();
+        end                     = header.order_offset + header.tile_count * sizeof(qint32);
+    }
+    header.file_size        = AlignUp(end);
+
+    QVector<qint32> swappedEntries, swappedOrder;
+    const qint32 *entries   = LittleEndianWords(table.Entries(), count, &swappedEntries);
+    const qint32 *order     = LittleEndianWords(table.TileOrder(), header.tile_count, &swappedOrder);
+
+    // the crc is only known once the payload is written, the header goes last.
+    quint32 crc = 0;
+    quint32 position = header.header_size;
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "can not write the mapping file" << path;
+        return false;
+    }
+    RemapTableFileHeader_t placeholder;
+    memset(&placeholder, 0, sizeof(placeholder));
+    bool ok = file.write(reinterpret_cast<const char *>(&placeholder), sizeof(placeholder)) == sizeof(placeholder);
+    ok = ok && WriteSection(&file, &position, header.entries_offset, entries, count * sizeof(qint32), &crc);
+    if (ok && header.fractions_offset != 0)
+    {
+        ok = WriteSection(&file, &position, header.fractions_offset, table.Fractions(), count, &crc);
+    }
+    if (ok && header.order_offset != 0)
+    {
+        ok = WriteSection(&file, &position, header.order_offset, order,
+                          header.tile_count * sizeof(qint32), &crc);
+    }
+    if (ok)
+    {
+        ok = WriteSection(&file, &position, header.file_size, NULL, 0, &crc);
+    }
+    header.crc32 = crc;
+    SwapHeader(&header);
+    ok = ok && file.seek(0) && file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header);
+    if (!ok)
+    {
+        qDebug() << "can not write the mapping file" << path;
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool RemapTableFile::IsVersion2(const QString &path)
+{
+    QFile file(path);
+    quint32 magic = 0;
+    if (!file.open(QIODevice::ReadOnly)
+            || file.read(reinterpret_cast<char *>(&magic), sizeof(magic)) != sizeof(magic))
+    {
+        return false;
+    }
+    return qFromLittleEndian(magic) == kMagicNumber;
+}
+
+/**
+ * the sizes and the sections of the header fit the file, in their order.
+ **/
+static bool CheckHeader(const RemapTableFileHeader_t &header, qint64 fileSize)
+{
+    if (header.magic_number != RemapTableFile::kMagicNumber
+            || header.major_version != RemapTableFile::kMajorVersion)
+    {
+        return false;
+    }
+    if (header.header_size < sizeof(RemapTableFileHeader_t) || header.file_size != fileSize
+            || header.width_in <= 0 || header.height_in <= 0 || header.width_out <= 0 || header.height_out <= 0
+            || header.src_stride != RemapTable::RowStride(header.width_in)
+            || static_cast<qint64>(header.src_stride) * header.height_in > 0x7fffffff
+            || static_cast<qint64>(header.width_out) * header.height_out > 0x7fffffff / 4
+            || header.entry_type > RemapTableFile::BilinearEntries
+            || header.traversal_order < RemapTable::RowMajorOrder || header.traversal_order > RemapTable::MortonOrder)
+    {
+        return false;
+    }
+
+    const quint64 count = static_cast<quint64>(header.width_out) * header.height_out;
+    quint64 end = header.header_size;
+    const quint32 offsets[3]    = { header.entries_offset, header.fractions_offset, header.order_offset };
+    const quint64 sizes[3]      = { count * 4, count, static_cast<quint64>(header.tile_count) * 4 };
+    for (int n = 0; n < 3; ++n)
+    {
+        if (offsets[n] == 0 && n > 0)
+        {
+            continue;
+        }
+        if (offsets[n] < end || offsets[n] % RemapTableFile::kAlignment != 0)
+        {
+            return false;
+        }
+        end = offsets[n] + sizes[n];
+    }
+    if ((header.entry_type == RemapTableFile::BilinearEntries) != (header.fractions_offset != 0)
+            || (header.order_offset == 0 && header.tile_count != 0))
+    {
+        return false;
+    }
+    return end <= header.file_size;
+}
+
+/**
+ * every entry reads inside the source, the bilinear neighbours included,
+ * and the tile order has tileCount tiles of the table.
+ * the kernels trust the entries, the crc only catches a damaged file.
+ **/
+static bool CheckTable(const RemapTable &table, int tileCount)
+{
+    const qint32 *order = table.TileOrder();
+    if (order != NULL)
+    {
+        if (tileCount != table.TileCount())
+        {
+            return false;
+        }
+        for (int n = 0; n < tileCount; ++n)
+        {
+            if (order[n] < 0 || order[n] >= tileCount)
+            {
+                return false;
+            }
+        }
+    }
+
+    const qint32 last       = (table.SourceHeight() - 1) * table.SourceStride() + (table.SourceWidth() - 1) * 3;
+    const qint32 *entries   = table.Entries();
+    const quint8 *fractions = table.Fractions();
+    const int count         = table.Width() * table.Height();
+    for (int n = 0; n < count; ++n)
+    {
+        qint32 reach = entries[n];
+        if (fractions != NULL)
+        {
+            reach += ((fractions[n] >> 4) != 0 ? 3 : 0) + ((fractions[n] & 0xf) != 0 ? table.SourceStride() : 0);
+        }
+        if ((entries[n] < 0 || reach > last) && entries[n] != RemapTable::kInvalidEntry)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RemapTableFile::Read(const QString &path, RemapTable *table)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "can not open the mapping file" << path;
+        return false;
+    }
+    RemapTableFileHeader_t header;
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header))
+    {
+        qDebug() << "bad mapping file" << path;
+        return false;
+    }
+    SwapHeader(&header);
+    if (!CheckHeader(header, file.size()))
+    {
+        qDebug() << "bad mapping file" << path;
+        return false;
+    }
+    qDebug("mapping file version %d.%d: %dx%d -> %dx%d, entry type %d", header.major_version, header.minor_version,
+           header.width_in, header.height_in, header.width_out, header.height_out, header.entry_type);
+
+    const RemapTable::Interpolation mode = (header.entry_type == BilinearEntries) ? RemapTable::Bilinear
+                                                                                  : RemapTable::NearestNeighbour;
+    const quint32 count = static_cast<quint32>(header.width_out) * header.height_out;
+    table->Reset(header.width_in, header.height_in, header.width_out, header.height_out, mode);
+    table->mTileOrder.resize(header.tile_count);
+
+    // the header ends at header_size, the fields a newer minor version adds are skipped.
+    quint32 crc = 0;
+    quint32 position = sizeof(header);
+    char skipped[RemapTableFile::kAlignment];
+    bool ok = true;
+    while (ok && position < header.header_size)
+    {
+        const quint32 size = qMin<quint32>(header.header_size - position, sizeof(skipped));
+        ok = file.read(skipped, size) == size;
+        position += size;
+    }
+    ok = ok && ReadSection(&file, &position, header.entries_offset, table->mEntries.data(),
+                           count * sizeof(qint32), &crc);
+    if (ok && header.fractions_offset != 0)
+    {
+        ok = ReadSection(&file, &position, header.fractions_offset, table->mFractions.data(), count, &crc);
+    }
+    if (ok && header.order_offset != 0)
+    {
+        ok = ReadSection(&file, &position, header.order_offset, table->mTileOrder.data(),
+                         header.tile_count * sizeof(qint32), &crc);
+    }
+    ok = ok && ReadSection(&file, &position, header.file_size, NULL, 0, &crc);
+    if (!ok || crc != header.crc32)
+    {
+        qDebug() << "mapping file checksum mismatch" << path;
+        table->Clear();
+        return false;
+    }
+
+    SwapWords(table->mEntries.data(), count);
+    SwapWords(table->mTileOrder.data(), header.tile_count);
+    if (!CheckTable(*table, header.tile_count))
+    {
+        qDebug() << "mapping file entries out of the source" << path;
+        table->Clear();
+        return false;
+    }
+    table->mOrder = static_cast<RemapTable::TraversalOrder>(header.traversal_order);
+    if (table->mTileOrder.isEmpty())
+    {
+        table->SetTraversalOrder(table->mOrder);
+    }
+    return true;
+}
+
+bool RemapTableFile::Map(const QString &path, RemapTable *table, int flags)
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    // the arrays are little-endian, they can not be used in place.
+    Q_UNUSED(flags);
+    return Read(path, table);
+#else
+    QSharedPointer<RemapTableMapping> mapping(new RemapTableMapping);
+    if (!mapping->Map(path, (flags & MapPopulate) != 0))
+    {
+        qDebug() << "can not map the mapping file" << path;
+        return false;
+    }
+    RemapTableFileHeader_t header;
+    if (mapping->Size() < static_cast<qint64>(sizeof(header)))
+    {
+        qDebug() << "bad mapping file" << path;
+        return false;
+    }
+    memcpy(&header, mapping->Data(), sizeof(header));
+    if (!CheckHeader(header, mapping->Size()))
+    {
+        qDebug() << "bad mapping file" << path;
+        return false;
+    }
+    const uchar *data = mapping->Data();
+    if ((flags & MapVerify) != 0
+            && Crc32(data + header.header_size, header.file_size - header.header_size) != header.crc32)
+    {
+        qDebug() << "mapping file checksum mismatch" << path;
+        return false;
+    }
+
+    // the sizes alone, Reset() would allocate the arrays the file already holds.
+    table->Clear();
+    table->mSrcWidth        = header.width_in;
+    table->mSrcHeight       = header.height_in;
+    table->mSrcStride       = header.src_stride;
+    table->mDstWidth        = header.width_out;
+    table->mDstHeight       = header.height_out;
+    table->mMode            = (header.entry_type == BilinearEntries) ? RemapTable::Bilinear
+                                                                     : RemapTable::NearestNeighbour;
+    table->mOrder           = static_cast<RemapTable::TraversalOrder>(header.traversal_order);
+    table->mMapping         = mapping;
+    table->mMappedEntries   = reinterpret_cast<const qint32 *>(data + header.entries_offset);
+    table->mMappedFractions = (header.fractions_offset != 0) ? data + header.fractions_offset : NULL;
+    table->mMappedOrder     = (header.order_offset != 0)
+                            ? reinterpret_cast<const qint32 *>(data + header.order_offset) : NULL;
+    if ((table->mMappedOrder != NULL && static_cast<int>(header.tile_count) != table->TileCount())
+            || ((flags & MapVerify) != 0 && !CheckTable(*table, header.tile_count)))
+    {
+        qDebug() << "mapping file entries out of the source" << path;
+        table->Clear();
+        return false;
+    }
+    if (table->mMappedOrder == NULL && table->mOrder != RemapTable::RowMajorOrder)
+    {
+        table->SetTraversalOrder(table->mOrder);
+    }
+    return true;
+#endif
+}
@@ -0,0 +1,95 @@
+#ifndef RemapTableFile_H
+#define RemapTableFile_H
+
+#include <QString>
+#include <QtGlobal>
+#include "RemapTable.h"
+
+/**
+ * the header of a version 2 mapping file, 64 bytes, little-endian.
+ * the payload follows it in sections aligned to kAlignment bytes:
+ * the entries (width_out x height_out qint32 source byte offsets into a
+ * RGB888 source of src_stride bytes per line, row by row), the bilinear
+ * fractions (one quint8 per entry) and the tile order (tile_count qint32),
+ * exactly the arrays RemapTable::Apply() reads. an offset is 0 when the
+ * section is not in the file. crc32 covers the bytes from header_size to
+ * file_size.
+ **/
+typedef struct RemapTableFileHeader
+{
+    quint32 magic_number;
+    quint16 major_version;
+    quint16 minor_version;
+    quint32 header_size;
+    quint32 file_size;
+    quint32 entry_type;
+    qint32  width_in;
+    qint32  height_in;
+    qint32  src_stride;
+    qint32  width_out;
+    qint32  height_out;
+    qint32  traversal_order;
+    quint32 entries_offset;
+    quint32 fractions_offset;
+    quint32 order_offset;
+    quint32 tile_count;
+    quint32 crc32;
+} RemapTableFileHeader_t;
+
+/**
+ * RemapTableFile : the version 2 mapping file, a RemapTable as it is in
+ * memory. Read() is one read per section and a checksum, Map() uses the
+ * mapped file in place, nothing is parsed entry by entry.
+ **/
+class RemapTableFile
+{
+public:
+    static const quint32 kMagicNumber   = 0x3243444c;  // "LDC2"
+    static const int     kMajorVersion  = 2;
+    static const int     kMinorVersion  = 0;
+    static const int     kAlignment     = 64;
+
+    // entry_type: the entries alone, or the entries and their fractions.
+    enum EntryType
+    {
+        NearestEntries  = 0,
+        BilinearEntries = 1
+    };
+
+    // Write() : only the RGB888 tables, the file has no pixel format.
+    static bool Write(const QString &path, const RemapTable &table);
+
+    /*
+     * Read() : the table of a version 2 file. return false when the file
+     * can not be read, is not a version 2 file, fails its checksum, or has
+     * an entry out of its source.
+     **/
+    static bool Read(const QString &path, RemapTable *table);
+
+    // the flags of Map().
+    enum MapFlag
+    {
+        MapVerify   = 0x1,  // check the crc and the entries, a pass over the whole table.
+        MapPopulate = 0x2   // fault the pages in now, not on the first frames.
+    };
+
+    /*
+     * Map() : map the file and use its arrays in place, table is the handle
+     * which keeps the file mapped, its Apply() never touches the file system.
+     * without MapVerify only the header is checked, keep it for the files
+     * this process wrote itself. a big-endian host falls back to Read().
+     **/
+    static bool Map(const QString &path, RemapTable *table, int flags = MapVerify);
+
+    /*
+     * IsVersion2() : the file starts with the version 2 magic number.
+     **/
+    static bool IsVersion2(const QString &path);
+
+    /*
+     * Crc32() : the IEEE 802.3 crc of size bytes, continued from crc.
+     **/
+    static quint32 Crc32(const void *data, qint64 size, quint32 crc = 0);
+};
+
+#endif // RemapTableFile_H
@@ -0,0 +1,204 @@
+#include "SurroundView.h"
+#include "CameraRegistry.h"
+#include "WorkerPool.h"
+
+#include <QAtomicInt>
+#include <QDebug>
+
+#include <limits>
+
+/**
+ * one camera of a set per work item, Apply() runs its tiles on the same
+ * pool, so a camera which is done early helps the others.
+ **/
+class SurroundJob : public WorkerPool::Job
+{
+public:
+    SurroundJob(const QVector<CorrectionContextPtr> &contexts, const QVector<QImage> &frames,
+                QVector<QImage> *images)
+        : mContexts(contexts),
+          mFrames(frames),
+          mImages(images),
+          mFailed(0)
+    {
+    }
+
+    void Run(int index)
+    {
+        if (!mContexts[index]->Apply(&mFrames[index], &(*mImages)[index]))
+        {
+            mFailed.ref();
+        }
+    }
+
+    bool Failed() const
+    {
+        return mFailed.load() != 0;
+    }
+
+private:
+    const QVector<CorrectionContextPtr> &mContexts;
+    const QVector<QImage>              &mFrames;
+    QVector<QImage>                    *mImages;
+    QAtomicInt                          mFailed;
+};
+
+SurroundView::SurroundView()
+    : mLastComplete(std::numeric_limits<qint64>::min()),
+      mDropped(0),
+      mMaxPending(4),
+      mOpen(false)
+{
+}
+
+bool SurroundView::Open(const QList<int> &cameras, int maxPending)
+{
+    Close();
+    if (cameras.isEmpty() || maxPending <= 0)
+    {
+        qDebug("surround view: %d cameras, %d pending", cameras.size(), maxPending);
+        return false;
+    }
+    for (int n = 0; n < cameras.size(); ++n)
+    {
+        if (CameraRegistry::getInstance()->Context(cameras[n]).isNull())
+        {
+            qDebug("surround view: camera %d is not registered", cameras[n]);
+            return false;
+        }
+    }
+
+    QMutexLocker locker(&mMutex);
+    mCameras        = cameras;
+    mMaxPending     = maxPending;
+    mLastComplete   = std::numeric_limits<qint64>::min();
+    mDropped        = 0;
+    mOpen           = true;
+    return true;
+}
+
+void SurroundView::Close()
+{
+    QMutexLocker locker(&mMutex);
+    mOpen = false;
+    mCameras.clear();
+    mPending.clear();
+    mReady.clear();
+}
+
+bool SurroundView::IsOpen() const
+{
+    QMutexLocker locker(&mMutex);
+    return mOpen;
+}
+
+QList<int> SurroundView::Cameras() const
+{
+    QMutexLocker locker(&mMutex);
+    return mCameras;
+}
+
+qint64 SurroundView::DroppedSets() const
+{
+    QMutexLocker locker(&mMutex);
+    return mDropped;
+}
+
+bool SurroundView::PushFrame(int camera, qint64 timestamp, const QImage &frame)
+{
+    QVector<QImage> frames;
+    {
+        QMutexLocker locker(&mMutex);
+        const int slot = mCameras.indexOf(camera);
+        if (!mOpen || slot < 0 || timestamp <= mLastComplete)
+        {
+            return false;
+        }
+
+        PendingSet_t &pending = mPending[timestamp];
+        if (pending.frames.isEmpty())
+        {
+            pending.frames.resize(mCameras.size());
+            pending.received = 0;
+        }
+        if (pending.frames[slot].isNull())
+        {
+            pending.received++;
+        }
+        pending.frames[slot] = frame;
+
+        if (pending.received < mCameras.size())
+        {
+            while (mPending.size() > mMaxPending)
+            {
+                mPending.erase(mPending.begin());
+                mDropped++;
+            }
+            return true;
+        }
+
+        // the set is complete, the older ones can not complete any more.
+        frames = pending.frames;
+        while (mPending.begin().key() != timestamp)
+        {
+            mPending.erase(mPending.begin());
+            mDropped++;
+        }
+        mPending.erase(mPending.begin());
+        mLastComplete = timestamp;
+    }
+
+    SurroundFrameSet_t set;
+    const bool ok = CorrectSet(timestamp, frames, &set);
+
+    QMutexLocker locker(&mMutex);
+    if (!ok)
+    {
+        mDropped++;
+        return false;
+    }
+    if (mOpen)
+    {
+        mReady.insert(timestamp, set);
+    }
+    return true;
+}
+
+bool SurroundView::CorrectSet(qint64 timestamp, const QVector<QImage> &frames, SurroundFrameSet_t *set)
+{
+    // the contexts of this set, a camera calibrated meanwhile applies from the next set.
+    const QList<int> cameras = Cameras();
+    QVector<CorrectionContextPtr> contexts(cameras.size());
+    for (int n = 0; n < cameras.size(); ++n)
+    {
+        contexts[n] = CameraRegistry::getInstance()->Context(cameras[n]);
+        if (contexts[n].isNull())
+        {
+            qDebug("surround view: camera %d is not registered", cameras[n]);
+            return false;
+        }
+    }
+    if (cameras.size() != frames.size())
+    {
+        return false;
+    }
+
+    set->timestamp  = timestamp;
+    set->cameras    = cameras;
+    set->images.resize(cameras.size());
+    SurroundJob job(contexts, frames, &set->images);
+    WorkerPool::getInstance()->Run(&job, cameras.size());
+    return !job.Failed();
+}
+
+bool SurroundView::TakeFrameSet(SurroundFrameSet_t *set)
+{
+    QMutexLocker locker(&mMutex);
+    if (mReady.isEmpty())
+    {
+        return false;
+    }
+    *set = mReady.begin().value();
+    mReady.erase(mReady.begin());
+    return true;
+}
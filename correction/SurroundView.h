@@ -0,0 +1,84 @@
+#ifndef SurroundView_H
+#define SurroundView_H
+
+#include <QImage>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QVector>
+#include "CorrectionContext.h"
+
+/**
+ * the corrected frames of one timestamp of a SurroundView, images[n] is
+ * the frame of cameras[n].
+ **/
+typedef struct SurroundFrameSet
+{
+    qint64              timestamp;
+    QList<int>          cameras;
+    QVector<QImage>     images;
+} SurroundFrameSet_t;
+
+/**
+ * SurroundView : the frames of several cameras (the CameraRegistry
+ * contexts) corrected together, timestamp by timestamp.
+ * PushFrame() keeps the frames of a timestamp until every camera has
+ * one, then the whole set is corrected in one WorkerPool::Run(), the
+ * cameras run side by side and share the idle workers, and the set is
+ * given by TakeFrameSet() in the timestamp order.
+ * a set completes only with the frames of its own timestamp, the older
+ * incomplete sets are dropped then, a camera which misses a frame never
+ * pairs the frames of two timestamps.
+ * the cameras can push from their own threads.
+ **/
+class SurroundView
+{
+public:
+    SurroundView();
+
+    /*
+     * Open() : the cameras of the view, they must be registered in the
+     * CameraRegistry. maxPending is the number of incomplete timestamps
+     * kept, the oldest one is dropped beyond it.
+     **/
+    bool    Open(const QList<int> &cameras, int maxPending = 4);
+    void    Close();
+    bool    IsOpen() const;
+
+    QList<int> Cameras() const;
+    // the timestamps dropped incomplete or failed.
+    qint64  DroppedSets() const;
+
+    /*
+     * PushFrame() : the frame of camera at timestamp. the call which
+     * completes a set corrects it before it returns.
+     * return false for an unknown camera, a timestamp already dropped
+     * or taken, or a correction error.
+     **/
+    bool    PushFrame(int camera, qint64 timestamp, const QImage &frame);
+
+    /*
+     * TakeFrameSet() : the oldest corrected set, false when there is none.
+     **/
+    bool    TakeFrameSet(SurroundFrameSet_t *set);
+
+private:
+    typedef struct PendingSet
+    {
+        QVector<QImage>     frames;
+        int                 received;
+    } PendingSet_t;
+
+    bool    CorrectSet(qint64 timestamp, const QVector<QImage> &frames, SurroundFrameSet_t *set);
+
+    mutable QMutex                  mMutex;
+    QList<int>                      mCameras;
+    QMap<qint64, PendingSet_t>      mPending;
+    QMap<qint64, SurroundFrameSet_t> mReady;
+    qint64                          mLastComplete;
+    qint64                          mDropped;
+    int                             mMaxPending;
+    bool                            mOpen;
+};
+
+#endif // SurroundView_H
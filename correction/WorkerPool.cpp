@@ -0,0 +1,304 @@
+#include "WorkerPool.h"
+
+#include <QThread>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+class WorkerThread : public QThread
+{
+public:
+    WorkerThread(WorkerPool *pool, int slot, int cpu)
+        : mPool(pool),
+          mSlot(slot),
+          mCpu(cpu)
+    {
+    }
+
+protected:
+    void run()
+    {
+#ifdef Q_OS_LINUX
+        if (mCpu >= 0)
+        {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(mCpu, &cpuSet);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0)
+            {
+                qDebug("worker %d: failed to set the affinity to cpu %d", mSlot, mCpu);
+            }
+        }
+#endif
+        mPool->WorkerLoop(mSlot);
+    }
+
+private:
+    WorkerPool *mPool;
+    int         mSlot;
+    int         mCpu;
+};
+
+/**
+ * one Run() call. every thread owns the range of its slot, the slot 0 is
+ * the calling thread. pending counts the items which are not finished yet.
+ **/
+struct WorkerPool::Batch
+{
+    struct Range
+    {
+        QMutex  mutex;
+        int     begin;
+        int     end;
+    };
+
+    WorkerPool::Job *job;
+    Range           *ranges;
+    int             rangeCount;
+    int             pending;
+    int             users;
+    bool            exhausted;
+};
+
+WorkerPool *WorkerPool::getInstance()
+{
+    static WorkerPool pool;
+    return &pool;
+}
+
+WorkerPool::WorkerPool()
+    : mQuit(false),
+      mAffinity(false),
+      mFirstCpu(0)
+{
+    SetThreadCount(0);
+}
+
+WorkerPool::~WorkerPool()
+{
+    StopWorkers();
+}
+
+void WorkerPool::SetThreadCount(int count)
+{
+    if (count <= 0)
+    {
+        count = qMax(1, QThread::idealThreadCount());
+    }
+    StopWorkers();
+    StartWorkers(count - 1);
+    qDebug("WorkerPool: %d threads", count);
+}
+
+int WorkerPool::ThreadCount() const
+{
+    QMutexLocker locker(&mMutex);
+    return mWorkers.size() + 1;
+}
+
+void WorkerPool::SetCpuAffinity(bool enable, int firstCpu)
+{
+#ifndef Q_OS_LINUX
+    if (enable)
+    {
+        qDebug("WorkerPool: cpu affinity is only supported on Linux");
+    }
+#endif
+    const int count = ThreadCount();
+    StopWorkers();
+    mAffinity = enable;
+    mFirstCpu = qMax(0, firstCpu);
+    StartWorkers(count - 1);
+}
+
+void WorkerPool::StartWorkers(int count)
+{
+    const int cpuCount = qMax(1, QThread::idealThreadCount());
+    QMutexLocker locker(&mMutex);
+    for (int n = 0; n < count; ++n)
+    {
+        const int cpu = mAffinity ? (mFirstCpu + n) % cpuCount : -1;
+        WorkerThread *worker = new WorkerThread(this, n + 1, cpu);
+        mWorkers.append(worker);
+        worker->start();
+    }
+}
+
+void WorkerPool::StopWorkers()
+{
+    QVector<WorkerThread *> workers;
+    {
+        QMutexLocker locker(&mMutex);
+        mQuit = true;
+        mWakeUp.wakeAll();
+        workers = mWorkers;
+        mWorkers.clear();
+    }
+    for (int n = 0; n < workers.size(); ++n)
+    {
+        workers[n]->wait();
+        delete workers[n];
+    }
+    QMutexLocker locker(&mMutex);
+    mQuit = false;
+}
+
+void WorkerPool::Run(Job *job, int count)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    const int threads = ThreadCount();
+    if (threads == 1 || count == 1)
+    {
+        for (int index = 0; index < count; ++index)
+        {
+            job->Run(index);
+        }
+        return;
+    }
+
+    Batch batch;
+    batch.job           = job;
+    batch.ranges        = new Batch::Range[threads];
+    batch.rangeCount    = threads;
+    batch.pending       = count;
+    batch.users         = 0;
+    batch.exhausted     = false;
+    for (int slot = 0; slot < threads; ++slot)
+    {
+        batch.ranges[slot].begin    = static_cast<int>(static_cast<qint64>(count) * slot / threads);
+        batch.ranges[slot].end      = static_cast<int>(static_cast<qint64>(count) * (slot + 1) / threads);
+    }
+
+    {
+        QMutexLocker locker(&mMutex);
+        mBatches.append(&batch);
+        mWakeUp.wakeAll();
+    }
+
+    ProcessBatch(&batch, 0);
+
+    // the workers may still run the items they took, wait for them.
+    QMutexLocker locker(&mMutex);
+    mBatches.removeOne(&batch);
+    while (batch.pending > 0 || batch.users > 0)
+    {
+        mDone.wait(&mMutex);
+    }
+    locker.unlock();
+    delete [] batch.ranges;
+}
+
+void WorkerPool::WorkerLoop(int slot)
+{
+    QMutexLocker locker(&mMutex);
+    while (!mQuit)
+    {
+        Batch *batch = NULL;
+        for (int n = 0; n < mBatches.size(); ++n)
+        {
+            if (!mBatches[n]->exhausted)
+            {
+                batch = mBatches[n];
+                break;
+            }
+        }
+        if (batch == NULL)
+        {
+            mWakeUp.wait(&mMutex);
+            continue;
+        }
+
+        batch->users++;
+        locker.unlock();
+        ProcessBatch(batch, slot);
+        locker.relock();
+        batch->users--;
+        if (batch->users == 0)
+        {
+            mDone.wakeAll();
+        }
+    }
+}
+
+void WorkerPool::ProcessBatch(Batch *batch, int slot)
+{
+    int finished    = 0;
+    int index       = 0;
+    while (TakeItem(batch, slot, &index))
+    {
+        batch->job->Run(index);
+        ++finished;
+    }
+
+    QMutexLocker locker(&mMutex);
+    batch->exhausted    = true;
+    batch->pending     -= finished;
+    if (batch->pending == 0)
+    {
+        mDone.wakeAll();
+    }
+}
+
+bool WorkerPool::TakeItem(Batch *batch, int slot, int *index)
+{
+    // a worker started after the Run() call has no range of its own.
+    Batch::Range *own = (slot < batch->rangeCount) ? &batch->ranges[slot] : NULL;
+    for (;;)
+    {
+        if (own != NULL)
+        {
+            QMutexLocker locker(&own->mutex);
+            if (own->begin < own->end)
+            {
+                *index = own->begin++;
+                return true;
+            }
+        }
+
+        // steal from the biggest range left.
+        int victim  = -1;
+        int most    = 0;
+        for (int n = 0; n < batch->rangeCount; ++n)
+        {
+            if (n == slot) continue;
+            QMutexLocker locker(&batch->ranges[n].mutex);
+            const int size = batch->ranges[n].end - batch->ranges[n].begin;
+            if (size > most)
+            {
+                most    = size;
+                victim  = n;
+            }
+        }
+        if (victim < 0)
+        {
+            return false;
+        }
+
+        // keep half of the victim range, or one item when this thread has no range.
+        int stolenBegin = 0;
+        int stolenEnd   = 0;
+        {
+            Batch::Range &range = batch->ranges[victim];
+            QMutexLocker locker(&range.mutex);
+            const int size = range.end - range.begin;
+            if (size <= 0) continue;
+            stolenEnd   = range.end;
+            stolenBegin = range.end - ((own != NULL) ? (size + 1) / 2 : 1);
+            range.end   = stolenBegin;
+        }
+        *index = stolenBegin;
+        if (own != NULL)
+        {
+            QMutexLocker locker(&own->mutex);
+            own->begin  = stolenBegin + 1;
+            own->end    = stolenEnd;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef WorkerPool_H
+#define WorkerPool_H
+
+#include <QList>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+class WorkerThread;
+
+/**
+ * WorkerPool : the persistent worker threads shared by all the remap passes.
+ * Run() splits the work items into one range per thread, an idle thread
+ * steals half of the biggest range left, and the calling thread works on
+ * its own range too, so Run() returns when every item is done.
+ * Run() can be called from several threads at the same time.
+ **/
+class WorkerPool
+{
+public:
+    /*
+     * Job : the work items of one Run(), Run(index) is called once
+     * for every index in [0, count), from any thread.
+     **/
+    class Job
+    {
+    public:
+        virtual ~Job() {}
+        virtual void Run(int index) = 0;
+    };
+
+    static  WorkerPool *getInstance();
+
+    /*
+     * SetThreadCount() : the number of threads working on a Run(), the
+     * calling thread included. 0 means QThread::idealThreadCount().
+     **/
+    void    SetThreadCount(int count);
+    int     ThreadCount() const;
+
+    /*
+     * SetCpuAffinity() : pin the worker n to the cpu (firstCpu + n).
+     * only supported on Linux, ignored on the other platforms.
+     **/
+    void    SetCpuAffinity(bool enable, int firstCpu = 0);
+
+    void    Run(Job *job, int count);
+
+private:
+    friend class WorkerThread;
+    struct Batch;
+
+    WorkerPool();
+    ~WorkerPool();
+
+    void    StartWorkers(int count);
+    void    StopWorkers();
+    void    WorkerLoop(int slot);
+    void    ProcessBatch(Batch *batch, int slot);
+    bool    TakeItem(Batch *batch, int slot, int *index);
+
+    mutable QMutex          mMutex;
+    QWaitCondition          mWakeUp;
+    QWaitCondition          mDone;
+    QList<Batch *>          mBatches;
+    QVector<WorkerThread *> mWorkers;
+    bool                    mQuit;
+    bool                    mAffinity;
+    int                     mFirstCpu;
+};
+
+#endif // WorkerPool_H
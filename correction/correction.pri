@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# link the correction library, include it from the .pro of the target:
+#     include(../correction/correction.pri)
+#
+#-------------------------------------------------
+
+INCLUDEPATH += $$PWD
+DEPENDPATH  += $$PWD
+
+CORRECTION_OUT = $$OUT_PWD/../correction
+win32 {
+    CONFIG(debug, debug|release): CORRECTION_OUT = $$CORRECTION_OUT/debug
+    else: CORRECTION_OUT = $$CORRECTION_OUT/release
+}
+
+LIBS += -L$$CORRECTION_OUT -lcorrection
+
+win32-g++|!win32: PRE_TARGETDEPS += $$CORRECTION_OUT/libcorrection.a
+else: PRE_TARGETDEPS += $$CORRECTION_OUT/correction.lib
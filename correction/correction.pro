@@ -0,0 +1,59 @@
+#-------------------------------------------------
+#
+# correction: the lens distortion correction and the remap tables,
+# a static library without any widget.
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+TARGET = correction
+TEMPLATE = lib
+CONFIG += staticlib
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# the SIMD circle kernels give the floats of the scalar one only without fused multiply-adds.
+!msvc: QMAKE_CXXFLAGS += -ffp-contract=off
+
+SOURCES += \
+    BatchPipeline.cpp \
+    CameraRegistry.cpp \
+    CircleKernel.cpp \
+    CorrectionContext.cpp \
+    CorrectionPreview.cpp \
+    CorrectionSession.cpp \
+    DebugOutput.cpp \
+    FisheyeDistortionCorrection.cpp \
+    Nv12Frame.cpp \
+    Process3Stages.cpp \
+    RemapNv12Table.cpp \
+    RemapTable.cpp \
+    RemapTableCache.cpp \
+    RemapTableFile.cpp \
+    RemapKernel.cpp \
+    RemapSpanTable.cpp \
+    RemapSymmetricTable.cpp \
+    SurroundView.cpp \
+    WorkerPool.cpp
+
+HEADERS += \
+    BatchPipeline.h \
+    CameraRegistry.h \
+    CircleKernel.h \
+    CorrectionContext.h \
+    CorrectionPreview.h \
+    CorrectionSession.h \
+    DebugOutput.h \
+    FisheyeDistortionCorrection.h \
+    Nv12Frame.h \
+    Process3Stages.h \
+    RemapNv12Table.h \
+    RemapTable.h \
+    RemapTableCache.h \
+    RemapTableFile.h \
+    RemapKernel.h \
+    RemapSpanTable.h \
+    RemapSymmetricTable.h \
+    SurroundView.h \
+    WorkerPool.h
@@ -2,35 +2,26 @@
 #
 # Project created by QtCreator 2017-09-24T16:22:53
 #
+# correction: the correction library, linked by all the other targets.
+# app:        the Qt Widgets tool.
+# cli:        the batch correction without the GUI.
+# benchmark:  the headless benchmarks.
+#
 #-------------------------------------------------
 
-QT       += core gui
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-TARGET = fisheye_distortion
-TEMPLATE = app
-
-# The following define makes your compiler emit warnings if you use
-# any feature of Qt which as been marked as deprecated (the exact warnings
-# depend on your compiler). Please consult the documentation of the
-# deprecated API in order to know how to port your code away from it.
-DEFINES += QT_DEPRECATED_WARNINGS
-
-# You can also make your code fail to compile if you use deprecated APIs.
-# In order to do so, uncomment the following line.
-# You can also select to disable deprecated APIs only up to a certain version of Qt.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
+TEMPLATE = subdirs
 
-SOURCES += \
-        main.cpp \
-        mainwindow.cpp \
-    FisheyeDistortionCorrection.cpp
+SUBDIRS += \
+    correction \
+    app \
+    cli \
+    remap_benchmark \
+    correction_benchmark
 
-HEADERS += \
-        mainwindow.h \
-    FisheyeDistortionCorrection.h
+remap_benchmark.file        = benchmark/remap_benchmark.pro
+correction_benchmark.file   = benchmark/correction_benchmark.pro
 
-FORMS += \
-        mainwindow.ui
+app.depends                 = correction
+cli.depends                 = correction
+remap_benchmark.depends     = correction
+correction_benchmark.depends = correction